@@ -3,93 +3,140 @@
 #include "info.h"
 #include "event.h"
 #include <torch/torch.h>
+#include <algorithm>
+#include <tuple>
 
-AIRL::AIRL(PokerNet& n, torch::optim::Optimizer& opt) 
-  : net(n), optimizer(opt) 
+AIRL::AIRL(PokerNet& n) 
+  : net(n), broker(nullptr), my_id(-1) 
 {
   reset_history();
 } // end of constructor
 
+AIRL::AIRL(PokerNet& n, const std::function<void(Trajectory&)>& on_trajectory, InferenceBroker* broker)
+  : net(n), on_trajectory(on_trajectory), broker(broker), my_id(-1)
+{
+  reset_history();
+} // end of learning constructor
+
 void AIRL::reset_history() 
 {
-  history_head = nullptr;
-  history_tail = nullptr;
+  history.reset();
+  history_fed = 0;
   // initialize hidden states for the lstm
-  h_state = torch::zeros({1, 1, 128});
-  c_state = torch::zeros({1, 1, 128});
-  hand_experiences.clear();
+  std::tie(h_state, c_state) = net->initial_state();
+  trajectory.steps.clear();
+  chips_committed = 0;
+  chips_won = 0;
+  big_blind = 1;
 } // end of reset_history
 
 void AIRL::add_to_history(int cmd, float amt, int pos) 
 {
-  auto new_node = std::make_shared<ActionNode>(cmd, amt, pos);
-  if (!history_head) {
-    history_head = new_node;
-    history_tail = new_node;
-  } else {
-    history_tail->next = new_node;
-    history_tail = new_node;
-  }
+  history.push(cmd, amt, pos);
 } // end of add_to_history
 
 
 torch::Tensor AIRL::history_to_tensor() 
 {
-  std::vector<float> data;
-  int len = 0;
-  auto curr = history_head;
-  while (curr) {
-    data.push_back((float)curr->command / 3.0f);
-    data.push_back(curr->amount_norm);
-    data.push_back((float)curr->player_pos / 9.0f);
-    len++;
-    curr = curr->next;
-  }
-  
   // if no history, provide a "zero" action node to keep dimensions consistent
-  if (len == 0) return torch::zeros({1, 1, 3});
-  
-  // create tensor [len, 1, 3]
-  return torch::from_blob(data.data(), {len, 1, 3}, torch::kFloat).clone();
+  return GraphConverter::historyToTensor(history);
 }
 
-Action AIRL::doTurn(const Info& info) 
+torch::Tensor AIRL::policy(const torch::Tensor& state)
 {
-  torch::Tensor state = TensorConverter::infoToTensor(info);
-  torch::Tensor hist = history_to_tensor();
-  torch::Tensor opp = torch::zeros({1, 10});
+  // only the actions since the previous decision go through the lstm, h_state and c_state hold the rest
+  torch::Tensor new_actions = history.view(history_fed);
 
-  // 1. forward pass through the graph rnn
-  torch::Tensor out_vec = net->forward_with_history(state, hist, opp);
-  
-  // 2. stochastic exploration (reparameterization)
-  float noise_scale = 0.1f; 
-  auto sampled_vec = out_vec + torch::randn_like(out_vec) * noise_scale;
+  // before the first action of the deal, use the same zero action as history_to_tensor does, but don't
+  // keep the state it gives, the first real action must start from the initial state
+  bool nothing_yet = history.size() == 0;
+  if (nothing_yet) new_actions = torch::zeros({1, 1, 3});
 
-  // 3. calculate log_prob for the policy gradient
-  auto log_prob = -0.5 * torch::pow((sampled_vec - out_vec) / noise_scale, 2).sum();
+  torch::Tensor out_vec;
+  PokerNetImpl::State new_state;
+  torch::Tensor opp = torch::zeros({1, 10});
+  if (broker) {
+    InferenceResult result = broker->submit(state, new_actions, PokerNetImpl::State(h_state, c_state)).get();
+    out_vec = result.out;
+    new_state = PokerNetImpl::State(result.h, result.c);
+  } else if (new_actions.size(0) == 0) {
+    out_vec = net->forward_from_hidden(state, h_state[-1], opp);
+    new_state = PokerNetImpl::State(h_state, c_state);
+  } else {
+    std::tie(out_vec, new_state) = net->forward_step(state, new_actions, opp, PokerNetImpl::State(h_state, c_state));
+  }
 
-  hand_experiences.push_back({log_prob, static_cast<float> (info.getStack() )});
+  if (!nothing_yet) {
+    std::tie(h_state, c_state) = new_state;
+    history_fed = history.size();
+  }
+  return out_vec;
+} // end of policy
 
-  return TensorConverter::vectorToAction(info, sampled_vec[0][0].item<float>(), sampled_vec[0][1].item<float>());
+Action AIRL::doTurn(const Info& info) 
+{
+  // the agent only plays, the learner recomputes the log probabilities itself, so no autograd graph is needed here
+  torch::NoGradGuard no_grad;
+  torch::Tensor state = TensorConverter::infoToTensor(info).contiguous();
+
+  // 1. forward pass through the graph rnn, continuing from the previous decision of this hand
+  torch::Tensor out_vec = policy(state);
+
+  // 2. stochastic exploration
+  torch::Tensor sampled_vec = out_vec + torch::randn_like(out_vec) * NOISE_SCALE;
+  Action action = TensorConverter::vectorToAction(info, sampled_vec[0][0].item<float>(), sampled_vec[0][1].item<float>());
+  if (!on_trajectory) return action;
+
+  // 3. remember the decision for the learner
+  torch::Tensor hist = history_to_tensor().contiguous(); // the learner uses the whole history
+  TrajectoryStep step;
+  step.state.assign(state.data_ptr<float>(), state.data_ptr<float>() + state.numel());
+  step.history.assign(hist.data_ptr<float>(), hist.data_ptr<float>() + hist.numel());
+  step.mean[0] = out_vec[0][0].item<float>();
+  step.mean[1] = out_vec[0][1].item<float>();
+  step.action[0] = sampled_vec[0][0].item<float>();
+  step.action[1] = sampled_vec[0][1].item<float>();
+  trajectory.steps.push_back(step);
+
+  int moved = 0;
+  if (action.command == A_CALL) moved = std::min(info.getCallAmount(), info.getStack());
+  else if (action.command == A_RAISE) moved = std::min(action.amount, info.getStack());
+  chips_committed = info.getWager() + moved;
+  big_blind = std::max(1, info.getBigBlind());
+
+  return action;
 } // end of doturn
-//
 
 
+void AIRL::end_hand()
+{
+  if (!on_trajectory || trajectory.steps.empty()) return; // folded without ever deciding, e.g. in the blinds
+
+  trajectory.reward = (float)(chips_won - chips_committed) / (float)big_blind;
+  on_trajectory(trajectory);
+  trajectory.steps.clear();
+  chips_committed = 0;
+  chips_won = 0;
+} // end of end_hand
+
 void AIRL::onEvent(const Event& event) {
+    if (event.type == E_RECEIVE_CARDS) {
+        my_id = event.playerId;
+    }
+
+    if (event.type == E_WIN && event.playerId == my_id) {
+        chips_won += event.chips;
+    }
+
     // track history
     if (event.type == E_RAISE || event.type == E_CALL || event.type == E_CHECK || event.type == E_FOLD) {
         add_to_history((int)event.type, (float)event.chips / 100.0f, 0); 
     }
     
     if (event.type == E_NEW_DEAL) {
+        end_hand(); // in case whoever runs the game didn't, the E_WIN events of the previous deal are all in
         reset_history();
     }
-
-    // placeholder for rl update logic
-    if (event.type == E_POT_DIVISION) {
-        // update logic here
-    }
 }
 
 std::string AIRL::getAIName() {
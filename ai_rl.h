@@ -1,16 +1,28 @@
 #pragma once
 #include "ai.h"
 #include <torch/torch.h>
+#include <functional>
 #include <memory>
+#include <string>
 #include <vector>
 #include "info.h"
 #include "action.h"
-#include "converter.h" // ActionNode and TensorConverter are here
+#include "converter.h" // ActionHistory and TensorConverter are here
+#include "inference.h"
 #include "poker_net.h"
+#include "trajectory.h"
 
 class AIRL: public AI {
 public:
-    AIRL(PokerNet& n, torch::optim::Optimizer& opt);
+    static constexpr const float NOISE_SCALE = 0.1f; // std of the gaussian exploration noise on the output vector
+
+    // only plays, e.g. for evaluation
+    explicit AIRL(PokerNet& n);
+
+    // learning mode: every finished deal is handed to on_trajectory, usually for Learner::add (see learner.h).
+    // a deal ends at the next E_NEW_DEAL, or earlier if the one running the game calls end_hand.
+    // with a broker, the decisions are batched with those of other agents (see inference.h) instead of using n.
+    AIRL(PokerNet& n, const std::function<void(Trajectory&)>& on_trajectory, InferenceBroker* broker = nullptr);
     
     // --- Overrides for the AI Interface ---
     Action doTurn(const Info& info) override;
@@ -23,20 +35,25 @@ public:
     void reset_history();
     void add_to_history(int cmd, float amt, int pos);
     torch::Tensor history_to_tensor();
+    torch::Tensor policy(const torch::Tensor& state); // the output vector of the net for this decision
+    void end_hand(); // computes the reward of the deal that just ended and passes on its trajectory
 
 private:
     PokerNet& net;
-    torch::optim::Optimizer& optimizer;
     
-    std::shared_ptr<ActionNode> history_head;
-    std::shared_ptr<ActionNode> history_tail;
+    ActionHistory history;
+    int history_fed; // amount of actions of history that h_state and c_state include
     
+    // lstm state after the first history_fed actions, carried from decision to decision within a hand
     torch::Tensor h_state;
     torch::Tensor c_state;
     
-    struct Experience {
-        torch::Tensor log_prob;
-        float stack;
-    };
-    std::vector<Experience> hand_experiences;
+    // learning mode
+    std::function<void(Trajectory&)> on_trajectory;
+    InferenceBroker* broker;
+    Trajectory trajectory;
+    int my_id; // name id (see nametable.h) learned from E_RECEIVE_CARDS, to recognize our own E_WIN events
+    int chips_committed; // our wager after our last decision of this deal
+    int chips_won;
+    int big_blind;
 };
@@ -0,0 +1,199 @@
+/*
+OOPoker
+
+Copyright (c) 2010 Lode Vandevenne
+All rights reserved.
+
+This file is part of OOPoker.
+
+OOPoker is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+OOPoker is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with OOPoker.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include "buckets.h"
+
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+
+#include "info.h"
+#include "isomorphism.h"
+#include "mappedfile.h"
+
+namespace
+{
+  struct BucketRoundHeader
+  {
+    unsigned buckets;
+    unsigned padding;
+    unsigned long long entries;
+  };
+
+  struct BucketHeader
+  {
+    char magic[4];
+    unsigned version;
+    unsigned checksum;
+    unsigned padding;
+    BucketRoundHeader rounds[BUCKET_ROUNDS];
+  };
+
+  std::mutex bucketMutex; //for loading and unloading, the lookups don't lock
+  std::string bucketFilePath = "buckets.dat";
+  //the file is only tried once, the first time it's needed. Set after loading, so that once a lookup sees it
+  //true it can read bucketEntries and bucketAmount without the mutex.
+  std::atomic<bool> bucketFileTried(false);
+  MappedFile bucketFile;
+  const unsigned char* bucketEntries[BUCKET_ROUNDS] = { 0 }; //point into bucketFile, 0 if the round isn't available
+  int bucketAmount[BUCKET_ROUNDS] = { 0 };
+}
+
+static const char BUCKETS_MAGIC[4] = { 'O', 'O', 'B', 'K' };
+static const unsigned BUCKETS_VERSION = 1;
+
+//must be called with bucketMutex locked
+static void unloadBucketTableLocked()
+{
+  std::fill(bucketEntries, bucketEntries + BUCKET_ROUNDS, (const unsigned char*)0);
+  std::fill(bucketAmount, bucketAmount + BUCKET_ROUNDS, 0);
+  bucketFile.close();
+}
+
+//must be called with bucketMutex locked
+static bool loadBucketTableLocked(const std::string& filename)
+{
+  unloadBucketTableLocked();
+
+  if(!bucketFile.open(filename)) return false;
+  if(bucketFile.getSize() < sizeof(BucketHeader)) { bucketFile.close(); return false; }
+
+  const BucketHeader* header = (const BucketHeader*)bucketFile.getData();
+  const unsigned char* entries = bucketFile.getData() + sizeof(BucketHeader);
+
+  bool valid = std::equal(header->magic, header->magic + 4, BUCKETS_MAGIC) && header->version == BUCKETS_VERSION;
+  size_t size = 0;
+  for(int r = 0; r < BUCKET_ROUNDS && valid; r++)
+  {
+    const BucketRoundHeader& round = header->rounds[r];
+    if(round.entries != 0 && (round.entries != getCanonicalSize((Round)r) || round.buckets == 0 || round.buckets > (unsigned)MAX_BUCKETS)) valid = false;
+    size += round.entries;
+  }
+  valid = valid && bucketFile.getSize() == sizeof(BucketHeader) + size && header->checksum == getDataChecksum(entries, size);
+
+  if(!valid)
+  {
+    bucketFile.close();
+    return false;
+  }
+
+  for(int r = 0; r < BUCKET_ROUNDS; r++)
+  {
+    if(header->rounds[r].entries != 0)
+    {
+      bucketEntries[r] = entries;
+      bucketAmount[r] = header->rounds[r].buckets;
+    }
+    entries += header->rounds[r].entries;
+  }
+  return true;
+}
+
+static void tryLoadBucketTable()
+{
+  if(bucketFileTried.load(std::memory_order_acquire)) return;
+  std::lock_guard<std::mutex> lock(bucketMutex);
+  if(bucketFileTried.load(std::memory_order_relaxed)) return; //another thread loaded it meanwhile
+  loadBucketTableLocked(bucketFilePath);
+  bucketFileTried.store(true, std::memory_order_release);
+}
+
+int getBucket(const std::vector<Card>& holeCards, const std::vector<Card>& boardCards)
+{
+  if(holeCards.size() != 2) return -1;
+  size_t numBoard = boardCards.size();
+  if(numBoard != 0 && numBoard != 3 && numBoard != 4 && numBoard != 5) return -1;
+  Round round = getRoundForBoardSize((int)numBoard);
+
+  tryLoadBucketTable();
+  const unsigned char* entries = bucketEntries[round];
+  if(!entries) return -1;
+  return entries[getCanonicalIndex(holeCards, boardCards)];
+}
+
+int getBucket(const Info& info)
+{
+  return getBucket(info.getHoleCards(), info.boardCards);
+}
+
+int getNumBuckets(Round round)
+{
+  if(round < 0 || round >= BUCKET_ROUNDS) return 0;
+  tryLoadBucketTable();
+  return bucketAmount[round];
+}
+
+void setBucketFilePath(const std::string& path)
+{
+  std::lock_guard<std::mutex> lock(bucketMutex);
+  bucketFileTried.store(false, std::memory_order_release);
+  bucketFilePath = path;
+  unloadBucketTableLocked();
+}
+
+bool loadBucketTable(const std::string& filename)
+{
+  std::lock_guard<std::mutex> lock(bucketMutex);
+  bucketFileTried.store(false, std::memory_order_release);
+  bool loaded = loadBucketTableLocked(filename);
+  bucketFileTried.store(true, std::memory_order_release);
+  return loaded;
+}
+
+void unloadBucketTable()
+{
+  std::lock_guard<std::mutex> lock(bucketMutex);
+  bucketFileTried.store(false, std::memory_order_release);
+  unloadBucketTableLocked();
+  bucketFileTried.store(true, std::memory_order_release);
+}
+
+bool writeBucketTable(const std::string& filename, const std::vector<unsigned char>* buckets, const int* numBuckets)
+{
+  BucketHeader header;
+  std::copy(BUCKETS_MAGIC, BUCKETS_MAGIC + 4, header.magic);
+  header.version = BUCKETS_VERSION;
+  header.padding = 0;
+
+  size_t size = 0;
+  for(int r = 0; r < BUCKET_ROUNDS; r++)
+  {
+    if(!buckets[r].empty() && (buckets[r].size() != getCanonicalSize((Round)r) || numBuckets[r] < 1 || numBuckets[r] > MAX_BUCKETS)) return false;
+    header.rounds[r].buckets = buckets[r].empty() ? 0 : numBuckets[r];
+    header.rounds[r].padding = 0;
+    header.rounds[r].entries = buckets[r].size();
+    size += buckets[r].size();
+  }
+
+  std::vector<unsigned char> data(sizeof(header) + size);
+  size_t pos = sizeof(header);
+  for(int r = 0; r < BUCKET_ROUNDS; r++)
+  {
+    std::copy(buckets[r].begin(), buckets[r].end(), data.begin() + pos);
+    pos += buckets[r].size();
+  }
+  header.checksum = getDataChecksum(data.data() + sizeof(header), size);
+  std::copy((const unsigned char*)&header, (const unsigned char*)&header + sizeof(header), data.begin());
+
+  return writeFileAtomic(filename, &data[0], data.size());
+}
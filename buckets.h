@@ -0,0 +1,71 @@
+/*
+OOPoker
+
+Copyright (c) 2010 Lode Vandevenne
+All rights reserved.
+
+This file is part of OOPoker.
+
+OOPoker is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+OOPoker is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with OOPoker.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#pragma once
+
+/*
+Card abstraction: every hand (your hole cards together with the board) is put in a bucket of hands
+that play alike, so that an AI or the feature vector of the RL AI can use a small bucket number instead
+of the raw cards.
+
+The buckets are made offline by the gen_buckets tool, which clusters the hands of each round by their
+hand strength distribution, and written to a table file with one byte per suit-isomorphic state (see
+isomorphism.h). Bucket 0 is the weakest bucket of its round, higher buckets are on average stronger.
+
+The table (default name "buckets.dat") is memory-mapped the first time a bucket is asked for. Looking up
+a bucket is then only computing the canonical index, without locking, so the tables of the self-play
+arena don't wait for each other. If there's no table, or the round isn't in it, getBucket returns -1.
+setBucketFilePath, loadBucketTable and unloadBucketTable must not be called while other threads look up
+buckets.
+
+File format (little endian):
+-4 bytes "OOBK", 4 bytes version, 4 bytes checksum of the buckets, 4 bytes padding
+-per round (pre-flop, flop, turn, river): 4 bytes amount of buckets, 4 bytes padding, 8 bytes amount of
+ entries. The amount of entries is either getCanonicalSize(round), or 0 if the round isn't in the table.
+-the entries of the rounds after each other: one byte bucket per canonical index
+*/
+
+#include <string>
+#include <vector>
+
+#include "card.h"
+#include "rules.h"
+
+class Info;
+
+const int MAX_BUCKETS = 256;
+const int BUCKET_ROUNDS = 4;
+
+int getBucket(const std::vector<Card>& holeCards, const std::vector<Card>& boardCards);
+int getBucket(const Info& info); //your own hand at the current round
+int getNumBuckets(Round round); //0 if the round isn't available
+
+void setBucketFilePath(const std::string& path);
+bool loadBucketTable(const std::string& filename); //returns false if the file doesn't exist or is invalid
+void unloadBucketTable();
+
+/*
+buckets has the entries of each round (empty for a round that isn't computed), numBuckets the amount of
+buckets of each round (at most MAX_BUCKETS).
+*/
+bool writeBucketTable(const std::string& filename, const std::vector<unsigned char>* buckets /*BUCKET_ROUNDS*/, const int* numBuckets /*BUCKET_ROUNDS*/);
@@ -18,11 +18,8 @@ void CheckpointManager::run_evaluation(PokerNet& net, int epoch) {
     HostTerminal host;
     Game eval_game(&host);
     
-    // create a dummy optimizer for the constructor
-    torch::optim::Adam dummy_opt(net->parameters(), 1e-4);
-    
     // test bot vs a smart baseline
-    AIRL* test_bot = new AIRL(net, dummy_opt);
+    AIRL* test_bot = new AIRL(net);
     AISmart* baseline = new AISmart(0.5);
 
     eval_game.addPlayer(Player(test_bot, "EvalBot"));
@@ -6,15 +6,42 @@
 #include "card.h"
 
 
-struct ActionNode {
-    int command;
-    float amount_norm;
-    int player_pos;
-    std::shared_ptr<ActionNode> next;
+// the betting actions of one hand as the rnn input: 3 floats per action (command, amount, position),
+// stored contiguously in a fixed buffer so adding an action never allocates, reset for a new hand is
+// O(1) and the rnn input is a view on the buffer instead of a copy.
+class ActionHistory {
+public:
+    static constexpr const int CAPACITY = 256; // actions per hand, more than this are not recorded
+    static constexpr const int FEATURES = 3;
+
+    ActionHistory() : length(0), dropped(0) {}
+
+    void reset() { length = 0; dropped = 0; }
+
+    void push(int cmd, float amt, int pos) {
+        if (length == CAPACITY) { dropped++; return; }
+        float* f = buffer + length * FEATURES;
+        f[0] = (float)cmd / 3.0f;
+        f[1] = amt;
+        f[2] = (float)pos / 9.0f;
+        length++;
+    }
 
-    ActionNode(int cmd, float amt, int pos) 
-        : command(cmd), amount_norm(amt), player_pos(pos), next(nullptr) {}
-}; // end of actionnode
+    int size() const { return length; }
+    int get_dropped() const { return dropped; } // actions not recorded because the buffer was full
+    const float* data() const { return buffer; }
+
+    // [size - from, 1, 3] tensor sharing the memory of the buffer (no copy). it stays valid while actions
+    // are added, but not after reset, so clone it if it must outlive the hand.
+    torch::Tensor view(int from = 0) const {
+        return torch::from_blob(const_cast<float*>(buffer + from * FEATURES), {(int64_t)(length - from), 1, FEATURES}, torch::kFloat);
+    }
+
+private:
+    alignas(64) float buffer[CAPACITY * FEATURES];
+    int length;
+    int dropped;
+}; // end of actionhistory
 
 
 class TensorConverter {
@@ -41,19 +68,9 @@ private:
 
 class GraphConverter {
 public:
-    // converts the shared_ptr list into a sequence tensor for the RNN
-    static torch::Tensor historyToTensor(std::shared_ptr<ActionNode> head) {
-        std::vector<float> data;
-        int len = 0;
-        auto curr = head;
-        while (curr) {
-            data.push_back((float)curr->command / 3.0f);
-            data.push_back(curr->amount_norm);
-            data.push_back((float)curr->player_pos / 9.0f);
-            len++;
-            curr = curr->next;
-        }
-        if (len == 0) return torch::zeros({1, 1, 3});
-        return torch::from_blob(data.data(), {len, 1, 3}, torch::kFloat).clone();
+    // the history as sequence tensor for the RNN, with a single zero action if it's empty
+    static torch::Tensor historyToTensor(const ActionHistory& history) {
+        if (history.size() == 0) return torch::zeros({1, 1, ActionHistory::FEATURES});
+        return history.view();
     } // end of historytotensor
 };
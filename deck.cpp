@@ -29,23 +29,34 @@ Deck::Deck()
   for(size_t i = 0; i < 52; i++) cards[i].setIndex(i);
 }
 
-void Deck::shuffle()
+template<typename Generator>
+static void shuffleCards(Card* cards, Generator& generator)
 {
-  index = 0;
-
   Card old[52];
   for(size_t i = 0; i < 52; i++) old[i] = cards[i];
 
   //Fisher-Yates shuffle
   for(size_t i = 0; i < 52; i++)
   {
-    int r = (int)(getRandom() * (52 - i));
+    int r = getBoundedRandom(generator, 0, 51 - i);
     cards[i] = old[r];
     std::swap(old[r], old[(52 - 1 - i)]);
 
   }
 }
 
+void Deck::shuffle()
+{
+  index = 0;
+  shuffleCards(cards, getThreadSecureRandom());
+}
+
+void Deck::shuffle(RandomStream& random)
+{
+  index = 0;
+  shuffleCards(cards, random);
+}
+
 Card Deck::next()
 {
   if(index >= 52) return Card();
@@ -25,6 +25,14 @@ along with OOPoker.  If not, see <http://www.gnu.org/licenses/>.
 #include "card.h"
 
 
+class RandomStream;
+
+enum ShuffleMode
+{
+  SHUFFLE_SECURE, //with the secure random generator of random.h, seeded by the operating system
+  SHUFFLE_FAST //with a seeded RandomStream: faster, and the same seed gives the same deals again, e.g. for batch runs
+};
+
 class Deck
 {
   /*
@@ -40,6 +48,7 @@ class Deck
   public:
 
     Deck();
-    void shuffle();
+    void shuffle(); //SHUFFLE_SECURE
+    void shuffle(RandomStream& random); //SHUFFLE_FAST
     Card next(); //never call this more than 52 times in a row.
 };
@@ -0,0 +1,516 @@
+/*
+OOPoker
+
+Copyright (c) 2010 Lode Vandevenne
+All rights reserved.
+
+This file is part of OOPoker.
+
+OOPoker is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+OOPoker is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with OOPoker.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "equity.h"
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <mutex>
+#include <unordered_map>
+
+#include "isomorphism.h"
+#include "mappedfile.h"
+#include "pokermath.h"
+#include "random.h"
+
+EquitySettings::EquitySettings()
+: epsilon(0.01)
+, preFlopEpsilon(0.002)
+, minSamples(1000)
+, maxSamples(50000)
+, batchSamples(500)
+, maxCacheEntries(1000000)
+{
+}
+
+EquityStats::EquityStats()
+: hits(0)
+, misses(0)
+, samples(0)
+, entries(0)
+{
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+namespace
+{
+  const int MAXOPPONENTS = 9;
+  const int PREFLOP_MAXSAMPLES = 2000000; //upper bound for the pre-flop table, which uses preFlopEpsilon instead of epsilon
+
+  struct EquityResult
+  {
+    float win;
+    float tie;
+    float lose;
+    float equity;
+  };
+
+  struct PreFlopEntry
+  {
+    EquityResult result;
+    bool done;
+  };
+
+  struct PreFlopEquityHeader
+  {
+    char magic[4];
+    unsigned version;
+    unsigned hands;
+    unsigned opponents;
+    unsigned values;
+    unsigned exactOpponents;
+    unsigned long long samples;
+    unsigned checksum;
+    unsigned padding;
+  };
+
+  std::mutex equityMutex;
+  EquitySettings equitySettings;
+  EquityStats equityStats;
+  std::unordered_map<unsigned long long, EquityResult> equityCache;
+  PreFlopEntry preFlopTable[169][MAXOPPONENTS];
+
+  std::string preFlopEquityFilePath = "preflop_equity.dat";
+  bool preFlopFileTried = false; //the file is only tried once, the first time it's needed
+  MappedFile preFlopFile;
+  const float* preFlopFileValues = 0; //points into preFlopFile if it's loaded and valid
+}
+
+static const char PREFLOPEQUITY_MAGIC[4] = { 'O', 'O', 'P', 'F' };
+static const unsigned PREFLOPEQUITY_VERSION = 1;
+static const size_t PREFLOPEQUITY_NUMVALUES = PREFLOP_EQUITY_HANDS * PREFLOP_EQUITY_OPPONENTS * PREFLOP_EQUITY_VALUES;
+
+//must be called with equityMutex locked
+static bool loadPreFlopEquityTableLocked(const std::string& filename)
+{
+  preFlopFileValues = 0;
+  preFlopFile.close();
+
+  if(!preFlopFile.open(filename)) return false;
+
+  const PreFlopEquityHeader* header = (const PreFlopEquityHeader*)preFlopFile.getData();
+  const float* values = (const float*)(preFlopFile.getData() + sizeof(PreFlopEquityHeader));
+  size_t valuesSize = PREFLOPEQUITY_NUMVALUES * sizeof(float);
+
+  if(preFlopFile.getSize() != sizeof(PreFlopEquityHeader) + valuesSize
+  || !std::equal(header->magic, header->magic + 4, PREFLOPEQUITY_MAGIC)
+  || header->version != PREFLOPEQUITY_VERSION
+  || header->hands != PREFLOP_EQUITY_HANDS
+  || header->opponents != PREFLOP_EQUITY_OPPONENTS
+  || header->values != PREFLOP_EQUITY_VALUES
+  || header->checksum != getDataChecksum(values, valuesSize))
+  {
+    preFlopFile.close();
+    return false;
+  }
+
+  preFlopFileValues = values;
+  return true;
+}
+
+/*
+Suit-isomorphic state: the canonical index from isomorphism.h, so that states that only differ by
+a permutation of the suits (or order of the cards) get the same key. The round is included because
+the canonical indices of different rounds overlap.
+*/
+static unsigned long long makeEquityKey(const std::vector<Card>& holeCards, const std::vector<Card>& boardCards, int numOpponents)
+{
+  Round round = getRoundForBoardSize((int)boardCards.size());
+  return (getCanonicalIndex(holeCards, boardCards) << 6) | ((unsigned long long)round << 4) | numOpponents;
+}
+
+/*
+Adaptive Monte Carlo simulation. Every sample gives the pot share X of the hero: 0 if someone beats
+him, 1/(1+k) if he ties with k opponents. After each batch, the 95% confidence interval of the mean of X
+is computed from the running sums of X and X^2, and the simulation stops when its half-width is below epsilon.
+Returns the amount of samples done.
+*/
+static int sampleEquity(EquityResult& result
+                      , const std::vector<Card>& holeCards, const std::vector<Card>& boardCards
+                      , int numOpponents, double epsilon, int minSamples, int maxSamples, int batchSamples)
+{
+  //your hand, the 5 table cards, and then the hand of the opponent being evaluated
+  int c[9];
+  c[0] = eval7_index(holeCards[0]);
+  c[1] = eval7_index(holeCards[1]);
+
+  int numBoard = (int)boardCards.size();
+  for(int i = 0; i < numBoard; i++) c[2 + i] = eval7_index(boardCards[i]);
+
+  bool used[52] = { false };
+  for(int i = 0; i < 2 + numBoard; i++) used[c[i]] = true;
+
+  int others[52];
+  int numOthers = 0;
+  for(int i = 0; i < 52; i++) if(!used[i]) others[numOthers++] = i;
+
+  int numMissing = 5 - numBoard;
+  int amount = numMissing + 2 * numOpponents;
+
+  int wins = 0;
+  int ties = 0;
+  int losses = 0;
+  double sum = 0.0;
+  double sum2 = 0.0;
+  int n = 0;
+
+  if(batchSamples < 1) batchSamples = 1;
+  RandomStream& random = getThreadRandomStream();
+
+  while(n < maxSamples)
+  {
+    for(int b = 0; b < batchSamples; b++)
+    {
+      shuffleN(others, numOthers, amount, random);
+      for(int i = 0; i < numMissing; i++) c[2 + numBoard + i] = others[i];
+
+      int yourVal = eval7(&c[0]);
+
+      int numTied = 0;
+      bool lost = false;
+      for(int j = 0; j < numOpponents; j++)
+      {
+        c[7] = others[numMissing + j * 2];
+        c[8] = others[numMissing + j * 2 + 1];
+
+        int opponentVal = eval7(&c[2]);
+
+        if(opponentVal > yourVal) { lost = true; break; }
+        else if(opponentVal == yourVal) numTied++;
+      }
+
+      if(lost) losses++;
+      else if(numTied > 0)
+      {
+        ties++;
+        double x = 1.0 / (1 + numTied);
+        sum += x;
+        sum2 += x * x;
+      }
+      else
+      {
+        wins++;
+        sum += 1.0;
+        sum2 += 1.0;
+      }
+    }
+
+    n += batchSamples;
+
+    if(n >= minSamples)
+    {
+      double mean = sum / n;
+      double var = sum2 / n - mean * mean;
+      if(var < 0.0) var = 0.0;
+      if(1.96 * std::sqrt(var / n) <= epsilon) break;
+    }
+  }
+
+  result.win = (float)wins / n;
+  result.tie = (float)ties / n;
+  result.lose = (float)losses / n;
+  result.equity = (float)(sum / n);
+
+  return n;
+}
+
+//computes the result without looking at the cache
+static void computeEquity(EquityResult& result, const std::vector<Card>& holeCards, const std::vector<Card>& boardCards, int numOpponents, const EquitySettings& settings)
+{
+  double win = 0, tie = 0, lose = 0;
+
+  if(numOpponents == 1 && boardCards.size() == 4) //heads-up turn: exact
+  {
+    getWinChanceAgainst1AtTurn(win, tie, lose, holeCards[0], holeCards[1], boardCards[0], boardCards[1], boardCards[2], boardCards[3]);
+  }
+  else if(numOpponents == 1 && boardCards.size() == 5) //heads-up river: exact
+  {
+    getWinChanceAgainst1AtRiver(win, tie, lose, holeCards[0], holeCards[1], boardCards[0], boardCards[1], boardCards[2], boardCards[3], boardCards[4]);
+  }
+  else
+  {
+    int n = sampleEquity(result, holeCards, boardCards, numOpponents, settings.epsilon, settings.minSamples, settings.maxSamples, settings.batchSamples);
+    std::lock_guard<std::mutex> lock(equityMutex);
+    equityStats.samples += n;
+    return;
+  }
+
+  result.win = (float)win;
+  result.tie = (float)tie;
+  result.lose = (float)lose;
+  result.equity = (float)(win + tie / 2); //heads-up, so a tie is half the pot
+}
+
+static void getPreFlopEquity(EquityResult& result, const std::vector<Card>& holeCards, int numOpponents)
+{
+  int index = getStartingHandIndex(holeCards[0], holeCards[1]);
+  EquitySettings settings;
+
+  {
+    std::lock_guard<std::mutex> lock(equityMutex);
+
+    if(!preFlopFileTried)
+    {
+      preFlopFileTried = true;
+      loadPreFlopEquityTableLocked(preFlopEquityFilePath);
+    }
+
+    if(preFlopFileValues)
+    {
+      const float* v = preFlopFileValues + (index * PREFLOP_EQUITY_OPPONENTS + numOpponents - 1) * PREFLOP_EQUITY_VALUES;
+      result.win = v[0];
+      result.tie = v[1];
+      result.lose = v[2];
+      result.equity = v[3];
+      equityStats.hits++;
+      return;
+    }
+
+    PreFlopEntry& entry = preFlopTable[index][numOpponents - 1];
+    if(entry.done)
+    {
+      equityStats.hits++;
+      result = entry.result;
+      return;
+    }
+    equityStats.misses++;
+    settings = equitySettings;
+  }
+
+  //computed outside the lock, if two threads ask for the same hand at the same time it's computed twice, which is harmless
+  std::vector<Card> boardCards;
+  int n = sampleEquity(result, holeCards, boardCards, numOpponents, settings.preFlopEpsilon, settings.minSamples, PREFLOP_MAXSAMPLES, settings.batchSamples);
+
+  std::lock_guard<std::mutex> lock(equityMutex);
+  equityStats.samples += n;
+  PreFlopEntry& entry = preFlopTable[index][numOpponents - 1];
+  entry.result = result;
+  entry.done = true;
+}
+
+static void getEquityResult(EquityResult& result, const std::vector<Card>& holeCards, const std::vector<Card>& boardCards, int numOpponents)
+{
+  if(numOpponents < 1) numOpponents = 1;
+  if(numOpponents > MAXOPPONENTS) numOpponents = MAXOPPONENTS;
+
+  if(boardCards.empty())
+  {
+    getPreFlopEquity(result, holeCards, numOpponents);
+    return;
+  }
+
+  unsigned long long key = makeEquityKey(holeCards, boardCards, numOpponents);
+  EquitySettings settings;
+
+  {
+    std::lock_guard<std::mutex> lock(equityMutex);
+    auto it = equityCache.find(key);
+    if(it != equityCache.end())
+    {
+      equityStats.hits++;
+      result = it->second;
+      return;
+    }
+    equityStats.misses++;
+    settings = equitySettings;
+  }
+
+  computeEquity(result, holeCards, boardCards, numOpponents, settings);
+
+  std::lock_guard<std::mutex> lock(equityMutex);
+  if(equityCache.size() >= equitySettings.maxCacheEntries) equityCache.clear();
+  equityCache[key] = result;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void setEquitySettings(const EquitySettings& settings)
+{
+  std::lock_guard<std::mutex> lock(equityMutex);
+  equitySettings = settings;
+  equityCache.clear();
+  for(int i = 0; i < 169; i++)
+  for(int j = 0; j < MAXOPPONENTS; j++)
+  {
+    preFlopTable[i][j].done = false;
+  }
+}
+
+EquitySettings getEquitySettings()
+{
+  std::lock_guard<std::mutex> lock(equityMutex);
+  return equitySettings;
+}
+
+double getPotEquityCached(const std::vector<Card>& holeCards, const std::vector<Card>& boardCards, int numOpponents)
+{
+  EquityResult result;
+  getEquityResult(result, holeCards, boardCards, numOpponents);
+  return result.equity;
+}
+
+void getWinChanceCached(double& win, double& tie, double& lose, const std::vector<Card>& holeCards, const std::vector<Card>& boardCards, int numOpponents)
+{
+  EquityResult result;
+  getEquityResult(result, holeCards, boardCards, numOpponents);
+  win = result.win;
+  tie = result.tie;
+  lose = result.lose;
+}
+
+void clearEquityCache()
+{
+  std::lock_guard<std::mutex> lock(equityMutex);
+  equityCache.clear();
+}
+
+EquityStats getEquityStats()
+{
+  std::lock_guard<std::mutex> lock(equityMutex);
+  EquityStats result = equityStats;
+  result.entries = equityCache.size();
+  return result;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+static const char EQUITYCACHE_MAGIC[4] = { 'O', 'O', 'E', 'Q' };
+static const unsigned EQUITYCACHE_VERSION = 2;
+
+bool saveEquityCache(const std::string& filename)
+{
+  std::ofstream file(filename.c_str(), std::ios::out | std::ios::binary);
+  if(!file) return false;
+
+  std::lock_guard<std::mutex> lock(equityMutex);
+
+  unsigned long long count = equityCache.size();
+  file.write(EQUITYCACHE_MAGIC, 4);
+  file.write((const char*)&EQUITYCACHE_VERSION, sizeof(EQUITYCACHE_VERSION));
+  file.write((const char*)&count, sizeof(count));
+
+  for(auto it = equityCache.begin(); it != equityCache.end(); ++it)
+  {
+    file.write((const char*)&it->first, sizeof(it->first));
+    file.write((const char*)&it->second, sizeof(EquityResult));
+  }
+
+  return (bool)file;
+}
+
+bool loadEquityCache(const std::string& filename)
+{
+  std::ifstream file(filename.c_str(), std::ios::in | std::ios::binary);
+  if(!file) return false;
+
+  char magic[4];
+  unsigned version = 0;
+  unsigned long long count = 0;
+  file.read(magic, 4);
+  file.read((char*)&version, sizeof(version));
+  file.read((char*)&count, sizeof(count));
+  if(!file || !std::equal(magic, magic + 4, EQUITYCACHE_MAGIC) || version != EQUITYCACHE_VERSION) return false;
+
+  std::vector<std::pair<unsigned long long, EquityResult> > entries;
+  for(unsigned long long i = 0; i < count; i++)
+  {
+    std::pair<unsigned long long, EquityResult> entry;
+    file.read((char*)&entry.first, sizeof(entry.first));
+    file.read((char*)&entry.second, sizeof(EquityResult));
+    if(!file) return false;
+    entries.push_back(entry);
+  }
+
+  std::lock_guard<std::mutex> lock(equityMutex);
+  for(size_t i = 0; i < entries.size(); i++)
+  {
+    //like a computed result, but instead of clearing the cache when it's full the rest of the file is left out
+    if(equityCache.size() >= equitySettings.maxCacheEntries && equityCache.find(entries[i].first) == equityCache.end()) break;
+    equityCache[entries[i].first] = entries[i].second;
+  }
+
+  return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+int getStartingHandIndex(const Card& card1, const Card& card2)
+{
+  int high = std::max(card1.value, card2.value);
+  int low = std::min(card1.value, card2.value);
+
+  int row = 14 - high; //ace = 0, two = 12
+  int col = 14 - low;
+
+  if(card1.suit == card2.suit) return row * 13 + col; //suited: above the diagonal (pairs can't be suited)
+  else return col * 13 + row; //offsuit and pairs
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void setPreFlopEquityFilePath(const std::string& path)
+{
+  std::lock_guard<std::mutex> lock(equityMutex);
+  preFlopEquityFilePath = path;
+  preFlopFileTried = false;
+  preFlopFileValues = 0;
+  preFlopFile.close();
+}
+
+bool loadPreFlopEquityTable(const std::string& filename)
+{
+  std::lock_guard<std::mutex> lock(equityMutex);
+  preFlopFileTried = true;
+  return loadPreFlopEquityTableLocked(filename);
+}
+
+void unloadPreFlopEquityTable()
+{
+  std::lock_guard<std::mutex> lock(equityMutex);
+  preFlopFileTried = true;
+  preFlopFileValues = 0;
+  preFlopFile.close();
+}
+
+bool writePreFlopEquityTable(const std::string& filename, const std::vector<float>& values, int exactOpponents, unsigned long long samples)
+{
+  if(values.size() != PREFLOPEQUITY_NUMVALUES) return false;
+
+  PreFlopEquityHeader header;
+  std::copy(PREFLOPEQUITY_MAGIC, PREFLOPEQUITY_MAGIC + 4, header.magic);
+  header.version = PREFLOPEQUITY_VERSION;
+  header.hands = PREFLOP_EQUITY_HANDS;
+  header.opponents = PREFLOP_EQUITY_OPPONENTS;
+  header.values = PREFLOP_EQUITY_VALUES;
+  header.exactOpponents = exactOpponents;
+  header.samples = samples;
+  header.checksum = getDataChecksum(&values[0], values.size() * sizeof(float));
+  header.padding = 0;
+
+  std::vector<unsigned char> data(sizeof(header) + values.size() * sizeof(float));
+  std::copy((const unsigned char*)&header, (const unsigned char*)&header + sizeof(header), data.begin());
+  std::copy((const unsigned char*)&values[0], (const unsigned char*)&values[0] + values.size() * sizeof(float), data.begin() + sizeof(header));
+
+  return writeFileAtomic(filename, &data[0], data.size());
+}
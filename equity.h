@@ -0,0 +1,125 @@
+/*
+OOPoker
+
+Copyright (c) 2010 Lode Vandevenne
+All rights reserved.
+
+This file is part of OOPoker.
+
+OOPoker is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+OOPoker is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with OOPoker.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+/*
+Equity service: a cached, tiered front end for the pot equity functions of pokermath.h.
+
+getPotEquity from pokermath.h always runs a full Monte Carlo simulation (50000 samples by default),
+which is fine for a human asking the console calculator, but much too slow for something that
+asks for the equity at every single decision (such as the feature vector of the RL AI).
+
+The functions here give the same kind of answer, but go through these tiers:
+-a cache keyed by the suit-isomorphic state (hole cards, board cards, number of opponents). E.g.
+ AhKh on 2h7c9d and AsKs on 2s7d9c are the same state and share one entry.
+-pre-flop: a table of 169 starting hands x 1-9 opponents. This is the table file generated by
+ gen_preflop_equity if it exists, otherwise it's filled with a high sample count the first time a
+ starting hand is asked for, and kept for the rest of the program.
+-heads-up turn and river: the exact (exhaustive) functions from pokermath.h.
+-everything else: an adaptive Monte Carlo sampler that stops as soon as the 95% confidence
+ interval of the equity is smaller than the epsilon from the EquitySettings.
+
+All functions are thread safe.
+*/
+
+#include <string>
+#include <vector>
+
+#include "card.h"
+
+struct EquitySettings
+{
+  double epsilon; //half-width of the 95% confidence interval at which the adaptive sampler stops
+  double preFlopEpsilon; //same, but for filling the pre-flop table, which is computed only once per starting hand
+  int minSamples; //the sampler never stops before this many samples
+  int maxSamples; //the sampler always stops after this many samples, even if epsilon isn't reached yet
+  int batchSamples; //the stop condition is checked every this many samples
+  size_t maxCacheEntries; //when the cache grows beyond this, it's cleared
+
+  EquitySettings();
+};
+
+struct EquityStats
+{
+  size_t hits; //answered from the cache or pre-flop table
+  size_t misses; //had to be computed
+  size_t samples; //total Monte Carlo samples done by the sampler
+  size_t entries; //current amount of entries in the cache
+
+  EquityStats();
+};
+
+void setEquitySettings(const EquitySettings& settings); //also clears the cache, since cached values depend on the settings
+EquitySettings getEquitySettings();
+
+/*
+Same meaning and parameters as getPotEquity in pokermath.h, except there is no numSamples: the
+amount of work is chosen by the EquitySettings instead. Ties are split properly between all
+tied players (getPotEquity from pokermath.h divides ties by numOpponents instead).
+*/
+double getPotEquityCached(const std::vector<Card>& holeCards, const std::vector<Card>& boardCards, int numOpponents);
+
+//win, tie and lose chance, with the same caching as getPotEquityCached
+void getWinChanceCached(double& win, double& tie, double& lose, const std::vector<Card>& holeCards, const std::vector<Card>& boardCards, int numOpponents);
+
+void clearEquityCache(); //clears the cache, but not the pre-flop table
+EquityStats getEquityStats();
+
+/*
+The cache can be kept between runs of the program. This only saves the cache, not the pre-flop table.
+Loading adds the entries of the file to the current cache, until it has maxCacheEntries entries. Both
+return false on error, e.g. when the file doesn't exist or was made by another version of the equity
+service.
+*/
+bool saveEquityCache(const std::string& filename);
+bool loadEquityCache(const std::string& filename);
+
+/*
+Index in a 13x13 grid of the pre-flop starting hand: row is the highest card value, column the lowest
+(both with ace = 0, king = 1, ..., two = 12). Suited hands are above the diagonal (row < column), offsuit
+hands below, pairs on the diagonal. Result is in range 0-168.
+*/
+int getStartingHandIndex(const Card& card1, const Card& card2);
+
+/*
+The pre-flop equity table file (default name "preflop_equity.dat"), made by the gen_preflop_equity tool.
+It's memory-mapped the first time a pre-flop equity is asked for. If it doesn't exist or is invalid,
+the pre-flop equities are computed with the Monte Carlo sampler instead.
+
+File format (little endian):
+-4 bytes "OOPF", 4 bytes version, 4 bytes amount of starting hands (169), 4 bytes max amount of opponents (9),
+ 4 bytes amount of values per entry (4), 4 bytes highest amount of opponents that is computed exactly,
+ 8 bytes amount of Monte Carlo samples per entry for the other amounts of opponents, 4 bytes checksum of
+ the values, 4 bytes padding
+-169 * 9 * 4 floats: per starting hand (see getStartingHandIndex), per amount of opponents (1-9): win, tie, lose, equity
+*/
+const int PREFLOP_EQUITY_HANDS = 169;
+const int PREFLOP_EQUITY_OPPONENTS = 9;
+const int PREFLOP_EQUITY_VALUES = 4;
+
+void setPreFlopEquityFilePath(const std::string& path);
+bool loadPreFlopEquityTable(const std::string& filename); //returns false if the file doesn't exist or is invalid
+void unloadPreFlopEquityTable(); //from now on compute the pre-flop equities with the sampler again
+
+//values must have PREFLOP_EQUITY_HANDS * PREFLOP_EQUITY_OPPONENTS * PREFLOP_EQUITY_VALUES floats
+bool writePreFlopEquityTable(const std::string& filename, const std::vector<float>& values, int exactOpponents, unsigned long long samples);
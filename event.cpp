@@ -23,6 +23,8 @@ along with OOPoker.  If not, see <http://www.gnu.org/licenses/>.
 #include "event.h"
 
 #include "combination.h"
+#include "eventring.h"
+#include "nametable.h"
 #include "player.h"
 #include "observer.h"
 
@@ -31,52 +33,47 @@ along with OOPoker.  If not, see <http://www.gnu.org/licenses/>.
 
 Event::Event(EventType type)
 : type(type)
+, playerId(-1)
 {
 }
 
 Event::Event(EventType type, const std::string& player)
-: type(type)
-, player(player)
+: Event(type, NameId(internName(player)))
 {
 }
 
 Event::Event(EventType type, const std::string& player, int chips)
-: type(type)
-, player(player)
-, chips(chips)
+: Event(type, NameId(internName(player)), chips)
 {
 }
 
 Event::Event(EventType type, int position, const std::string& player)
 : type(type)
-, player(player)
+, playerId(internName(player))
 , position(position)
 {
 }
 
 Event::Event(EventType type, int position, int chips, const std::string& player)
-: type(type)
-, player(player)
-, chips(chips)
-, position(position)
+: Event(type, position, chips, NameId(internName(player)))
 {
 }
 
 Event::Event(EventType type, const std::string& player, const std::string& ai)
-: type(type)
-, player(player)
-, ai(ai)
+: Event(type, NameId(internName(player)), ai)
 {
 }
 
 Event::Event(EventType type, const Card& card1)
 : type(type)
+, playerId(-1)
 , card1(card1)
 {
 }
 
 Event::Event(EventType type, const Card& card1, const Card& card2)
 : type(type)
+, playerId(-1)
 , card1(card1)
 , card2(card2)
 {
@@ -84,6 +81,7 @@ Event::Event(EventType type, const Card& card1, const Card& card2)
 
 Event::Event(EventType type, const Card& card1, const Card& card2, const Card& card3)
 : type(type)
+, playerId(-1)
 , card1(card1)
 , card2(card2)
 , card3(card3)
@@ -92,6 +90,7 @@ Event::Event(EventType type, const Card& card1, const Card& card2, const Card& c
 
 Event::Event(EventType type, const Card& card1, const Card& card2, const Card& card3, const Card& card4)
 : type(type)
+, playerId(-1)
 , card1(card1)
 , card2(card2)
 , card3(card3)
@@ -101,6 +100,7 @@ Event::Event(EventType type, const Card& card1, const Card& card2, const Card& c
 
 Event::Event(EventType type, const Card& card1, const Card& card2, const Card& card3, const Card& card4, const Card& card5)
 : type(type)
+, playerId(-1)
 , card1(card1)
 , card2(card2)
 , card3(card3)
@@ -110,41 +110,87 @@ Event::Event(EventType type, const Card& card1, const Card& card2, const Card& c
 }
 
 Event::Event(EventType type, const std::string& player, const Card& card1, const Card& card2, const Card& card3, const Card& card4, const Card& card5)
-: type(type)
-, player(player)
-, card1(card1)
-, card2(card2)
-, card3(card3)
-, card4(card4)
-, card5(card5)
+: Event(type, NameId(internName(player)), card1, card2, card3, card4, card5)
 {
 }
 
 Event::Event(EventType type, const std::string& player, const Card& card1, const Card& card2)
-: type(type)
-, player(player)
-, card1(card1)
-, card2(card2)
+: Event(type, NameId(internName(player)), card1, card2)
 {
 }
 Event::Event(const std::string& message, EventType type)
 : type(type)
+, playerId(-1)
 , message(message)
 {
 }
 
 Event::Event(EventType type, int smallBlind, int bigBlind, int ante)
 : type(type)
+, playerId(-1)
 , smallBlind(smallBlind)
 , bigBlind(bigBlind)
 , ante(ante)
 {
 }
 
+Event::Event(EventType type, NameId player)
+: type(type)
+, playerId(player.id)
+{
+}
+
+Event::Event(EventType type, NameId player, int chips)
+: type(type)
+, playerId(player.id)
+, chips(chips)
+{
+}
+
+Event::Event(EventType type, int position, int chips, NameId player)
+: type(type)
+, playerId(player.id)
+, chips(chips)
+, position(position)
+{
+}
+
+Event::Event(EventType type, NameId player, const std::string& ai)
+: type(type)
+, playerId(player.id)
+, ai(ai)
+{
+}
+
+Event::Event(EventType type, NameId player, const Card& card1, const Card& card2, const Card& card3, const Card& card4, const Card& card5)
+: type(type)
+, playerId(player.id)
+, card1(card1)
+, card2(card2)
+, card3(card3)
+, card4(card4)
+, card5(card5)
+{
+}
+
+Event::Event(EventType type, NameId player, const Card& card1, const Card& card2)
+: type(type)
+, playerId(player.id)
+, card1(card1)
+, card2(card2)
+{
+}
+
+const std::string& Event::getPlayer() const
+{
+  static const std::string none;
+  return playerId < 0 ? none : getInternedName(playerId);
+}
+
 std::string eventToString(const Event& event)
 {
   std::stringstream ss;
-  std::string playerName = event.player;
+  const std::string& playerName = event.getPlayer();
 
   switch(event.type)
   {
@@ -189,7 +235,7 @@ std::string eventToString(const Event& event)
 std::string eventToStringVerbose(const Event& event)
 {
   std::stringstream ss;
-  std::string playerName = event.player;
+  const std::string& playerName = event.getPlayer();
 
   switch(event.type)
   {
@@ -231,6 +277,187 @@ std::string eventToStringVerbose(const Event& event)
   return ss.str();
 }
 
+//if text starts with prefix, gives the part after it in rest
+static bool startsWith(const std::string& text, const std::string& prefix, std::string& rest)
+{
+  if(text.compare(0, prefix.size(), prefix) != 0) return false;
+  rest = text.substr(prefix.size());
+  return true;
+}
+
+//splits "a<separator>b" at the last separator, so that names containing the separator still work
+static bool splitLast(const std::string& text, const std::string& separator, std::string& a, std::string& b)
+{
+  size_t pos = text.rfind(separator);
+  if(pos == std::string::npos) return false;
+  a = text.substr(0, pos);
+  b = text.substr(pos + separator.size());
+  return true;
+}
+
+static bool parseInt(const std::string& text, int& result)
+{
+  std::stringstream ss(text);
+  return (ss >> result) && ss.eof();
+}
+
+static bool parseCards(const std::string& text, Card* cards, int amount) //e.g. "Ah Kd"
+{
+  std::stringstream ss(text);
+  for(int i = 0; i < amount; i++)
+  {
+    std::string name;
+    if(!(ss >> name) || name.size() != 2) return false;
+    cards[i] = Card(name);
+    if(!cards[i].isValid()) return false;
+  }
+  std::string more;
+  return !(ss >> more);
+}
+
+//"name, chips: 10" and so on
+static bool parsePlayerAndInt(Event& event, const std::string& text, const std::string& separator, int& value)
+{
+  std::string name, number;
+  if(!splitLast(text, separator, name, number) || !parseInt(number, value)) return false;
+  event.playerId = internName(name);
+  return true;
+}
+
+bool stringToEvent(Event& event, const std::string& text)
+{
+  event = Event(E_NUM_EVENTS);
+  std::string rest, a, b;
+  Card cards[5];
+
+  struct { const char* prefix; EventType type; } playerChips[] =
+  {
+    { "Joins: ", E_JOIN }, { "Quits: ", E_QUIT }, { "Small Blind: ", E_SMALL_BLIND }, { "Big Blind: ", E_BIG_BLIND },
+    { "Ante: ", E_ANTE }, { "Raises: ", E_RAISE }, { "Wins: ", E_WIN }
+  };
+  for(size_t i = 0; i < sizeof(playerChips) / sizeof(*playerChips); i++)
+  {
+    if(!startsWith(text, playerChips[i].prefix, rest)) continue;
+    event.type = playerChips[i].type;
+    return parsePlayerAndInt(event, rest, ", chips: ", event.chips);
+  }
+
+  struct { const char* prefix; EventType type; } playerOnly[] =
+  {
+    { "Folds: ", E_FOLD }, { "Checks: ", E_CHECK }, { "Calls: ", E_CALL }, { "Dealer: ", E_DEALER }
+  };
+  for(size_t i = 0; i < sizeof(playerOnly) / sizeof(*playerOnly); i++)
+  {
+    if(!startsWith(text, playerOnly[i].prefix, rest)) continue;
+    event.type = playerOnly[i].type;
+    event.playerId = internName(rest);
+    return true;
+  }
+
+  struct { const char* prefix; EventType type; } playerCards[] =
+  {
+    { "Shows: ", E_PLAYER_SHOWDOWN }, { "Boasts: ", E_BOAST }
+  };
+  for(size_t i = 0; i < sizeof(playerCards) / sizeof(*playerCards); i++)
+  {
+    if(!startsWith(text, playerCards[i].prefix, rest)) continue;
+    event.type = playerCards[i].type;
+    if(!splitLast(rest, ", ", a, b) || !parseCards(b, cards, 2)) return false;
+    event.playerId = internName(a);
+    event.card1 = cards[0];
+    event.card2 = cards[1];
+    return true;
+  }
+
+  if(startsWith(text, "Player ", rest) && splitLast(rest, " rebuys with ", a, b) && b.size() > 6 && b.compare(b.size() - 6, 6, " chips") == 0)
+  {
+    event.type = E_REBUY;
+    event.playerId = internName(a);
+    return parseInt(b.substr(0, b.size() - 6), event.chips);
+  }
+  if(startsWith(text, "New deal. SB: ", rest))
+  {
+    event.type = E_NEW_DEAL;
+    std::stringstream ss(rest);
+    std::string bb, ante;
+    return (ss >> event.smallBlind >> bb >> event.bigBlind >> ante >> event.ante) && bb == "BB:" && ante == "Ante:";
+  }
+  if(startsWith(text, "Received cards: ", rest))
+  {
+    event.type = E_RECEIVE_CARDS;
+    if(!parseCards(rest, cards, 2)) return false;
+    event.card1 = cards[0];
+    event.card2 = cards[1];
+    return true;
+  }
+  if(startsWith(text, "Flop: ", rest))
+  {
+    event.type = E_FLOP;
+    if(!parseCards(rest, cards, 3)) return false;
+    event.card1 = cards[0];
+    event.card2 = cards[1];
+    event.card3 = cards[2];
+    return true;
+  }
+  if(startsWith(text, "Turn: ", rest))
+  {
+    event.type = E_TURN;
+    return parseCards(rest, &event.card4, 1);
+  }
+  if(startsWith(text, "River: ", rest))
+  {
+    event.type = E_RIVER;
+    return parseCards(rest, &event.card5, 1);
+  }
+  if(text == "Showdown Reached")
+  {
+    event.type = E_SHOWDOWN;
+    return true;
+  }
+  if(startsWith(text, "Pot size: ", rest))
+  {
+    event.type = E_POT_DIVISION;
+    return parseInt(rest, event.chips);
+  }
+  if(startsWith(text, "Combination: ", rest))
+  {
+    event.type = E_COMBINATION;
+    size_t open = rest.rfind(" ( ");
+    if(open == std::string::npos || rest.size() < 2 || rest.compare(rest.size() - 2, 2, " )") != 0) return false;
+    if(!parseCards(rest.substr(open + 3, rest.size() - 2 - open - 3), cards, 5)) return false;
+    if(!splitLast(rest.substr(0, open), ", ", a, b)) return false;
+    event.playerId = internName(a);
+    event.card1 = cards[0];
+    event.card2 = cards[1];
+    event.card3 = cards[2];
+    event.card4 = cards[3];
+    event.card5 = cards[4];
+    return true;
+  }
+  if(startsWith(text, "Ranking: ", rest))
+  {
+    event.type = E_TOURNAMENT_RANK;
+    if(!splitLast(rest, ", Score: ", a, b) || !parseInt(b, event.chips)) return false;
+    return parsePlayerAndInt(event, a, ", Place: ", event.position);
+  }
+  if(startsWith(text, "Reveal AI: ", rest))
+  {
+    event.type = E_REVEAL_AI;
+    if(!splitLast(rest, ", AI: ", a, b)) return false;
+    event.playerId = internName(a);
+    event.ai = b;
+    return true;
+  }
+  if(startsWith(text, "DEBUG MESSAGE: ", rest))
+  {
+    event.type = E_DEBUG_MESSAGE;
+    event.message = rest;
+    return true;
+  }
+
+  return false;
+}
+
 void sendEventToPlayers(std::vector<Player>& players, const Event& event)
 {
  for(size_t i = 0; i < players.size(); i++)
@@ -257,3 +484,15 @@ void sendEventsToPlayers(size_t& counter, std::vector<Player>& players, std::vec
 
   counter = events.size();
 }
+
+void sendEventsToPlayers(size_t& counter, std::vector<Player>& players, std::vector<Observer*>& observers, EventRing& events)
+{
+  for(size_t i = counter; i < events.getEnd(); i++)
+  {
+    sendEventToPlayers(players, events.get(i));
+    sendEventToObservers(observers, events.get(i));
+  }
+
+  counter = events.getEnd();
+  events.release(counter);
+}
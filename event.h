@@ -28,12 +28,13 @@ along with OOPoker.  If not, see <http://www.gnu.org/licenses/>.
 
 struct Player;
 class Observer;
+class EventRing;
 
 enum EventType
 {
   //an EventType has some information associated with it in the Event struct.
   //The comment at to each event says which info exactly, if any.
-  //If an event is related to a player, the player is always given as a string (not as an index). You can use those player names to uniquely identify them.
+  //If an event is related to a player, the player is always given by name (not as an index), see getPlayer. You can use those player names to uniquely identify them.
 
   //info used: player, chips (with how much chips this player joins)
   E_JOIN, //player joins table
@@ -116,11 +117,18 @@ enum EventType
   E_NUM_EVENTS //don't use
 };
 
+//A player name as id in the name table of nametable.h, for the Event constructors that take the id directly.
+struct NameId
+{
+  explicit NameId(int id) : id(id) {}
+  int id;
+};
+
 struct Event
 {
   EventType type;
 
-  std::string player; //name of player the event is related to
+  int playerId; //player the event is related to, as id in the name table of nametable.h (the name itself is getPlayer())
   std::string ai; //used for very rare events that unmistify the AI of a player
   int chips; //money above call amount, if it's a raise event. Win amount if it's a win event. Pot amount if it's a pot event.
 
@@ -153,8 +161,18 @@ struct Event
   Event(EventType type, int smallBlind, int bigBlind, int ante);
   Event(const std::string& message, EventType type);
 
+  //the same as the constructors above that take the name, but without looking up its id (used by Game for every event)
+  Event(EventType type, NameId player);
+  Event(EventType type, NameId player, int chips);
+  Event(EventType type, int position, int chips, NameId player);
+  Event(EventType type, NameId player, const std::string& ai);
+  Event(EventType type, NameId player, const Card& card1, const Card& card2, const Card& card3, const Card& card4, const Card& card5);
+  Event(EventType type, NameId player, const Card& card1, const Card& card2);
+
 
   std::string message;
+
+  const std::string& getPlayer() const; //name of player the event is related to, empty if none
 };
 
 //this gives the event in a good form for a log or computer parsing
@@ -163,10 +181,17 @@ std::string eventToString(const Event& event);
 //this gives the event in a more verbose full English sentence form
 std::string eventToStringVerbose(const Event& event);
 
-//TODO: make the opposite, a stringToEvent parsing function
+/*
+The opposite of eventToString: parses such a line back into event, returns false if it isn't one.
+What eventToString leaves out stays unknown: the player of E_RECEIVE_CARDS, the flop cards of E_TURN
+and E_RIVER, the turn card of E_RIVER. Log messages have no recognizable form, so they give false too.
+*/
+bool stringToEvent(Event& event, const std::string& text);
 
 //sends unprocessed events to player, but only events the player is allowed to know! (the events vector is not supposed to contain personal events, such as E_RECEIVE_CARDS)
 void sendEventsToPlayers(size_t& counter, std::vector<Player>& players, std::vector<Observer*>& observers, const std::vector<Event>& events);
+//same, and afterwards releases the sent events from the ring, since everyone has them now
+void sendEventsToPlayers(size_t& counter, std::vector<Player>& players, std::vector<Observer*>& observers, EventRing& events);
 
 
 
@@ -0,0 +1,66 @@
+/*
+OOPoker
+
+Copyright (c) 2010 Lode Vandevenne
+All rights reserved.
+
+This file is part of OOPoker.
+
+OOPoker is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+OOPoker is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with OOPoker.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include "eventring.h"
+
+static size_t roundCapacity(size_t capacity)
+{
+  size_t result = 1;
+  while(result < capacity) result *= 2;
+  return result;
+}
+
+EventRing::EventRing(size_t capacity)
+: slots(roundCapacity(capacity), Event(E_NUM_EVENTS))
+, mask(slots.size() - 1)
+, begin(0)
+, end(0)
+{
+}
+
+void EventRing::push(const Event& event)
+{
+  if(end - begin == slots.size())
+  {
+    //full: move the waiting events into a ring of twice the size, at the same sequence numbers
+    std::vector<Event> bigger(slots.size() * 2, Event(E_NUM_EVENTS));
+    size_t biggerMask = bigger.size() - 1;
+    for(size_t i = begin; i < end; i++) bigger[i & biggerMask] = slots[i & mask];
+    slots.swap(bigger);
+    mask = biggerMask;
+  }
+
+  slots[end & mask] = event;
+  end++;
+}
+
+void EventRing::release(size_t sequence)
+{
+  if(sequence > end) sequence = end;
+  if(sequence > begin) begin = sequence;
+}
+
+void EventRing::clear()
+{
+  begin = end = 0;
+}
@@ -0,0 +1,63 @@
+/*
+OOPoker
+
+Copyright (c) 2010 Lode Vandevenne
+All rights reserved.
+
+This file is part of OOPoker.
+
+OOPoker is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+OOPoker is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with OOPoker.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+#include "event.h"
+
+/*
+Fixed-capacity ring of the events of a Game. Every pushed event gets the next sequence number. Once all
+players and observers have received an event (see sendEventsToPlayers), it's released and its slot is
+reused by a later event, so the memory stays the same no matter how many deals a game runs. Reusing a
+slot assigns over the old Event, so even its message string keeps its buffer.
+
+The Game sends its events after every action and at the end of every deal, so far fewer events than the
+capacity are ever waiting at once. Should more be pushed without releasing any, the ring doubles its
+capacity rather than losing events.
+*/
+class EventRing
+{
+  public:
+    EventRing(size_t capacity = 256); //rounded up to a power of two
+
+    void push(const Event& event);
+
+    size_t getBegin() const { return begin; } //sequence number of the oldest event that isn't released yet
+    size_t getEnd() const { return end; } //sequence number the next pushed event will get
+    size_t getSize() const { return end - begin; }
+    size_t getCapacity() const { return slots.size(); }
+
+    const Event& get(size_t sequence) const { return slots[sequence & mask]; } //sequence must be in [getBegin(), getEnd())
+
+    void release(size_t sequence); //all events before this sequence number are consumed, their slots can be reused
+    void clear(); //releases all events and starts over from sequence number 0
+
+  private:
+    std::vector<Event> slots;
+    size_t mask;
+    size_t begin;
+    size_t end;
+};
@@ -37,33 +37,27 @@ along with OOPoker.  If not, see <http://www.gnu.org/licenses/>.
 #include "table.h"
 #include "util.h"
 
+/*
+The same Info is filled in again for every decision, so this only overwrites values: the vectors keep
+their capacity (Info reserves room for 5 board cards, 10 players and 2 hole cards each) and are only
+resized when their size changes, and the names are ids into the name table. Once the Info has been used
+for a deal, this doesn't allocate anything anymore.
+*/
 void makeInfo(Info& info, const Table& table, const Rules& rules, int playerViewPoint)
 {
   info.yourIndex = playerViewPoint;
   info.current = table.current;
   info.dealer = table.dealer;
   info.minRaiseAmount = table.lastRaiseAmount;
-  
-  info.boardCards.clear();
 
-  if(table.round >= R_FLOP)
-  {
-    info.boardCards.resize(3);
-    info.boardCards[0] = table.boardCard1;
-    info.boardCards[1] = table.boardCard2;
-    info.boardCards[2] = table.boardCard3;
-  }
-  if(table.round >= R_TURN)
-  {
-    info.boardCards.push_back(table.boardCard4);
-  }
-  if(table.round >= R_RIVER)
-  {
-    info.boardCards.push_back(table.boardCard5);
-  }
+  const Card* board[5] = { &table.boardCard1, &table.boardCard2, &table.boardCard3, &table.boardCard4, &table.boardCard5 };
+  size_t numBoard = table.round >= R_RIVER ? 5 : table.round == R_TURN ? 4 : table.round == R_FLOP ? 3 : 0;
+  if(info.boardCards.size() != numBoard) info.boardCards.resize(numBoard);
+  for(size_t i = 0; i < numBoard; i++) info.boardCards[i] = *board[i];
+
   info.round = table.round;
   info.turn = table.turn;
-  info.players.resize(table.players.size());
+  if(info.players.size() != table.players.size()) info.players.resize(table.players.size());
   for(size_t j = 0; j < table.players.size(); j++)
   {
     PlayerInfo& p = info.players[j];
@@ -71,16 +65,16 @@ void makeInfo(Info& info, const Table& table, const Rules& rules, int playerView
     p.folded = pl.folded;
     p.stack = pl.stack;
     p.wager = pl.wager;
-    p.name = pl.getName();
+    p.nameId = pl.nameId;
     p.lastAction = pl.lastAction;
     p.showdown = pl.showdown;
     if(pl.showdown || (int)j == playerViewPoint)
     {
-      p.holeCards.resize(2);
+      if(p.holeCards.size() != 2) p.holeCards.resize(2);
       p.holeCards[0] = pl.holeCard1;
       p.holeCards[1] = pl.holeCard2;
     }
-    else p.holeCards.clear();
+    else if(!p.holeCards.empty()) p.holeCards.clear();
   }
   info.rules = rules;
 }
@@ -129,18 +123,18 @@ void applyAction(Table& table, const Action& action, int callAmount)
   }
 }
 //applies blinds and antes
-void applyForcedBets(Table& table, const Rules& rules, std::vector<Event>& events)
+void applyForcedBets(Table& table, const Rules& rules, EventRing& events)
 {
   Player& sb = table.players[table.getSmallBlindIndex()];
   Player& bb = table.players[table.getBigBlindIndex()];
 
   int amount_sb = placeMoney(sb, rules.smallBlind);
 
-  events.push_back(Event(E_SMALL_BLIND, table.players[table.getSmallBlindIndex()].getName(), amount_sb));
+  events.push(Event(E_SMALL_BLIND, NameId(table.players[table.getSmallBlindIndex()].nameId), amount_sb));
 
   int amount_bb = placeMoney(bb, rules.bigBlind);
 
-  events.push_back(Event(E_BIG_BLIND, table.players[table.getBigBlindIndex()].getName(), amount_bb));
+  events.push(Event(E_BIG_BLIND, NameId(table.players[table.getBigBlindIndex()].nameId), amount_bb));
 
   if(rules.ante > 0)
   {
@@ -152,20 +146,20 @@ void applyForcedBets(Table& table, const Rules& rules, std::vector<Event>& event
 
       int amount = placeMoney(table.players[j], rules.ante);
 
-      events.push_back(Event(E_ANTE, table.players[table.getBigBlindIndex()].getName(), amount));
+      events.push(Event(E_ANTE, NameId(table.players[j].nameId), amount));
     }
   }
 }
 
 //the Info must be the information from BEFORE the player did the action (to determine bet<-->raise)
-Event eventFromAction(const Action& action, int callAmount, const std::string& playerName)
+Event eventFromAction(const Action& action, int callAmount, int playerId)
 {
   switch(action.command)
   {
-    case A_FOLD: return Event(E_FOLD, playerName);
-    case A_CHECK: return Event(E_CHECK, playerName);
-    case A_CALL: return Event(E_CALL, playerName);
-    case A_RAISE: return Event(E_RAISE, playerName, action.amount - callAmount);
+    case A_FOLD: return Event(E_FOLD, NameId(playerId));
+    case A_CHECK: return Event(E_CHECK, NameId(playerId));
+    case A_CALL: return Event(E_CALL, NameId(playerId));
+    case A_RAISE: return Event(E_RAISE, NameId(playerId), action.amount - callAmount);
     default: return Event(E_NUM_EVENTS);
   }
 
@@ -285,7 +279,7 @@ void dividePot(std::vector<int>& wins, const std::vector<int>& wager, const std:
   } //for sidepots
 }
 
-void dividePot(Table& table, std::vector<Event>& events)
+void dividePot(Table& table, EventRing& events)
 {
   std::vector<Player>& players = table.players;
 
@@ -313,7 +307,7 @@ void dividePot(Table& table, std::vector<Event>& events)
   {
     if(wins[i] == 0) continue;
     players[i].stack += wins[i];
-    events.push_back(Event(E_WIN, players[i].getName(), wins[i]));
+    events.push(Event(E_WIN, NameId(players[i].nameId), wins[i]));
   }
 
   for(size_t i = 0; i < players.size(); i++)
@@ -432,6 +426,7 @@ Game::Game(Host* host)
 : host(host)
 , eventCounter(0)
 , numDeals(0)
+, shuffleMode(SHUFFLE_SECURE)
 {
 }
 
@@ -456,8 +451,8 @@ void Game::settleBets(Table& table, Rules& rules)
     host->onFrame();
     if(host->wantToQuit()) return;
 
-    //events.push_back(Event("turn " + valtostr(table.turn), E_DEBUG_MESSAGE));
-    //events.push_back(Event("player " + valtostr(table.current) + " " + table.players[table.current].getName() + " (turn: " + valtostr(table.turn) + ")", E_DEBUG_MESSAGE));
+    //events.push(Event("turn " + valtostr(table.turn), E_DEBUG_MESSAGE));
+    //events.push(Event("player " + valtostr(table.current) + " " + table.players[table.current].getName() + " (turn: " + valtostr(table.turn) + ")", E_DEBUG_MESSAGE));
     if(betsSettled(table.lastRaiser, table.current, prev_current, table.players))
     {
       bets_running = false;
@@ -470,7 +465,7 @@ void Game::settleBets(Table& table, Rules& rules)
 
     if(!isValidAction(action, player.stack, player.wager, table.getHighestWager(), table.lastRaiseAmount))
     {
-      events.push_back(Event("INVALID ACTION FROM " + player.getName() + " (" + valtostr(action.command) + " " + valtostr(action.amount) + ")", E_DEBUG_MESSAGE));
+      events.push(Event("INVALID ACTION FROM " + player.getName() + " (" + valtostr(action.command) + " " + valtostr(action.amount) + ")", E_DEBUG_MESSAGE));
       action = Action(A_FOLD);
     }
 
@@ -485,7 +480,7 @@ void Game::settleBets(Table& table, Rules& rules)
     }
     else if(table.lastRaiser == -1 && (action.command == A_CALL || action.command == A_CHECK)) table.lastRaiser = table.current;
 
-    events.push_back(eventFromAction(action, callAmount, table.players[table.current].getName()));
+    events.push(eventFromAction(action, callAmount, table.players[table.current].nameId));
 
     applyAction(table, action, callAmount);
 
@@ -512,7 +507,7 @@ void Game::kickOutPlayers(Table& table)
     {
       if(rules.allowRebuy)
       {
-        events.push_back(Event(E_REBUY, playersIn[i].getName(), rules.buyIn));
+        events.push(Event(E_REBUY, NameId(playersIn[i].nameId), rules.buyIn));
         playersIn[i].buyInTotal += rules.buyIn;
         playersIn[i].stack = rules.buyIn;
       }
@@ -523,14 +518,12 @@ void Game::kickOutPlayers(Table& table)
     }
     else if(playersIn[i].isHuman())
     {
-      Info info;
-      makeInfo(info, table, rules, i);
-      if(playersIn[i].ai->wantsToLeave(info)) leave = true;
+      if(playersIn[i].ai->wantsToLeave(getInfoForPlayers(table, i))) leave = true;
     }
 
     if(leave)
     {
-      events.push_back(Event(E_QUIT, playersIn[i].getName(), playersIn[i].stack));
+      events.push(Event(E_QUIT, NameId(playersIn[i].nameId), playersIn[i].stack));
       playersOut.push_back(playersIn[i]);
       playersIn.erase(playersIn.begin() + i);
       if(table.dealer > i) table.dealer--; // if i == table.dealer, it stays: that makes next player after the one who left the dealer
@@ -551,39 +544,41 @@ void Game::runTable(Table& table)
 
   for(size_t i = 0; i < table.players.size(); i++)
   {
-    events.push_back(Event(E_JOIN, table.players[i].getName(), table.players[i].stack));
+    events.push(Event(E_JOIN, NameId(table.players[i].nameId), table.players[i].stack));
   }
 
   Deck deck;
 
   //table.dealer = -1; //so that player 0 will start at increment
-  table.dealer = getRandom(0, table.players.size() - 1);
+  if(shuffleMode == SHUFFLE_FAST) table.dealer = shuffleRandom.nextInt(0, table.players.size() - 1);
+  else table.dealer = getRandom(0, table.players.size() - 1);
 
   bool table_running = true;
   while(table_running)
   {
     numDeals++;
 
-    deck.shuffle();
+    if(shuffleMode == SHUFFLE_FAST) deck.shuffle(shuffleRandom);
+    else deck.shuffle();
 
     //give everyone the first and second card
     for(size_t i = 0; i < table.players.size(); i++) table.players[i].holeCard1 = deck.next();
     for(size_t i = 0; i < table.players.size(); i++) table.players[i].holeCard2 = deck.next();
 
-    for(size_t i = 0; i < table.players.size(); i++) table.players[i].onEvent(Event(E_RECEIVE_CARDS, table.players[i].getName(), table.players[i].holeCard1, table.players[i].holeCard2));
+    for(size_t i = 0; i < table.players.size(); i++) table.players[i].onEvent(Event(E_RECEIVE_CARDS, NameId(table.players[i].nameId), table.players[i].holeCard1, table.players[i].holeCard2));
 
-    events.push_back(Event(E_NEW_DEAL, rules.smallBlind, rules.bigBlind, rules.ante));
+    events.push(Event(E_NEW_DEAL, rules.smallBlind, rules.bigBlind, rules.ante));
     sendEvents(table);
     table.lastRaiseAmount = rules.bigBlind;
 
-    events.push_back(Event(E_DEALER, table.players[table.dealer].getName()));
+    events.push(Event(E_DEALER, NameId(table.players[table.dealer].nameId)));
 
     applyForcedBets(table, rules, events);
 
     //deal
     for(int r = 0; r < 4 && table_running; r++) //round: pre-flop to river
     {
-      //events.push_back(Event("round " + valtostr(r), E_DEBUG_MESSAGE));
+      //events.push(Event("round " + valtostr(r), E_DEBUG_MESSAGE));
 
       Round round = (Round)r;
       table.turn = 0;
@@ -593,19 +588,19 @@ void Game::runTable(Table& table)
         table.boardCard1 = deck.next();
         table.boardCard2 = deck.next();
         table.boardCard3 = deck.next();
-        events.push_back(Event(E_FLOP, table.boardCard1, table.boardCard2, table.boardCard3));
+        events.push(Event(E_FLOP, table.boardCard1, table.boardCard2, table.boardCard3));
       }
       else if(round == R_TURN)
       {
         deck.next(); //burn
         table.boardCard4 = deck.next();
-        events.push_back(Event(E_TURN, table.boardCard1, table.boardCard2, table.boardCard3, table.boardCard4));
+        events.push(Event(E_TURN, table.boardCard1, table.boardCard2, table.boardCard3, table.boardCard4));
       }
       if(round == R_RIVER)
       {
         deck.next(); //burn
         table.boardCard5 = deck.next();
-        events.push_back(Event(E_RIVER, table.boardCard1, table.boardCard2, table.boardCard3, table.boardCard4, table.boardCard5));
+        events.push(Event(E_RIVER, table.boardCard1, table.boardCard2, table.boardCard3, table.boardCard4, table.boardCard5));
       }
       table.round = round;
 
@@ -627,9 +622,9 @@ void Game::runTable(Table& table)
     std::vector<Player>& players = table.players;
 
     Event potEvent(E_POT_DIVISION); potEvent.chips = table.getPot();
-    events.push_back(potEvent);
+    events.push(potEvent);
 
-    if(table.getNumActivePlayers() > 1) events.push_back(Event(E_SHOWDOWN)); //the showdown is NOT reached if only a single player remains!
+    if(table.getNumActivePlayers() > 1) events.push(Event(E_SHOWDOWN)); //the showdown is NOT reached if only a single player remains!
 
     for(size_t i = 0; i < players.size(); i++)
     {
@@ -638,21 +633,19 @@ void Game::runTable(Table& table)
       if(table.getNumActivePlayers() <= 1) show = false; //win by outbluffing everyone
       if(show)
       {
-        events.push_back(Event(E_PLAYER_SHOWDOWN, players[i].getName(), players[i].holeCard1, players[i].holeCard2));
+        events.push(Event(E_PLAYER_SHOWDOWN, NameId(players[i].nameId), players[i].holeCard1, players[i].holeCard2));
 
         players[i].showdown = true;//showdown (not if only one player left, in which case someone outbluffed everyone)
 
         Combination combo;
         getComboFromPlayerAndTable(combo, players[i], table);
-        events.push_back(Event(E_COMBINATION, players[i].getName(), combo.cards[0], combo.cards[1], combo.cards[2], combo.cards[3], combo.cards[4]));
+        events.push(Event(E_COMBINATION, NameId(players[i].nameId), combo.cards[0], combo.cards[1], combo.cards[2], combo.cards[3], combo.cards[4]));
       }
 
       if(!show)
       {
-        Info info;
-        makeInfo(info, table, rules, 0);
-        show = players[i].ai->boastCards(info);
-        if(show) events.push_back(Event(E_BOAST, players[i].getName(), players[i].holeCard1, players[i].holeCard2));
+        show = players[i].ai->boastCards(getInfoForPlayers(table, 0));
+        if(show) events.push(Event(E_BOAST, NameId(players[i].nameId), players[i].holeCard1, players[i].holeCard2));
       }
     }
 
@@ -698,6 +691,12 @@ void Game::setRules(const Rules& rules)
   this->rules = rules;
 }
 
+void Game::setShuffleMode(ShuffleMode mode, uint64_t seed)
+{
+  shuffleMode = mode;
+  shuffleRandom.seed(seed);
+}
+
 bool playerGreaterForWin(const Player& a, const Player& b)
 {
   return a.stack - a.buyInTotal > b.stack - b.buyInTotal;
@@ -715,22 +714,22 @@ void Game::declareWinners(Table& table)
   {
     // replace endl with \n
     if(pos == 1) std::cout << "Winner: " << playerCopy[0].getName() << " (AI: " << playerCopy[0].ai->getAIName() << ")\n";
-    events.push_back(Event(E_TOURNAMENT_RANK
+    events.push(Event(E_TOURNAMENT_RANK
                          , pos
                          , playerCopy[i].stack - playerCopy[i].buyInTotal
-                         , playerCopy[i].getName()));
-    events.push_back(Event(E_REVEAL_AI, playerCopy[i].getName(), playerCopy[i].getAIName()));
+                         , NameId(playerCopy[i].nameId)));
+    events.push(Event(E_REVEAL_AI, NameId(playerCopy[i].nameId), playerCopy[i].getAIName()));
     pos++;
   }
 
   for(size_t i = 0; i < playersOut.size(); i++)
   {
     size_t j = playersOut.size() - 1 - i;
-    events.push_back(Event(E_TOURNAMENT_RANK
+    events.push(Event(E_TOURNAMENT_RANK
                          , pos
                          , playersOut[j].stack - playersOut[j].buyInTotal
-                         , playersOut[j].getName()));
-    events.push_back(Event(E_REVEAL_AI, playersOut[j].getName(), playersOut[j].getAIName()));
+                         , NameId(playersOut[j].nameId)));
+    events.push(Event(E_REVEAL_AI, NameId(playersOut[j].nameId), playersOut[j].getAIName()));
     pos++;
   }
 
@@ -766,7 +765,7 @@ void Game::doGame()
   // replcae endl with \n
   ss << "The game begins. The AI's of the players are: \n";
   for(size_t i = 0; i < players.size(); i++) ss << table.players[i].getName() << ": " << table.players[i].ai->getAIName() << "\n";
-  events.push_back(Event(ss.str(), E_LOG_MESSAGE));
+  events.push(Event(ss.str(), E_LOG_MESSAGE));
 
   sendEvents(table);
 
@@ -783,10 +782,14 @@ void Game::doGame()
 
   sendEvents(table);
 
+  //observers that run on their own thread must have seen the whole game before it's declared done
+  for(size_t i = 0; i < observers.size(); i++) observers[i]->flush();
+
   host->onGameDone(getInfoForPlayers(table));
-  events.push_back(Event(statisticsToString(o_stat_keeper->getStatKeeper()), E_LOG_MESSAGE));
+  events.push(Event(statisticsToString(o_stat_keeper->getStatKeeper()), E_LOG_MESSAGE));
 
   sendEvents(table);
+  for(size_t i = 0; i < observers.size(); i++) observers[i]->flush();
 }
 
 void Game::addPlayer(const Player& player)
@@ -24,7 +24,10 @@ along with OOPoker.  If not, see <http://www.gnu.org/licenses/>.
 
 #include <vector>
 
+#include "deck.h"
+#include "eventring.h"
 #include "info.h"
+#include "random.h"
 
 
 //forward declarations
@@ -32,7 +35,6 @@ class Host;
 class Table;
 struct Player;
 class Observer;
-struct Event;
 
 void makeInfo(Info& info, const Table& table, const Rules& rules, int playerViewPoint);
 
@@ -48,7 +50,7 @@ class Game
 
     std::vector<Player> players;
     std::vector<Observer*> observers;
-    std::vector<Event> events;
+    EventRing events; //events not sent yet, the ring reuses the room of sent ones
 
     size_t eventCounter;
     int numDeals; //how much deals are done since the game started
@@ -57,12 +59,15 @@ class Game
     
     Info infoForPlayers; //this is to speed up the game a lot, by not recreating the Info object everytime
 
+    ShuffleMode shuffleMode;
+    RandomStream shuffleRandom; //only used with SHUFFLE_FAST
+
   protected:
     void settleBets(Table& table, Rules& rules);
     void kickOutPlayers(Table& table);
     void declareWinners(Table& table);
     void sendEvents(Table& table);
-    const Info& getInfoForPlayers(Table& table, int viewPoint = -1); //rather heavy-weight function! Copies entire Info object.
+    const Info& getInfoForPlayers(Table& table, int viewPoint = -1); //fills in infoForPlayers, see makeInfo. The result is only valid until the next call.
 
   public:
 
@@ -73,6 +78,11 @@ class Game
     void addPlayer(const Player& player);
     void addObserver(Observer* observer);
     void setRules(const Rules& rules);
+    /*
+    How the deck is shuffled (and the first dealer chosen). Default is SHUFFLE_SECURE. With SHUFFLE_FAST, the
+    seed determines all deals, so running the same game again with the same seed and AI's gives the same game.
+    */
+    void setShuffleMode(ShuffleMode mode, uint64_t seed = 0);
 
     void runTable(Table& table);
 
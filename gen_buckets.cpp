@@ -0,0 +1,357 @@
+/*
+OOPoker
+
+Copyright (c) 2010 Lode Vandevenne
+All rights reserved.
+
+This file is part of OOPoker.
+
+OOPoker is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+OOPoker is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with OOPoker.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+/*
+Offline generator of the card abstraction table used by buckets.h.
+
+Usage: gen_buckets [output file] [pre-flop buckets] [flop buckets] [turn buckets] [river buckets] [training states]
+Defaults: buckets.dat, 169, 64, 64, 64, 100000. Bucket amounts are at most 256.
+
+1. The hand strength (HS) of every river state: the chance to win plus half the chance to tie against one
+   random hand. Only one board of every suit-isomorphic class of boards is needed, and on each of them the
+   RiverRanker gives the HS of all hole cards at once. Kept as 16-bit value per canonical river index.
+2. River buckets: k-means on the HS, which at the river is all there is to know.
+3. Turn, flop and pre-flop: per state the histogram of the river HS over all ways to complete the board.
+   Its mean is the expected hand strength (EHS) and its second moment EHS^2, but unlike those the whole
+   histogram also separates draws from made hands with the same EHS. These are clustered with k-means
+   using the earth mover's distance (EMD), which for histograms over one dimension is the L1 distance
+   between their cumulative histograms. The centers are trained on a random sample of states (the
+   centers are the mean of their cumulative histograms), and then every state is assigned to the
+   nearest center.
+
+Every canonical state counts once in the clustering, no matter how many card combinations it stands for.
+The buckets of each round are sorted by their mean HS, so bucket 0 is the weakest. The random generator
+is seeded with fixed values, so the output is reproducible.
+*/
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <stdint.h>
+#include <vector>
+
+#include "buckets.h"
+#include "isomorphism.h"
+#include "pokermath.h"
+#include "random.h"
+#include "riverranker.h"
+#include "threadpool.h"
+
+static const int NUMBINS = 50; //bins of the HS histograms
+static const int ITERATIONS = 30; //of k-means
+static const int CHUNK = 4096; //states per task of the thread pool
+
+typedef std::vector<float> Histogram; //cumulative, NUMBINS values
+
+//runs f(begin, end) on chunks of [0, n) on the thread pool
+template<typename F>
+static void forChunks(CanonicalIndex n, const F& f)
+{
+  int numChunks = (int)((n + CHUNK - 1) / CHUNK);
+  getThreadPool().run(numChunks, [&](int chunk)
+  {
+    CanonicalIndex begin = (CanonicalIndex)chunk * CHUNK;
+    f(begin, std::min(n, begin + CHUNK));
+  });
+}
+
+//whether the sorted board is the smallest of all boards that it can become by renaming the suits
+static bool isCanonicalBoard(const int* board /*5 sorted eval7 indices*/)
+{
+  int perm[4] = { 0, 1, 2, 3 };
+  do
+  {
+    int other[5];
+    for(int i = 0; i < 5; i++) other[i] = perm[board[i] / 13] * 13 + board[i] % 13;
+    std::sort(other, other + 5);
+    if(std::lexicographical_compare(other, other + 5, board, board + 5)) return false;
+  } while(std::next_permutation(perm, perm + 4));
+  return true;
+}
+
+static void computeRiverStrength(std::vector<uint16_t>& strength)
+{
+  strength.assign(getCanonicalSize(R_RIVER), 0);
+
+  std::vector<uint64_t> boards;
+  for(int b0 = 0; b0 < 52; b0++)
+  for(int b1 = b0 + 1; b1 < 52; b1++)
+  for(int b2 = b1 + 1; b2 < 52; b2++)
+  for(int b3 = b2 + 1; b3 < 52; b3++)
+  for(int b4 = b3 + 1; b4 < 52; b4++)
+  {
+    int board[5] = { b0, b1, b2, b3, b4 };
+    if(!isCanonicalBoard(board)) continue;
+    boards.push_back((uint64_t)b0 | (uint64_t)b1 << 8 | (uint64_t)b2 << 16 | (uint64_t)b3 << 24 | (uint64_t)b4 << 32);
+  }
+  std::cout << boards.size() << " boards" << std::endl;
+
+  //different boards are never the same state, so the tasks don't write to the same entries
+  std::vector<float> uniform(NUM_COMBOS, 1.0f);
+  forChunks(boards.size(), [&](CanonicalIndex begin, CanonicalIndex end)
+  {
+    RiverRanker ranker;
+    std::vector<double> equity(NUM_COMBOS), total(NUM_COMBOS);
+    for(CanonicalIndex i = begin; i < end; i++)
+    {
+      int cards[7];
+      uint64_t mask = 0;
+      for(int j = 0; j < 5; j++)
+      {
+        cards[2 + j] = (int)((boards[i] >> (8 * j)) & 255);
+        mask |= eval7_mask(Card(cards[2 + j] % 13 + 2, (Suit)(cards[2 + j] / 13)));
+      }
+      ranker.setBoard(mask);
+      ranker.getShowdown(&equity[0], &total[0], &uniform[0]);
+      for(int j = 0; j < ranker.getSize(); j++)
+      {
+        int combo = ranker.getCombo(j);
+        getComboCards(cards[0], cards[1], combo);
+        strength[getCanonicalIndex(cards, 7)] = (uint16_t)(equity[combo] / total[combo] * 65535.0 + 0.5);
+      }
+    }
+  });
+}
+
+//1-dimensional k-means on the river HS, through a histogram of the 65536 possible values
+static void clusterRiver(std::vector<unsigned char>& buckets, const std::vector<uint16_t>& strength, int k)
+{
+  std::vector<double> count(65536, 0.0);
+  for(size_t i = 0; i < strength.size(); i++) count[strength[i]]++;
+
+  //start at evenly spaced quantiles
+  std::vector<double> centers(k);
+  double sum = 0.0;
+  for(int v = 0, c = 0; v < 65536 && c < k; v++)
+  {
+    sum += count[v];
+    while(c < k && sum >= (c + 0.5) * strength.size() / k) centers[c++] = v;
+  }
+
+  std::vector<int> nearest(65536);
+  for(int iteration = 0; iteration < ITERATIONS; iteration++)
+  {
+    std::sort(centers.begin(), centers.end());
+    std::vector<double> sums(k, 0.0), counts(k, 0.0);
+    int c = 0;
+    for(int v = 0; v < 65536; v++)
+    {
+      while(c + 1 < k && std::abs(centers[c + 1] - v) <= std::abs(centers[c] - v)) c++;
+      nearest[v] = c;
+      sums[c] += count[v] * v;
+      counts[c] += count[v];
+    }
+    for(int j = 0; j < k; j++) if(counts[j] > 0) centers[j] = sums[j] / counts[j];
+  }
+
+  buckets.resize(strength.size());
+  for(size_t i = 0; i < strength.size(); i++) buckets[i] = (unsigned char)nearest[strength[i]];
+}
+
+//cumulative histogram of the river HS of the state over all ways to complete the board
+static void getHistogram(float* result, const std::vector<uint16_t>& strength, Round round, CanonicalIndex index)
+{
+  int cards[7];
+  getCanonicalCards(cards, round, index);
+  int numCards = round == R_PRE_FLOP ? 2 : round + 4;
+
+  bool used[52] = { false };
+  for(int i = 0; i < numCards; i++) used[cards[i]] = true;
+  int others[52];
+  int numOthers = 0;
+  for(int i = 0; i < 52; i++) if(!used[i]) others[numOthers++] = i;
+
+  unsigned counts[NUMBINS] = { 0 };
+  unsigned total = 0;
+  int missing = 7 - numCards;
+  int pos[5];
+  for(int i = 0; i < missing; i++) pos[i] = i;
+  for(;;) //all combinations of missing out of the other cards
+  {
+    for(int i = 0; i < missing; i++) cards[numCards + i] = others[pos[i]];
+    counts[strength[getCanonicalIndex(cards, 7)] * NUMBINS / 65536]++;
+    total++;
+
+    int i = missing - 1;
+    while(i >= 0 && pos[i] == numOthers - missing + i) i--;
+    if(i < 0) break;
+    pos[i]++;
+    for(int j = i + 1; j < missing; j++) pos[j] = pos[j - 1] + 1;
+  }
+
+  unsigned running = 0;
+  for(int b = 0; b < NUMBINS; b++)
+  {
+    running += counts[b];
+    result[b] = (float)running / total;
+  }
+}
+
+static float getDistance(const float* a, const float* b) //EMD, in bins
+{
+  float result = 0.0f;
+  for(int i = 0; i < NUMBINS; i++) result += std::abs(a[i] - b[i]);
+  return result;
+}
+
+static int getNearest(const float* histogram, const std::vector<Histogram>& centers)
+{
+  int best = 0;
+  float bestDistance = getDistance(histogram, &centers[0][0]);
+  for(size_t c = 1; c < centers.size(); c++)
+  {
+    float d = getDistance(histogram, &centers[c][0]);
+    if(d < bestDistance) { bestDistance = d; best = (int)c; }
+  }
+  return best;
+}
+
+static float getMean(const Histogram& histogram) //mean HS of a cumulative histogram, in range 0.0-1.0
+{
+  float result = 0.0f;
+  for(int b = 0; b < NUMBINS; b++) result += (1.0f - histogram[b]) / NUMBINS;
+  return result;
+}
+
+//k-means++ initialization, then Lloyd iterations
+static void trainCenters(std::vector<Histogram>& centers, const std::vector<Histogram>& samples, int k, RandomStream& random)
+{
+  centers.clear();
+  centers.push_back(samples[random.nextInt(0, (int)samples.size() - 1)]);
+  std::vector<double> distance(samples.size(), 1e30);
+  while((int)centers.size() < k)
+  {
+    double sum = 0.0;
+    for(size_t i = 0; i < samples.size(); i++)
+    {
+      double d = getDistance(&samples[i][0], &centers.back()[0]);
+      distance[i] = std::min(distance[i], d * d);
+      sum += distance[i];
+    }
+    if(sum <= 0.0) break; //fewer different histograms than k
+    double x = random.nextDouble() * sum;
+    size_t chosen = 0;
+    while(chosen + 1 < samples.size() && x >= distance[chosen]) x -= distance[chosen++];
+    centers.push_back(samples[chosen]);
+  }
+
+  std::vector<int> nearest(samples.size());
+  for(int iteration = 0; iteration < ITERATIONS; iteration++)
+  {
+    forChunks(samples.size(), [&](CanonicalIndex begin, CanonicalIndex end)
+    {
+      for(CanonicalIndex i = begin; i < end; i++) nearest[i] = getNearest(&samples[i][0], centers);
+    });
+
+    std::vector<Histogram> sums(centers.size(), Histogram(NUMBINS, 0.0f));
+    std::vector<int> counts(centers.size(), 0);
+    for(size_t i = 0; i < samples.size(); i++)
+    {
+      for(int b = 0; b < NUMBINS; b++) sums[nearest[i]][b] += samples[i][b];
+      counts[nearest[i]]++;
+    }
+    for(size_t c = 0; c < centers.size(); c++)
+    {
+      if(counts[c] == 0) continue; //keeps its old position
+      for(int b = 0; b < NUMBINS; b++) centers[c][b] = sums[c][b] / counts[c];
+    }
+  }
+
+  std::sort(centers.begin(), centers.end(), [](const Histogram& a, const Histogram& b) { return getMean(a) < getMean(b); });
+}
+
+static int clusterRound(std::vector<unsigned char>& buckets, const std::vector<uint16_t>& strength, Round round, int k, int trainingStates, RandomStream& random)
+{
+  CanonicalIndex size = getCanonicalSize(round);
+
+  std::vector<CanonicalIndex> indices;
+  if((CanonicalIndex)trainingStates >= size) for(CanonicalIndex i = 0; i < size; i++) indices.push_back(i);
+  else for(int i = 0; i < trainingStates; i++) indices.push_back(((CanonicalIndex)random.next()) % size);
+
+  std::vector<Histogram> samples(indices.size(), Histogram(NUMBINS));
+  forChunks(indices.size(), [&](CanonicalIndex begin, CanonicalIndex end)
+  {
+    for(CanonicalIndex i = begin; i < end; i++) getHistogram(&samples[i][0], strength, round, indices[i]);
+  });
+
+  std::vector<Histogram> centers;
+  trainCenters(centers, samples, k, random);
+
+  buckets.resize(size);
+  if(indices.size() == size) //all states were in the training set already
+  {
+    for(CanonicalIndex i = 0; i < size; i++) buckets[i] = (unsigned char)getNearest(&samples[i][0], centers);
+    return (int)centers.size();
+  }
+  forChunks(size, [&](CanonicalIndex begin, CanonicalIndex end)
+  {
+    float histogram[NUMBINS];
+    for(CanonicalIndex i = begin; i < end; i++)
+    {
+      getHistogram(histogram, strength, round, i);
+      buckets[i] = (unsigned char)getNearest(histogram, centers);
+    }
+  });
+
+  return (int)centers.size();
+}
+
+int main(int argc, char* argv[])
+{
+  std::string filename = argc > 1 ? argv[1] : "buckets.dat";
+  int numBuckets[BUCKET_ROUNDS] = { 169, 64, 64, 64 };
+  for(int r = 0; r < BUCKET_ROUNDS; r++)
+  {
+    if(argc > 2 + r) numBuckets[r] = std::atoi(argv[2 + r]);
+    numBuckets[r] = std::max(1, std::min(MAX_BUCKETS, numBuckets[r]));
+  }
+  int trainingStates = argc > 6 ? std::atoi(argv[6]) : 100000;
+  if(trainingStates < 1) trainingStates = 1;
+
+  RandomStream random(1);
+  std::vector<unsigned char> buckets[BUCKET_ROUNDS];
+  std::vector<uint16_t> strength;
+
+  std::cout << "computing river hand strength with " << getThreadPool().getNumThreads() << " threads" << std::endl;
+  computeRiverStrength(strength);
+
+  std::cout << "clustering river into " << numBuckets[R_RIVER] << " buckets" << std::endl;
+  clusterRiver(buckets[R_RIVER], strength, numBuckets[R_RIVER]);
+
+  const char* names[3] = { "pre-flop", "flop", "turn" };
+  for(int r = R_TURN; r >= R_PRE_FLOP; r--)
+  {
+    std::cout << "clustering " << names[r] << " into " << numBuckets[r] << " buckets" << std::endl;
+    numBuckets[r] = clusterRound(buckets[r], strength, (Round)r, numBuckets[r], trainingStates, random);
+  }
+
+  if(!writeBucketTable(filename, buckets, numBuckets))
+  {
+    std::cout << "error writing " << filename << std::endl;
+    return 1;
+  }
+
+  std::cout << "written " << filename << std::endl;
+  return 0;
+}
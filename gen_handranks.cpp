@@ -0,0 +1,57 @@
+/*
+OOPoker
+
+Copyright (c) 2010 Lode Vandevenne
+All rights reserved.
+
+This file is part of OOPoker.
+
+OOPoker is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+OOPoker is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with OOPoker.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/*
+Offline generator of the handranks.dat file used by the 7-card evaluator of pokereval.h.
+
+Usage: gen_handranks [output file] [--compact]
+Default output file is handranks.dat. With --compact, the smaller format with 16-bit leaves is written.
+
+The file is written atomically, so processes that are using the old file (it's memory-mapped) keep
+working, and only new processes see the new file.
+*/
+
+#include <iostream>
+#include <string>
+
+#include "pokereval.h"
+
+int main(int argc, char* argv[])
+{
+  std::string filename = "handranks.dat";
+  PokerEval::HandRanksFormat format = PokerEval::HR_FORMAT_FULL;
+  for(int i = 1; i < argc; i++)
+  {
+    std::string arg = argv[i];
+    if(arg == "--compact") format = PokerEval::HR_FORMAT_COMPACT;
+    else filename = arg;
+  }
+
+  if(!PokerEval::generateHandRanksFile(filename, format) || !PokerEval::checkHandRanksFile(filename))
+  {
+    std::cout << "error writing " << filename << std::endl;
+    return 1;
+  }
+
+  std::cout << "written " << filename << std::endl;
+  return 0;
+}
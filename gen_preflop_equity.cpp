@@ -0,0 +1,280 @@
+/*
+OOPoker
+
+Copyright (c) 2010 Lode Vandevenne
+All rights reserved.
+
+This file is part of OOPoker.
+
+OOPoker is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+OOPoker is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with OOPoker.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/*
+Offline generator of the pre-flop equity table used by equity.h.
+
+Usage: gen_preflop_equity [output file] [samples]
+Default output file is preflop_equity.dat, default samples is 1000000.
+
+Heads-up (1 opponent) is computed exactly: every board is enumerated once, all hands that are possible
+on it are ranked and sorted, and from the sorted order every hand gets its amount of wins, ties and
+losses against all opponent hands at once (removing the opponent hands that share a card with it).
+
+For 2-9 opponents an exact enumeration isn't feasible, so those entries are Monte Carlo simulations
+with the given amount of samples per entry (standard error of about 0.0005 with the default).
+The random generator is seeded with fixed values, so the output is reproducible.
+*/
+
+#include <algorithm>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include "card.h"
+#include "equity.h"
+#include "pokereval2.h"
+
+static const int NUMHANDS = 1326;
+
+struct RankedHand
+{
+  unsigned rank;
+  int card1;
+  int card2;
+  int hand;
+
+  bool operator<(const RankedHand& other) const { return rank < other.rank; }
+};
+
+//in eval7 indices: suit * 13 + value - 2
+static Card toCard(int index)
+{
+  return Card(index % 13 + 2, (Suit)(index / 13));
+}
+
+/*
+Counts wins, ties and losses of each of the 1326 hands against each other hand, over all boards
+whose first card is in [firstBegin, firstEnd).
+*/
+static void countHeadsUp(std::vector<unsigned long long>& counts /*NUMHANDS * 3*/, int firstBegin, int firstEnd, const int handIndex[52][52])
+{
+  std::vector<RankedHand> hands;
+  hands.reserve(NUMHANDS);
+  int lessCard[52];
+  int equalCard[52];
+
+  for(int b0 = firstBegin; b0 < firstEnd; b0++)
+  for(int b1 = b0 + 1; b1 < 52; b1++)
+  for(int b2 = b1 + 1; b2 < 52; b2++)
+  for(int b3 = b2 + 1; b3 < 52; b3++)
+  for(int b4 = b3 + 1; b4 < 52; b4++)
+  {
+    PokerEval2::HandMask board = PokerEval2::HandMasksTable[b0] | PokerEval2::HandMasksTable[b1] | PokerEval2::HandMasksTable[b2]
+                               | PokerEval2::HandMasksTable[b3] | PokerEval2::HandMasksTable[b4];
+
+    hands.clear();
+    for(int a = 0; a < 52; a++)
+    {
+      if(board & PokerEval2::HandMasksTable[a]) continue;
+      for(int b = a + 1; b < 52; b++)
+      {
+        if(board & PokerEval2::HandMasksTable[b]) continue;
+        RankedHand h;
+        h.rank = PokerEval2::RankHand(board | PokerEval2::HandMasksTable[a] | PokerEval2::HandMasksTable[b]);
+        h.card1 = a;
+        h.card2 = b;
+        h.hand = handIndex[a][b];
+        hands.push_back(h);
+      }
+    }
+    std::sort(hands.begin(), hands.end());
+
+    //go through groups of equal rank from low to high, keeping track of how many lower hands contain each card
+    int lessTotal = 0;
+    std::fill(lessCard, lessCard + 52, 0);
+    std::fill(equalCard, equalCard + 52, 0);
+    for(size_t i = 0; i < hands.size();)
+    {
+      size_t j = i;
+      while(j < hands.size() && hands[j].rank == hands[i].rank)
+      {
+        equalCard[hands[j].card1]++;
+        equalCard[hands[j].card2]++;
+        j++;
+      }
+      int equalTotal = (int)(j - i);
+
+      for(size_t k = i; k < j; k++)
+      {
+        const RankedHand& h = hands[k];
+        int less = lessTotal - lessCard[h.card1] - lessCard[h.card2];
+        int equal = equalTotal - equalCard[h.card1] - equalCard[h.card2] + 1; //+1 because the hand itself is subtracted twice
+        int greater = 990 - less - equal; //990 = possible opponent hands with 7 known cards
+        counts[h.hand * 3 + 0] += less;
+        counts[h.hand * 3 + 1] += equal;
+        counts[h.hand * 3 + 2] += greater;
+      }
+
+      lessTotal += equalTotal;
+      for(size_t k = i; k < j; k++)
+      {
+        lessCard[hands[k].card1]++;
+        lessCard[hands[k].card2]++;
+        equalCard[hands[k].card1] = 0;
+        equalCard[hands[k].card2] = 0;
+      }
+      i = j;
+    }
+  }
+}
+
+//Monte Carlo simulation of hand (card1, card2) against numOpponents random hands. result gets win, tie, lose, equity.
+static void simulate(float* result, int card1, int card2, int numOpponents, unsigned long long samples, unsigned seed)
+{
+  std::mt19937 rng(seed);
+
+  int others[50];
+  int n = 0;
+  for(int i = 0; i < 52; i++) if(i != card1 && i != card2) others[n++] = i;
+
+  PokerEval2::HandMask hand = PokerEval2::HandMasksTable[card1] | PokerEval2::HandMasksTable[card2];
+  int amount = 5 + 2 * numOpponents;
+
+  unsigned long long wins = 0, ties = 0, losses = 0;
+  double equity = 0.0;
+
+  for(unsigned long long s = 0; s < samples; s++)
+  {
+    for(int i = 0; i < amount; i++)
+    {
+      int r = i + (int)(rng() % (unsigned)(50 - i));
+      std::swap(others[i], others[r]);
+    }
+
+    PokerEval2::HandMask board = 0;
+    for(int i = 0; i < 5; i++) board |= PokerEval2::HandMasksTable[others[i]];
+
+    unsigned yourVal = PokerEval2::RankHand(board | hand);
+    int numTied = 0;
+    bool lost = false;
+    for(int j = 0; j < numOpponents; j++)
+    {
+      unsigned opponentVal = PokerEval2::RankHand(board | PokerEval2::HandMasksTable[others[5 + j * 2]] | PokerEval2::HandMasksTable[others[6 + j * 2]]);
+      if(opponentVal > yourVal) { lost = true; break; }
+      else if(opponentVal == yourVal) numTied++;
+    }
+
+    if(lost) losses++;
+    else if(numTied > 0) { ties++; equity += 1.0 / (1 + numTied); }
+    else { wins++; equity += 1.0; }
+  }
+
+  result[0] = (float)((double)wins / samples);
+  result[1] = (float)((double)ties / samples);
+  result[2] = (float)((double)losses / samples);
+  result[3] = (float)(equity / samples);
+}
+
+int main(int argc, char* argv[])
+{
+  std::string filename = argc > 1 ? argv[1] : "preflop_equity.dat";
+  unsigned long long samples = argc > 2 ? std::strtoull(argv[2], 0, 10) : 1000000;
+  if(samples == 0) samples = 1;
+
+  PokerEval2::InitializeHandRankingTables();
+
+  int numThreads = (int)std::thread::hardware_concurrency();
+  if(numThreads < 1) numThreads = 1;
+
+  int handIndex[52][52];
+  int handClass[NUMHANDS];
+  int classCard1[PREFLOP_EQUITY_HANDS], classCard2[PREFLOP_EQUITY_HANDS]; //a representative hand of each class
+  int n = 0;
+  for(int a = 0; a < 52; a++)
+  for(int b = a + 1; b < 52; b++)
+  {
+    handIndex[a][b] = n;
+    int c = getStartingHandIndex(toCard(a), toCard(b));
+    handClass[n] = c;
+    classCard1[c] = a;
+    classCard2[c] = b;
+    n++;
+  }
+
+  std::vector<float> values(PREFLOP_EQUITY_HANDS * PREFLOP_EQUITY_OPPONENTS * PREFLOP_EQUITY_VALUES);
+
+  std::cout << "computing heads-up equities exactly with " << numThreads << " threads" << std::endl;
+  {
+    std::vector<std::vector<unsigned long long> > counts(numThreads, std::vector<unsigned long long>(NUMHANDS * 3, 0));
+    std::vector<std::thread> threads;
+    for(int t = 0; t < numThreads; t++)
+    {
+      //the first board card determines the amount of work, so interleave the first cards over the threads
+      threads.push_back(std::thread([&counts, &handIndex, t, numThreads]()
+      {
+        for(int first = t; first < 48; first += numThreads) countHeadsUp(counts[t], first, first + 1, handIndex);
+      }));
+    }
+    for(size_t t = 0; t < threads.size(); t++) threads[t].join();
+
+    std::vector<unsigned long long> classCounts(PREFLOP_EQUITY_HANDS * 3, 0);
+    for(int t = 0; t < numThreads; t++)
+    for(int h = 0; h < NUMHANDS; h++)
+    for(int i = 0; i < 3; i++)
+    {
+      classCounts[handClass[h] * 3 + i] += counts[t][h * 3 + i];
+    }
+
+    for(int c = 0; c < PREFLOP_EQUITY_HANDS; c++)
+    {
+      double total = (double)(classCounts[c * 3 + 0] + classCounts[c * 3 + 1] + classCounts[c * 3 + 2]);
+      float* v = &values[(c * PREFLOP_EQUITY_OPPONENTS + 0) * PREFLOP_EQUITY_VALUES];
+      v[0] = (float)(classCounts[c * 3 + 0] / total);
+      v[1] = (float)(classCounts[c * 3 + 1] / total);
+      v[2] = (float)(classCounts[c * 3 + 2] / total);
+      v[3] = (float)((classCounts[c * 3 + 0] + classCounts[c * 3 + 1] * 0.5) / total);
+    }
+  }
+
+  std::cout << "simulating 2-" << PREFLOP_EQUITY_OPPONENTS << " opponents with " << samples << " samples per entry" << std::endl;
+  {
+    std::vector<std::thread> threads;
+    for(int t = 0; t < numThreads; t++)
+    {
+      threads.push_back(std::thread([&, t]()
+      {
+        for(int c = t; c < PREFLOP_EQUITY_HANDS; c += numThreads)
+        for(int o = 2; o <= PREFLOP_EQUITY_OPPONENTS; o++)
+        {
+          float* v = &values[(c * PREFLOP_EQUITY_OPPONENTS + o - 1) * PREFLOP_EQUITY_VALUES];
+          simulate(v, classCard1[c], classCard2[c], o, samples, (unsigned)(c * 16 + o));
+        }
+      }));
+    }
+    for(size_t t = 0; t < threads.size(); t++) threads[t].join();
+  }
+
+  if(!writePreFlopEquityTable(filename, values, 1, samples))
+  {
+    std::cout << "error writing " << filename << std::endl;
+    return 1;
+  }
+
+  std::cout << "written " << filename << std::endl;
+  int aces = getStartingHandIndex(Card("Ac"), Card("Ad"));
+  std::cout << "AA heads-up equity: " << values[aces * PREFLOP_EQUITY_OPPONENTS * PREFLOP_EQUITY_VALUES + 3] << std::endl;
+
+  return 0;
+}
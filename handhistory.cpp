@@ -0,0 +1,540 @@
+/*
+OOPoker
+
+Copyright (c) 2010 Lode Vandevenne
+All rights reserved.
+
+This file is part of OOPoker.
+
+OOPoker is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+OOPoker is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with OOPoker.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include "handhistory.h"
+
+#include "nametable.h"
+
+#include <cstring>
+#include <fstream>
+
+static const unsigned HAND_HISTORY_VERSION = 1;
+
+struct HandHistoryBlockHeader
+{
+  char magic[4]; //"OOHH"
+  unsigned version;
+  unsigned numDeals;
+  unsigned numEvents;
+  unsigned namesSize;
+  unsigned eventsSize;
+  unsigned checksum;
+  unsigned padding;
+};
+
+//which values of the Event each type uses, see the comments of the EventType enum
+enum
+{
+  HH_PLAYER = 1,
+  HH_CHIPS = 2,
+  HH_POSITION = 4,
+  HH_BLINDS = 8, //smallBlind, bigBlind and ante
+  HH_AI = 16,
+  HH_MESSAGE = 32
+};
+
+struct HandHistoryLayout
+{
+  int values;
+  int numCards; //card1 to card<numCards>
+};
+
+static const HandHistoryLayout HH_LAYOUT[E_NUM_EVENTS] =
+{
+  { HH_PLAYER | HH_CHIPS, 0 }, //E_JOIN
+  { HH_PLAYER | HH_CHIPS, 0 }, //E_QUIT
+  { HH_PLAYER | HH_CHIPS, 0 }, //E_REBUY
+  { HH_PLAYER | HH_CHIPS, 0 }, //E_SMALL_BLIND
+  { HH_PLAYER | HH_CHIPS, 0 }, //E_BIG_BLIND
+  { HH_PLAYER | HH_CHIPS, 0 }, //E_ANTE
+  { HH_PLAYER, 0 }, //E_FOLD
+  { HH_PLAYER, 0 }, //E_CHECK
+  { HH_PLAYER, 0 }, //E_CALL
+  { HH_PLAYER | HH_CHIPS, 0 }, //E_RAISE
+  { HH_BLINDS, 0 }, //E_NEW_DEAL
+  { HH_PLAYER, 2 }, //E_RECEIVE_CARDS
+  { 0, 3 }, //E_FLOP
+  { 0, 4 }, //E_TURN
+  { 0, 5 }, //E_RIVER
+  { 0, 0 }, //E_SHOWDOWN
+  { HH_CHIPS, 0 }, //E_POT_DIVISION
+  { HH_PLAYER, 2 }, //E_PLAYER_SHOWDOWN
+  { HH_PLAYER, 2 }, //E_BOAST
+  { HH_PLAYER, 5 }, //E_COMBINATION
+  { HH_PLAYER | HH_CHIPS, 0 }, //E_WIN
+  { HH_PLAYER, 0 }, //E_DEALER
+  { HH_PLAYER | HH_POSITION | HH_CHIPS, 0 }, //E_TOURNAMENT_RANK
+  { HH_PLAYER | HH_AI, 0 }, //E_REVEAL_AI
+  { HH_MESSAGE, 0 }, //E_LOG_MESSAGE
+  { HH_MESSAGE, 0 } //E_DEBUG_MESSAGE
+};
+
+static void writeVarint(std::vector<unsigned char>& data, unsigned value)
+{
+  while(value >= 128)
+  {
+    data.push_back((unsigned char)(value | 128));
+    value >>= 7;
+  }
+  data.push_back((unsigned char)value);
+}
+
+static void writeSigned(std::vector<unsigned char>& data, int value) //zigzag, so that small negative values stay small too
+{
+  writeVarint(data, ((unsigned)value << 1) ^ (unsigned)(value >> 31));
+}
+
+static void writeString(std::vector<unsigned char>& data, const std::string& s)
+{
+  writeVarint(data, (unsigned)s.size());
+  data.insert(data.end(), s.begin(), s.end());
+}
+
+static void writeCard(std::vector<unsigned char>& data, const Card& card)
+{
+  data.push_back(card.isValid() ? (unsigned char)(card.getIndex() + 1) : 0);
+}
+
+//reads from the bytes at pos up to end, all return false if the data ends too early or is damaged
+static bool readVarint(const unsigned char*& pos, const unsigned char* end, unsigned& value)
+{
+  value = 0;
+  for(int shift = 0; shift < 35; shift += 7)
+  {
+    if(pos == end) return false;
+    unsigned char byte = *pos++;
+    value |= (unsigned)(byte & 127) << shift;
+    if(byte < 128) return true;
+  }
+  return false;
+}
+
+static bool readSigned(const unsigned char*& pos, const unsigned char* end, int& value)
+{
+  unsigned u;
+  if(!readVarint(pos, end, u)) return false;
+  value = (int)(u >> 1) ^ -(int)(u & 1);
+  return true;
+}
+
+static bool readString(const unsigned char*& pos, const unsigned char* end, std::string& s)
+{
+  unsigned size;
+  if(!readVarint(pos, end, size) || size > (size_t)(end - pos)) return false;
+  s.assign((const char*)pos, size);
+  pos += size;
+  return true;
+}
+
+static bool readCard(const unsigned char*& pos, const unsigned char* end, Card& card)
+{
+  if(pos == end || *pos > 52) return false;
+  if(*pos == 0) card = Card();
+  else card = Card(*pos - 1);
+  pos++;
+  return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+HandHistoryWriter::HandHistoryWriter()
+: file(0)
+, blockSize(64)
+, numEvents(0)
+, writing(false)
+, failed(false)
+, quit(false)
+{
+}
+
+HandHistoryWriter::~HandHistoryWriter()
+{
+  close();
+}
+
+bool HandHistoryWriter::open(const std::string& filename)
+{
+  close();
+  file = fopen(filename.c_str(), "ab");
+  if(!file) return false;
+  failed = false;
+  quit = false;
+  thread = std::thread(&HandHistoryWriter::run, this);
+  return true;
+}
+
+void HandHistoryWriter::close()
+{
+  if(!file) return;
+  flush();
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    quit = true;
+  }
+  wake.notify_one();
+  thread.join();
+  fclose(file);
+  file = 0;
+}
+
+bool HandHistoryWriter::isOpen() const
+{
+  return file != 0;
+}
+
+void HandHistoryWriter::setBlockSize(size_t deals)
+{
+  blockSize = deals < 1 ? 1 : deals;
+}
+
+void HandHistoryWriter::add(const Event& event)
+{
+  if(!file || event.type < 0 || event.type >= E_NUM_EVENTS) return;
+
+  if(event.type == E_NEW_DEAL || dealOffsets.empty())
+  {
+    if(dealOffsets.size() >= blockSize) endBlock();
+    if(event.type == E_NEW_DEAL || dealOffsets.empty()) dealOffsets.push_back((unsigned)events.size());
+  }
+
+  const HandHistoryLayout& layout = HH_LAYOUT[event.type];
+  writeVarint(events, (unsigned)event.type);
+  if(layout.values & HH_PLAYER)
+  {
+    int id = event.playerId;
+    if(id < 0) writeVarint(events, 0);
+    else
+    {
+      if(id >= (int)nameIndex.size()) nameIndex.resize(id + 1, -1);
+      if(nameIndex[id] < 0)
+      {
+        nameIndex[id] = (int)usedNames.size();
+        usedNames.push_back(id);
+        writeString(names, getInternedName(id));
+      }
+      writeVarint(events, (unsigned)nameIndex[id] + 1);
+    }
+  }
+  if(layout.values & HH_CHIPS) writeSigned(events, event.chips);
+  if(layout.values & HH_POSITION) writeSigned(events, event.position);
+  if(layout.values & HH_BLINDS)
+  {
+    writeSigned(events, event.smallBlind);
+    writeSigned(events, event.bigBlind);
+    writeSigned(events, event.ante);
+  }
+  const Card* cards[5] = { &event.card1, &event.card2, &event.card3, &event.card4, &event.card5 };
+  for(int i = 0; i < layout.numCards; i++) writeCard(events, *cards[i]);
+  if(layout.values & HH_AI) writeString(events, event.ai);
+  if(layout.values & HH_MESSAGE) writeString(events, event.message);
+  numEvents++;
+}
+
+void HandHistoryWriter::endBlock()
+{
+  if(dealOffsets.empty()) return;
+
+  HandHistoryBlockHeader header;
+  std::memcpy(header.magic, "OOHH", 4);
+  header.version = HAND_HISTORY_VERSION;
+  header.numDeals = (unsigned)dealOffsets.size();
+  header.numEvents = numEvents;
+  header.namesSize = (unsigned)names.size();
+  header.eventsSize = (unsigned)events.size();
+  header.padding = 0;
+
+  std::vector<unsigned char> block;
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    if(!spare.empty())
+    {
+      block.swap(spare.back());
+      spare.pop_back();
+    }
+  }
+  block.resize(sizeof(header));
+  const unsigned char* offsets = (const unsigned char*)&dealOffsets[0];
+  block.insert(block.end(), offsets, offsets + dealOffsets.size() * 4);
+  block.insert(block.end(), names.begin(), names.end());
+  block.insert(block.end(), events.begin(), events.end());
+  block.resize((block.size() + 3) & ~(size_t)3, 0); //the next header and deal offsets stay aligned
+  header.checksum = getDataChecksum(&block[sizeof(header)], block.size() - sizeof(header));
+  std::memcpy(&block[0], &header, sizeof(header));
+
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    queued.push_back(std::vector<unsigned char>());
+    queued.back().swap(block);
+  }
+  wake.notify_one();
+
+  dealOffsets.clear();
+  names.clear();
+  events.clear();
+  numEvents = 0;
+  for(size_t i = 0; i < usedNames.size(); i++) nameIndex[usedNames[i]] = -1;
+  usedNames.clear();
+}
+
+bool HandHistoryWriter::flush()
+{
+  if(!file) return false;
+  endBlock();
+  std::unique_lock<std::mutex> lock(mutex);
+  written.wait(lock, [this]() { return queued.empty() && !writing; });
+  if(fflush(file) != 0) failed = true;
+  return !failed;
+}
+
+void HandHistoryWriter::run()
+{
+  std::unique_lock<std::mutex> lock(mutex);
+  for(;;)
+  {
+    wake.wait(lock, [this]() { return quit || !queued.empty(); });
+    if(queued.empty()) break; //quit, and everything is written
+
+    std::vector<unsigned char> block;
+    block.swap(queued.front());
+    queued.erase(queued.begin());
+    writing = true;
+
+    lock.unlock();
+    bool success = fwrite(&block[0], 1, block.size(), file) == block.size();
+    lock.lock();
+
+    if(!success) failed = true;
+    writing = false;
+    block.clear(); //keeps its capacity for a next block
+    spare.push_back(std::vector<unsigned char>());
+    spare.back().swap(block);
+    if(queued.empty()) written.notify_all();
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+HandHistoryFile::HandHistoryFile()
+: numDeals(0)
+, numEvents(0)
+{
+}
+
+bool HandHistoryFile::open(const std::string& filename)
+{
+  close();
+  if(!file.open(filename)) return false;
+
+  const unsigned char* data = file.getData();
+  size_t size = file.getSize();
+  size_t pos = 0;
+  while(pos + sizeof(HandHistoryBlockHeader) <= size)
+  {
+    HandHistoryBlockHeader header;
+    std::memcpy(&header, data + pos, sizeof(header));
+    if(std::memcmp(header.magic, "OOHH", 4) != 0 || header.version != HAND_HISTORY_VERSION) break;
+
+    size_t contentSize = (size_t)header.numDeals * 4 + header.namesSize + header.eventsSize;
+    size_t payloadSize = (contentSize + 3) & ~(size_t)3;
+    const unsigned char* payload = data + pos + sizeof(header);
+    if(payloadSize > size - pos - sizeof(header)) break; //incomplete
+    if(getDataChecksum(payload, payloadSize) != header.checksum) break;
+
+    Block block;
+    block.firstDeal = numDeals;
+    block.numDeals = header.numDeals;
+    block.dealOffsets = (const unsigned*)payload;
+    block.events = payload + (size_t)header.numDeals * 4 + header.namesSize;
+    block.eventsSize = header.eventsSize;
+
+    const unsigned char* p = payload + (size_t)header.numDeals * 4;
+    const unsigned char* namesEnd = p + header.namesSize;
+    std::string name;
+    bool valid = header.numDeals > 0 && block.dealOffsets[0] == 0;
+    while(valid && p < namesEnd)
+    {
+      valid = readString(p, namesEnd, name);
+      block.names.push_back(internName(name));
+    }
+    for(unsigned i = 0; valid && i < header.numDeals; i++)
+    {
+      valid = block.dealOffsets[i] <= header.eventsSize && (i == 0 || block.dealOffsets[i] >= block.dealOffsets[i - 1]);
+    }
+    if(!valid) break;
+
+    blocks.push_back(block);
+    numDeals += header.numDeals;
+    numEvents += header.numEvents;
+    pos += sizeof(header) + payloadSize;
+  }
+
+  if(blocks.empty())
+  {
+    close();
+    return false;
+  }
+  return true;
+}
+
+void HandHistoryFile::close()
+{
+  file.close();
+  blocks.clear();
+  numDeals = 0;
+  numEvents = 0;
+}
+
+size_t HandHistoryFile::getNumDeals() const
+{
+  return numDeals;
+}
+
+size_t HandHistoryFile::getNumEvents() const
+{
+  return numEvents;
+}
+
+bool HandHistoryFile::getDeal(size_t index, std::vector<Event>& result) const
+{
+  result.clear();
+  return getDeals(index, 1, result);
+}
+
+bool HandHistoryFile::getDeals(size_t index, size_t amount, std::vector<Event>& result) const
+{
+  if(amount == 0) return true;
+  if(index >= numDeals || amount > numDeals - index) return false;
+
+  //binary search for the last block that starts at or before index
+  size_t lo = 0, hi = blocks.size();
+  while(hi - lo > 1)
+  {
+    size_t mid = (lo + hi) / 2;
+    if(blocks[mid].firstDeal <= index) lo = mid;
+    else hi = mid;
+  }
+
+  for(size_t b = lo; amount > 0; b++)
+  {
+    const Block& block = blocks[b];
+    size_t first = index - block.firstDeal;
+    size_t last = first + amount < block.numDeals ? first + amount : block.numDeals; //deals [first, last) of this block
+    const unsigned char* pos = block.events + block.dealOffsets[first];
+    const unsigned char* end = block.events + (last < block.numDeals ? block.dealOffsets[last] : block.eventsSize);
+
+    while(pos < end)
+    {
+      unsigned type;
+      if(!readVarint(pos, end, type) || type >= E_NUM_EVENTS) return false;
+      result.push_back(Event((EventType)type));
+      Event& event = result.back();
+      event.chips = event.smallBlind = event.bigBlind = event.ante = event.position = 0;
+
+      const HandHistoryLayout& layout = HH_LAYOUT[type];
+      if(layout.values & HH_PLAYER)
+      {
+        unsigned name;
+        if(!readVarint(pos, end, name) || name > block.names.size()) return false;
+        event.playerId = name == 0 ? -1 : block.names[name - 1];
+      }
+      if((layout.values & HH_CHIPS) && !readSigned(pos, end, event.chips)) return false;
+      if((layout.values & HH_POSITION) && !readSigned(pos, end, event.position)) return false;
+      if(layout.values & HH_BLINDS)
+      {
+        if(!readSigned(pos, end, event.smallBlind) || !readSigned(pos, end, event.bigBlind) || !readSigned(pos, end, event.ante)) return false;
+      }
+      Card* cards[5] = { &event.card1, &event.card2, &event.card3, &event.card4, &event.card5 };
+      for(int i = 0; i < layout.numCards; i++)
+      {
+        if(!readCard(pos, end, *cards[i])) return false;
+      }
+      if((layout.values & HH_AI) && !readString(pos, end, event.ai)) return false;
+      if((layout.values & HH_MESSAGE) && !readString(pos, end, event.message)) return false;
+    }
+
+    amount -= last - first;
+    index += last - first;
+  }
+  return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+bool convertTextToHandHistory(const std::string& textFile, const std::string& handHistoryFile)
+{
+  std::ifstream in(textFile.c_str());
+  if(!in) return false;
+  std::remove(handHistoryFile.c_str());
+  HandHistoryWriter writer;
+  if(!writer.open(handHistoryFile)) return false;
+
+  //the text of E_TURN and E_RIVER only has the new card, the earlier ones are taken from the events before
+  Card board[5];
+  Event message(E_LOG_MESSAGE);
+  bool inMessage = false;
+  Event event(E_NUM_EVENTS);
+  std::string line;
+  while(std::getline(in, line))
+  {
+    if(!line.empty() && line[line.size() - 1] == '\r') line.resize(line.size() - 1);
+
+    if(!stringToEvent(event, line))
+    {
+      if(inMessage) message.message += "\n" + line;
+      else message.message = line;
+      inMessage = true;
+      continue;
+    }
+    if(inMessage) writer.add(message);
+    inMessage = false;
+
+    if(event.type == E_FLOP) { board[0] = event.card1; board[1] = event.card2; board[2] = event.card3; }
+    if(event.type == E_TURN || event.type == E_RIVER) { event.card1 = board[0]; event.card2 = board[1]; event.card3 = board[2]; }
+    if(event.type == E_TURN) board[3] = event.card4;
+    if(event.type == E_RIVER) event.card4 = board[3];
+    writer.add(event);
+  }
+  if(inMessage) writer.add(message);
+
+  bool success = writer.flush();
+  writer.close();
+  return success;
+}
+
+bool convertHandHistoryToText(const std::string& handHistoryFile, const std::string& textFile, size_t firstDeal, size_t numDeals)
+{
+  HandHistoryFile history;
+  if(!history.open(handHistoryFile)) return false;
+  std::ofstream out(textFile.c_str());
+  if(!out) return false;
+
+  std::vector<Event> events;
+  if(firstDeal > history.getNumDeals()) firstDeal = history.getNumDeals();
+  size_t end = numDeals < history.getNumDeals() - firstDeal ? firstDeal + numDeals : history.getNumDeals();
+  for(size_t deal = firstDeal; deal < end; deal++)
+  {
+    if(!history.getDeal(deal, events)) return false;
+    for(size_t i = 0; i < events.size(); i++) out << eventToString(events[i]) << "\n";
+  }
+  return (bool)out;
+}
@@ -0,0 +1,157 @@
+/*
+OOPoker
+
+Copyright (c) 2010 Lode Vandevenne
+All rights reserved.
+
+This file is part of OOPoker.
+
+OOPoker is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+OOPoker is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with OOPoker.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#pragma once
+
+#include <condition_variable>
+#include <cstdio>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "event.h"
+#include "mappedfile.h"
+
+/*
+Compact binary hand history: the same events that the log file of ObserverLog has as text, but a lot
+smaller and faster to write and to read back, and indexed by deal so that any deal can be read without
+going through the ones before it.
+
+A deal is the events from an E_NEW_DEAL up to the next one. The events before the first E_NEW_DEAL of a
+game (players joining, ...) are a deal of their own, and so are the events at the start of a block if a
+block was flushed in the middle of a deal. Deals are numbered from 0 in the order of the file.
+
+The file is a sequence of blocks of whole deals. Writers only ever append complete blocks, readers
+memory-map the file, and reading stops at the first block that's incomplete or damaged.
+
+Block format (little endian, header values and deal offsets 4 bytes):
+-header: "OOHH", version, amount of deals D, amount of events, size of the name table N, size of the
+ events E, checksum of the rest of the block, padding
+-D deal offsets: where each deal starts in the events
+-name table, N bytes: the player names used in this block, each as varint length and the characters
+-events, E bytes, padded with zeroes to a multiple of 4: each event is its type as varint, followed by
+ only the values its type uses (see the EventType enum): the player as varint index in the name table,
+ other numbers as zigzag varints, cards as one byte (index + 1, or 0 for no card), strings as varint
+ length and the characters.
+
+The varints and the name table are what make this small (about 4 bytes per event, against 25 as text),
+there is no general purpose compression on top.
+*/
+
+/*
+Appends events to a hand history file. The events are encoded into blocks on the calling thread, which is
+cheap, and a background thread writes the finished blocks to disk, so the game doesn't wait for the disk.
+Not thread safe: all events must come from the same thread.
+*/
+class HandHistoryWriter
+{
+  public:
+    HandHistoryWriter();
+    ~HandHistoryWriter(); //flushes and closes
+
+    bool open(const std::string& filename); //appends to the file if it already exists. Returns false on error.
+    void close(); //flushes and closes
+    bool isOpen() const;
+
+    void add(const Event& event);
+    bool flush(); //ends the current block and returns once everything is on disk. Returns false if a write failed.
+
+    void setBlockSize(size_t deals); //amount of deals per block, default 64
+
+  private:
+    HandHistoryWriter(const HandHistoryWriter&); //not copyable
+    HandHistoryWriter& operator=(const HandHistoryWriter&);
+
+    void endBlock(); //encodes the current block and hands it to the writer thread
+    void run(); //the writer thread
+
+    FILE* file;
+    size_t blockSize;
+
+    //the block that's being built
+    std::vector<unsigned> dealOffsets;
+    std::vector<unsigned char> names;
+    std::vector<unsigned char> events;
+    unsigned numEvents;
+    std::vector<int> nameIndex; //index in the name table of this block for each name id, -1 if not in it yet
+    std::vector<int> usedNames; //name ids in the name table, to reset nameIndex for the next block
+
+    //blocks waiting for the writer thread, and buffers to reuse
+    std::mutex mutex;
+    std::condition_variable wake; //a block to write, or quit
+    std::condition_variable written; //the writer thread has written all blocks
+    std::vector<std::vector<unsigned char> > queued;
+    std::vector<std::vector<unsigned char> > spare;
+    bool writing; //the writer thread is busy with a block
+    bool failed; //a write failed
+    bool quit;
+    std::thread thread;
+};
+
+/*
+Read access to a hand history file, memory-mapped. Any deal can be read directly. The functions that get
+events can be used from multiple threads at once.
+*/
+class HandHistoryFile
+{
+  public:
+    HandHistoryFile();
+
+    bool open(const std::string& filename); //returns false if the file can't be opened or has no valid blocks
+    void close();
+
+    size_t getNumDeals() const;
+    size_t getNumEvents() const;
+
+    bool getDeal(size_t index, std::vector<Event>& result) const; //replaces result with the events of the deal. Returns false if the data is damaged.
+    bool getDeals(size_t index, size_t amount, std::vector<Event>& result) const; //same for amount deals in a row, appended in order
+
+  private:
+    HandHistoryFile(const HandHistoryFile&); //not copyable
+    HandHistoryFile& operator=(const HandHistoryFile&);
+
+    struct Block
+    {
+      size_t firstDeal; //index in the whole file of the first deal of this block
+      unsigned numDeals;
+      const unsigned* dealOffsets;
+      std::vector<int> names; //name ids (see nametable.h) of the name table
+      const unsigned char* events;
+      unsigned eventsSize;
+    };
+
+    MappedFile file;
+    std::vector<Block> blocks;
+    size_t numDeals;
+    size_t numEvents;
+};
+
+/*
+Conversion between the text log of ObserverLog (one eventToString per line) and the binary hand history.
+Lines of the text that aren't an event (see stringToEvent) are log messages, several of them in a row
+become one E_LOG_MESSAGE with multiple lines, so converting a log to binary and back gives the same text.
+Return false on error.
+*/
+bool convertTextToHandHistory(const std::string& textFile, const std::string& handHistoryFile);
+bool convertHandHistoryToText(const std::string& handHistoryFile, const std::string& textFile, size_t firstDeal = 0, size_t numDeals = (size_t)(-1));
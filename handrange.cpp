@@ -0,0 +1,384 @@
+/*
+OOPoker
+
+Copyright (c) 2010 Lode Vandevenne
+All rights reserved.
+
+This file is part of OOPoker.
+
+OOPoker is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+OOPoker is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with OOPoker.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include "handrange.h"
+
+#include <algorithm>
+
+#include "equity.h"
+#include "pokermath.h"
+#include "random.h"
+#include "riverranker.h"
+
+namespace
+{
+  struct ComboTables
+  {
+    int card1[NUM_COMBOS];
+    int card2[NUM_COMBOS];
+    uint64_t mask[NUM_COMBOS];
+    int grid[NUM_COMBOS]; //getStartingHandIndex of the combo
+    int gridSize[169]; //amount of combos of each starting hand (6 for pairs, 4 suited, 12 offsuit)
+    int index[52][52];
+
+    ComboTables()
+    {
+      std::fill(gridSize, gridSize + 169, 0);
+      int n = 0;
+      for(int a = 0; a < 52; a++)
+      for(int b = a + 1; b < 52; b++)
+      {
+        Card c1(a % 13 + 2, (Suit)(a / 13));
+        Card c2(b % 13 + 2, (Suit)(b / 13));
+        card1[n] = a;
+        card2[n] = b;
+        mask[n] = eval7_mask(c1) | eval7_mask(c2);
+        grid[n] = getStartingHandIndex(c1, c2);
+        gridSize[grid[n]]++;
+        index[a][b] = index[b][a] = n;
+        n++;
+      }
+    }
+  };
+
+  const ComboTables& getComboTables()
+  {
+    static const ComboTables tables; //thread safe initialization
+    return tables;
+  }
+
+  //a combo that is possible given the known cards, with its weight
+  struct LiveCombo
+  {
+    uint64_t mask;
+    float weight;
+  };
+}
+
+int getComboIndex(int card1, int card2)
+{
+  return getComboTables().index[card1][card2];
+}
+
+int getComboIndex(const Card& card1, const Card& card2)
+{
+  return getComboIndex(eval7_index(card1), eval7_index(card2));
+}
+
+void getComboCards(int& card1, int& card2, int combo)
+{
+  card1 = getComboTables().card1[combo];
+  card2 = getComboTables().card2[combo];
+}
+
+uint64_t getComboMask(int combo)
+{
+  return getComboTables().mask[combo];
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+HandRange::HandRange(float weight)
+{
+  setAll(weight);
+}
+
+void HandRange::setAll(float weight)
+{
+  std::fill(weights, weights + NUM_COMBOS, weight);
+}
+
+void HandRange::setWeight(int combo, float weight)
+{
+  weights[combo] = weight;
+}
+
+void HandRange::setWeight(const Card& card1, const Card& card2, float weight)
+{
+  weights[getComboIndex(card1, card2)] = weight;
+}
+
+float HandRange::getWeight(const Card& card1, const Card& card2) const
+{
+  return weights[getComboIndex(card1, card2)];
+}
+
+void HandRange::setGrid(const float* grid)
+{
+  const ComboTables& tables = getComboTables();
+  for(int i = 0; i < NUM_COMBOS; i++) weights[i] = grid[tables.grid[i]];
+}
+
+void HandRange::getGrid(float* grid) const
+{
+  const ComboTables& tables = getComboTables();
+  std::fill(grid, grid + 169, 0.0f);
+  for(int i = 0; i < NUM_COMBOS; i++) grid[tables.grid[i]] += weights[i];
+  for(int i = 0; i < 169; i++) grid[i] /= tables.gridSize[i];
+}
+
+void HandRange::removeCards(uint64_t mask)
+{
+  const ComboTables& tables = getComboTables();
+  for(int i = 0; i < NUM_COMBOS; i++)
+  {
+    if(tables.mask[i] & mask) weights[i] = 0.0f;
+  }
+}
+
+double HandRange::getTotalWeight(uint64_t dead) const
+{
+  const ComboTables& tables = getComboTables();
+  double total = 0.0;
+  for(int i = 0; i < NUM_COMBOS; i++)
+  {
+    if(!(tables.mask[i] & dead)) total += weights[i];
+  }
+  return total;
+}
+
+void HandRange::normalize()
+{
+  double total = getTotalWeight();
+  if(total <= 0.0) return;
+  for(int i = 0; i < NUM_COMBOS; i++) weights[i] = (float)(weights[i] / total);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+//the combos of the range with a weight above 0 and without a dead card
+static void getLiveCombos(std::vector<LiveCombo>& result, const HandRange& range, uint64_t dead)
+{
+  const ComboTables& tables = getComboTables();
+  result.clear();
+  for(int i = 0; i < NUM_COMBOS; i++)
+  {
+    if(range.getWeight(i) <= 0.0f || (tables.mask[i] & dead)) continue;
+    LiveCombo combo;
+    combo.mask = tables.mask[i];
+    combo.weight = range.getWeight(i);
+    result.push_back(combo);
+  }
+}
+
+//the masks of all cards that are not in used, returns the amount
+static int getRemainingCards(uint64_t* masks, uint64_t used)
+{
+  int n = 0;
+  for(int i = 0; i < 52; i++)
+  {
+    uint64_t mask = eval7_mask(Card(i % 13 + 2, (Suit)(i / 13)));
+    if(!(used & mask)) masks[n++] = mask;
+  }
+  return n;
+}
+
+/*
+Calls f with every full board that the known board can become. Every pair of combos that doesn't share a
+card is possible with the same amount of runouts, so adding up the showdowns of all of them gives each
+pair the same weight.
+*/
+template<typename F>
+static void forEachRunout(uint64_t board, int numBoard, const F& f)
+{
+  uint64_t deck[52];
+  int n = getRemainingCards(deck, board);
+
+  if(numBoard == 5) f(board);
+  else if(numBoard == 4)
+  {
+    for(int i = 0; i < n; i++) f(board | deck[i]);
+  }
+  else if(numBoard == 3)
+  {
+    for(int i = 0; i < n; i++)
+    for(int j = i + 1; j < n; j++)
+    {
+      f(board | deck[i] | deck[j]);
+    }
+  }
+}
+
+//range against range, each full board is done with the single pass showdown of the RiverRanker
+static void enumerateShowdowns(double& equity, double& total, const HandRange& range1, const HandRange& range2
+                             , uint64_t board, int numBoard)
+{
+  //only the combos that are in one of the ranges have to be ranked
+  unsigned char needed[NUM_COMBOS];
+  for(int i = 0; i < NUM_COMBOS; i++)
+  {
+    needed[i] = (range1.getWeight(i) > 0.0f || range2.getWeight(i) > 0.0f) && !(getComboMask(i) & board);
+  }
+
+  RiverRanker ranker;
+  std::vector<double> showdownEquity(NUM_COMBOS), showdownTotal(NUM_COMBOS);
+  forEachRunout(board, numBoard, [&](uint64_t full)
+  {
+    ranker.setBoard(full, needed);
+    ranker.getShowdown(&showdownEquity[0], &showdownTotal[0], range2.getWeights());
+    for(int i = 0; i < ranker.getSize(); i++)
+    {
+      int combo = ranker.getCombo(i);
+      float w = range1.getWeight(combo);
+      equity += w * showdownEquity[combo];
+      total += w * showdownTotal[combo];
+    }
+  });
+}
+
+//a single hand against a range doesn't need the sorting of the RiverRanker, it's compared with every combo directly
+static void enumerateShowdowns(double& equity, double& total, uint64_t hand, const HandRange& range, uint64_t board, int numBoard)
+{
+  std::vector<LiveCombo> combos;
+  getLiveCombos(combos, range, board | hand);
+
+  std::vector<uint64_t> hands(combos.size() + 1);
+  std::vector<float> weights(combos.size());
+  std::vector<uint32_t> values(combos.size() + 1);
+  forEachRunout(board, numBoard, [&](uint64_t full)
+  {
+    if(full & hand) return;
+    size_t n = 0;
+    hands[n++] = full | hand;
+    for(size_t i = 0; i < combos.size(); i++)
+    {
+      if(combos[i].mask & full) continue;
+      weights[n - 1] = combos[i].weight;
+      hands[n++] = full | combos[i].mask;
+    }
+    eval7_batch(&hands[0], &values[0], n);
+    for(size_t i = 1; i < n; i++)
+    {
+      total += weights[i - 1];
+      equity += weights[i - 1] * ((values[0] > values[i]) + 0.5 * (values[0] == values[i]));
+    }
+  });
+}
+
+//index of a combo chosen with probability proportional to its weight, cumulative has the running total of the weights
+static int pickWeighted(const std::vector<double>& cumulative, RandomStream& random)
+{
+  double x = random.nextDouble() * cumulative.back();
+  size_t i = std::upper_bound(cumulative.begin(), cumulative.end(), x) - cumulative.begin();
+  return (int)std::min(i, cumulative.size() - 1);
+}
+
+/*
+Monte Carlo: each sample picks a combo of both ranges by weight (trying again if they share a card,
+which gives each pair a chance proportional to the product of the weights), then a random runout.
+*/
+static void sampleShowdowns(double& equity, double& total, const std::vector<LiveCombo>& combos1, const std::vector<LiveCombo>& combos2
+                          , uint64_t board, int numBoard, int numSamples, RandomStream& random)
+{
+  std::vector<double> cumulative1(combos1.size()), cumulative2(combos2.size());
+  double sum = 0.0;
+  for(size_t i = 0; i < combos1.size(); i++) cumulative1[i] = (sum += combos1[i].weight);
+  sum = 0.0;
+  for(size_t i = 0; i < combos2.size(); i++) cumulative2[i] = (sum += combos2[i].weight);
+
+  uint64_t deck[52];
+  int n = getRemainingCards(deck, board);
+
+  //if nearly all pairs share a card it could take forever, so the amount of tries is limited
+  int done = 0;
+  for(int tries = 0; done < numSamples && tries < numSamples * 100; tries++)
+  {
+    uint64_t mask1 = combos1[pickWeighted(cumulative1, random)].mask;
+    uint64_t mask2 = combos2[pickWeighted(cumulative2, random)].mask;
+    if(mask1 & mask2) continue;
+
+    uint64_t used = board | mask1 | mask2;
+    uint64_t full = board;
+    for(int i = numBoard; i < 5; i++)
+    {
+      uint64_t card;
+      do card = deck[random.nextInt(0, n - 1)]; while(card & used);
+      used |= card;
+      full |= card;
+    }
+
+    uint64_t hands[2] = { full | mask1, full | mask2 };
+    uint32_t values[2];
+    eval7_batch(hands, values, 2);
+    equity += (values[0] > values[1]) + 0.5 * (values[0] == values[1]);
+    total += 1.0;
+    done++;
+  }
+}
+
+static bool getBoardMask(uint64_t& board, const std::vector<Card>& boardCards)
+{
+  size_t numBoard = boardCards.size();
+  if(numBoard != 0 && numBoard != 3 && numBoard != 4 && numBoard != 5) return false;
+  board = 0;
+  for(size_t i = 0; i < numBoard; i++) board |= eval7_mask(boardCards[i]);
+  return true;
+}
+
+static double sampleEquity(const HandRange& range1, const HandRange& range2, uint64_t board, int numBoard, int numSamples, RandomStream* random)
+{
+  std::vector<LiveCombo> combos1, combos2;
+  getLiveCombos(combos1, range1, board);
+  getLiveCombos(combos2, range2, board);
+  if(combos1.empty() || combos2.empty()) return 0.0;
+
+  double equity = 0.0;
+  double total = 0.0;
+  sampleShowdowns(equity, total, combos1, combos2, board, numBoard, numSamples, random ? *random : getThreadRandomStream());
+  return total > 0.0 ? equity / total : 0.0;
+}
+
+double getHandVsRangeEquity(const Card& hand1, const Card& hand2, const std::vector<Card>& boardCards, const HandRange& range
+                          , int numSamples, RandomStream* random)
+{
+  uint64_t board;
+  if(!getBoardMask(board, boardCards)) return 0.0;
+  int numBoard = (int)boardCards.size();
+
+  if(numBoard == 0)
+  {
+    HandRange hand;
+    hand.setWeight(hand1, hand2, 1.0f);
+    return sampleEquity(hand, range, board, numBoard, numSamples, random);
+  }
+
+  double equity = 0.0;
+  double total = 0.0;
+  enumerateShowdowns(equity, total, eval7_mask(hand1) | eval7_mask(hand2), range, board, numBoard);
+  return total > 0.0 ? equity / total : 0.0;
+}
+
+double getRangeVsRangeEquity(const HandRange& range1, const HandRange& range2, const std::vector<Card>& boardCards
+                           , int numSamples, RandomStream* random)
+{
+  uint64_t board;
+  if(!getBoardMask(board, boardCards)) return 0.0;
+  int numBoard = (int)boardCards.size();
+
+  if(numBoard < 4) return sampleEquity(range1, range2, board, numBoard, numSamples, random);
+
+  double equity = 0.0;
+  double total = 0.0;
+  enumerateShowdowns(equity, total, range1, range2, board, numBoard);
+  return total > 0.0 ? equity / total : 0.0;
+}
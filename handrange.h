@@ -0,0 +1,100 @@
+/*
+OOPoker
+
+Copyright (c) 2010 Lode Vandevenne
+All rights reserved.
+
+This file is part of OOPoker.
+
+OOPoker is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+OOPoker is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with OOPoker.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#pragma once
+
+/*
+Hand ranges and range equity.
+
+A HandRange is a weight for each of the 1326 possible hole card combinations, e.g. the assumed range
+of an opponent: 0 means that hand is never played like this, 1 that it always is, in between is how
+likely compared to the other hands. The weights don't have to add up to anything, only their ratios matter.
+
+Ranges can be converted from and to the 13x13 grid of starting hands of getStartingHandIndex (equity.h),
+which is the form in which ranges are usually written down and used as features.
+
+The combos are numbered 0-1325: for the cards a < b in eval7 indices (see eval7_index in pokermath.h),
+the combos with a = 0 come first, then a = 1, and so on.
+
+The equity functions take card removal into account: a combo that contains a board card or one of your
+own cards is not possible, and when comparing two ranges, only the pairs of combos that don't share a
+card count, each with weight1 * weight2. They use the bit masks of the evaluator (eval7_mask) to check
+for shared cards. They are exhaustive on the turn and river (and for a single hand against a range on the
+flop too), and use a Monte Carlo simulation otherwise. Range against range on a full board uses the
+single pass showdown of riverranker.h.
+*/
+
+#include <stdint.h>
+#include <vector>
+
+#include "card.h"
+
+class RandomStream;
+
+const int NUM_COMBOS = 1326;
+
+int getComboIndex(int card1, int card2); //eval7 indices, the order doesn't matter. The cards must be different.
+int getComboIndex(const Card& card1, const Card& card2);
+void getComboCards(int& card1, int& card2, int combo); //eval7 indices, card1 < card2
+uint64_t getComboMask(int combo); //the bit mask of both cards, as eval7_mask
+
+class HandRange
+{
+  public:
+    HandRange(float weight = 0.0f); //every combo gets this weight
+
+    void setAll(float weight);
+    void setWeight(int combo, float weight);
+    void setWeight(const Card& card1, const Card& card2, float weight);
+    float getWeight(int combo) const { return weights[combo]; }
+    float getWeight(const Card& card1, const Card& card2) const;
+    const float* getWeights() const { return weights; } //NUM_COMBOS weights
+
+    //13x13 grid, see getStartingHandIndex. Setting gives every combo of a starting hand its value, getting gives the average weight of its combos.
+    void setGrid(const float* grid /*169 values*/);
+    void getGrid(float* grid /*169 values*/) const;
+
+    void removeCards(uint64_t mask); //sets the weight of all combos that contain one of these cards to 0
+    double getTotalWeight(uint64_t dead = 0) const; //total weight of the combos that don't contain a dead card
+    void normalize(); //scales the weights so that the total is 1, unless it's 0
+
+  private:
+    float weights[NUM_COMBOS];
+};
+
+/*
+Equity (win chance plus half the tie chance) of your hand against one opponent with the given range.
+boardCards must have size 0, 3, 4 or 5. Pre-flop it's a Monte Carlo simulation with numSamples samples,
+on later streets it's exact. Returns 0 if the range has no possible combo.
+random is the random generator for the simulation, or 0 to use the one of the calling thread.
+*/
+double getHandVsRangeEquity(const Card& hand1, const Card& hand2, const std::vector<Card>& boardCards, const HandRange& range
+                          , int numSamples = 20000, RandomStream* random = 0);
+
+/*
+Equity of range1 against range2, heads-up: the average equity over all possible pairs of combos,
+weighted with the product of their weights. Exact on the turn and river, a Monte Carlo simulation on
+the flop and pre-flop. Returns 0 if no pair of combos is possible.
+*/
+double getRangeVsRangeEquity(const HandRange& range1, const HandRange& range2, const std::vector<Card>& boardCards
+                           , int numSamples = 20000, RandomStream* random = 0);
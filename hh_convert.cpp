@@ -0,0 +1,77 @@
+/*
+OOPoker
+
+Copyright (c) 2010 Lode Vandevenne
+All rights reserved.
+
+This file is part of OOPoker.
+
+OOPoker is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+OOPoker is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with OOPoker.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+/*
+Converts between the text log of ObserverLog and the binary hand history of ObserverHandHistory.
+
+Usage: hh_convert input output [first deal] [amount of deals]
+If input is a hand history it's converted to text, otherwise input is read as a text log and converted to
+a hand history. When converting to text, the optional first deal and amount of deals select only those
+deals (deals are numbered from 0, see handhistory.h), so any deal of a big file can be looked at directly.
+*/
+
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <string>
+
+#include "handhistory.h"
+
+int main(int argc, char* argv[])
+{
+  if(argc < 3)
+  {
+    std::cout << "usage: hh_convert input output [first deal] [amount of deals]" << std::endl;
+    return 1;
+  }
+  std::string input = argv[1];
+  std::string output = argv[2];
+
+  char magic[4] = { 0, 0, 0, 0 };
+  std::ifstream in(input.c_str(), std::ios::binary);
+  if(!in)
+  {
+    std::cout << "error reading " << input << std::endl;
+    return 1;
+  }
+  in.read(magic, 4);
+  in.close();
+
+  bool success;
+  if(std::memcmp(magic, "OOHH", 4) == 0)
+  {
+    size_t firstDeal = argc > 3 ? std::strtoull(argv[3], 0, 10) : 0;
+    size_t numDeals = argc > 4 ? std::strtoull(argv[4], 0, 10) : (size_t)(-1);
+    success = convertHandHistoryToText(input, output, firstDeal, numDeals);
+  }
+  else success = convertTextToHandHistory(input, output);
+
+  if(!success)
+  {
+    std::cout << "error converting " << input << " to " << output << std::endl;
+    return 1;
+  }
+  std::cout << "written " << output << std::endl;
+  return 0;
+}
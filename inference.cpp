@@ -0,0 +1,126 @@
+#include "inference.h"
+#include <algorithm>
+#include <exception>
+#include <tuple>
+
+InferenceBroker::InferenceBroker(PokerNet& net, int max_batch, std::chrono::microseconds max_wait, std::mutex* net_mutex)
+  : net(net), max_batch(max_batch < 1 ? 1 : max_batch), max_wait(max_wait), net_mutex(net_mutex)
+  , quit(false), num_requests(0), num_batches(0), server(&InferenceBroker::serve, this)
+{
+} // end of constructor
+
+InferenceBroker::~InferenceBroker()
+{
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    quit = true;
+  }
+  wake.notify_all();
+  server.join();
+} // end of destructor
+
+std::future<InferenceResult> InferenceBroker::submit(const torch::Tensor& state, const torch::Tensor& new_actions, const PokerNetImpl::State& lstm_state)
+{
+  Request request;
+  request.state = state;
+  request.new_actions = new_actions;
+  request.lstm_state = lstm_state;
+  request.time = std::chrono::steady_clock::now();
+  std::future<InferenceResult> result = request.result.get_future();
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    pending.push_back(std::move(request));
+  }
+  wake.notify_one();
+  num_requests++;
+  return result;
+} // end of submit
+
+void InferenceBroker::serve()
+{
+  std::vector<Request> batch;
+  for (;;) {
+    {
+      std::unique_lock<std::mutex> lock(mutex);
+      wake.wait(lock, [this]() { return quit || !pending.empty(); });
+      if (pending.empty()) return; // quit
+
+      // give more decisions the chance to join, but never let the oldest one wait longer than max_wait
+      std::chrono::steady_clock::time_point deadline = pending.front().time + max_wait;
+      wake.wait_until(lock, deadline, [this]() { return quit || (int)pending.size() >= max_batch; });
+
+      while (!pending.empty() && (int)batch.size() < max_batch) {
+        batch.push_back(std::move(pending.front()));
+        pending.pop_front();
+      }
+    }
+
+    process(batch);
+    batch.clear();
+    num_batches++;
+  }
+} // end of serve
+
+void InferenceBroker::process(std::vector<Request>& batch)
+{
+  torch::Tensor out, h, c;
+  try {
+    torch::NoGradGuard no_grad;
+    int64_t size = (int64_t)batch.size();
+
+    std::vector<torch::Tensor> states, actions, hs, cs;
+    std::vector<int64_t> lengths;
+    std::vector<float> unchanged; // 1 for decisions without new actions
+    for (size_t i = 0; i < batch.size(); i++) {
+      int64_t len = batch[i].new_actions.size(0);
+      states.push_back(batch[i].state);
+      // packing needs at least one step, a decision without new actions gets a dummy one and its state is restored below
+      actions.push_back(len > 0 ? batch[i].new_actions.squeeze(1) : torch::zeros({1, 3}));
+      lengths.push_back(len > 0 ? len : 1);
+      unchanged.push_back(len > 0 ? 0.0f : 1.0f);
+      hs.push_back(std::get<0>(batch[i].lstm_state));
+      cs.push_back(std::get<1>(batch[i].lstm_state));
+    }
+
+    torch::Tensor state = torch::cat(states, 0);
+    torch::Tensor new_actions = torch::nn::utils::rnn::pad_sequence(actions); // [max_len, batch, 3]
+    torch::Tensor length = torch::tensor(lengths);
+    torch::Tensor opp = torch::zeros({size, 10});
+    PokerNetImpl::State lstm_state(torch::cat(hs, 1), torch::cat(cs, 1));
+
+    std::unique_lock<std::mutex> lock;
+    if (net_mutex) lock = std::unique_lock<std::mutex>(*net_mutex);
+
+    PokerNetImpl::State new_state;
+    std::tie(out, new_state) = net->forward_batch(state, new_actions, length, opp, lstm_state);
+    std::tie(h, c) = new_state;
+
+    if (*std::max_element(unchanged.begin(), unchanged.end()) > 0.0f) {
+      torch::Tensor mask = torch::tensor(unchanged).view({1, size, 1}) > 0.5f;
+      h = torch::where(mask, std::get<0>(lstm_state), h);
+      c = torch::where(mask, std::get<1>(lstm_state), c);
+      out = net->forward_from_hidden(state, h.squeeze(0), opp);
+    }
+  } catch (...) {
+    for (size_t i = 0; i < batch.size(); i++) batch[i].result.set_exception(std::current_exception());
+    return;
+  }
+
+  for (size_t i = 0; i < batch.size(); i++) {
+    InferenceResult result;
+    result.out = out[i].unsqueeze(0).clone();
+    result.h = h.narrow(1, (int64_t)i, 1).clone();
+    result.c = c.narrow(1, (int64_t)i, 1).clone();
+    batch[i].result.set_value(result);
+  }
+} // end of process
+
+long long InferenceBroker::get_num_requests() const
+{
+  return num_requests.load();
+} // end of get_num_requests
+
+long long InferenceBroker::get_num_batches() const
+{
+  return num_batches.load();
+} // end of get_num_batches
@@ -0,0 +1,73 @@
+#pragma once
+#include <torch/torch.h>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <future>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "poker_net.h"
+
+// output vector [1, 2] and the new lstm state [1, 1, hidden] of one decision
+struct InferenceResult {
+    torch::Tensor out;
+    torch::Tensor h;
+    torch::Tensor c;
+};
+
+/*
+Batched inference for many AIRL agents at once. A forward pass of PokerNet for one decision is mostly
+overhead, so when many tables are running, the agents submit their decisions here instead and wait
+for the future. A server thread collects the pending decisions, pads their new actions and runs them
+through PokerNet::forward_batch in one forward pass without autograd. Like PokerNet::forward_step, every
+decision only gives the actions since the previous decision of the agent, together with the lstm state
+the previous result returned.
+
+A batch is started as soon as max_batch decisions are waiting, or when the oldest waiting decision
+has waited max_wait, whichever comes first. A bigger max_wait gives bigger batches but slower turns.
+*/
+class InferenceBroker {
+public:
+    // if net_mutex is given, it's locked during every forward pass, so someone else can safely change the weights
+    InferenceBroker(PokerNet& net, int max_batch = 64, std::chrono::microseconds max_wait = std::chrono::microseconds(200), std::mutex* net_mutex = nullptr);
+    ~InferenceBroker(); // finishes the waiting decisions, then stops the server thread
+
+    // state is [1, input] from TensorConverter::infoToTensor, new_actions is [n, 1, 3] (n can be 0 if
+    // nothing happened since the previous decision), lstm_state is from the previous result or
+    // PokerNetImpl::initial_state(). the result is the same as forward_step gives.
+    std::future<InferenceResult> submit(const torch::Tensor& state, const torch::Tensor& new_actions, const PokerNetImpl::State& lstm_state);
+
+    long long get_num_requests() const;
+    long long get_num_batches() const;
+
+private:
+    InferenceBroker(const InferenceBroker&); // not copyable
+    InferenceBroker& operator=(const InferenceBroker&);
+
+    struct Request {
+        torch::Tensor state;
+        torch::Tensor new_actions;
+        PokerNetImpl::State lstm_state;
+        std::promise<InferenceResult> result;
+        std::chrono::steady_clock::time_point time;
+    };
+
+    void serve();
+    void process(std::vector<Request>& batch);
+
+    PokerNet& net;
+    int max_batch;
+    std::chrono::microseconds max_wait;
+    std::mutex* net_mutex;
+
+    std::mutex mutex;
+    std::condition_variable wake; // a new request, or quit
+    std::deque<Request> pending;
+    bool quit;
+
+    std::atomic<long long> num_requests;
+    std::atomic<long long> num_batches;
+    std::thread server; // last, so it starts when everything else is initialized
+};
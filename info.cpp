@@ -21,18 +21,23 @@ along with OOPoker.  If not, see <http://www.gnu.org/licenses/>.
 */
 
 #include "info.h"
+#include "equity.h"
 #include "pokermath.h"
 #include "action.h"
+#include "nametable.h"
 #include "util.h"
 
 PlayerInfo::PlayerInfo()
-: showdown(false)
+: nameId(-1)
+, showdown(false)
 {
+  holeCards.reserve(2);
 }
 
 const std::string& PlayerInfo::getName() const
 {
-  return name;
+  static const std::string none;
+  return nameId < 0 ? none : getInternedName(nameId);
 }
 
 bool PlayerInfo::isAllIn() const
@@ -57,6 +62,8 @@ bool PlayerInfo::canDecide() const
 
 Info::Info()
 {
+  boardCards.reserve(5);
+  players.reserve(10);
 }
 
 const std::vector<Card>& Info::getHoleCards() const
@@ -320,7 +327,7 @@ double Info::getPotEquity(int index) const
 {
   int numOpponents = getNumActivePlayers() - 1;
 
-  return ::getPotEquity(getHoleCards(index), boardCards, numOpponents);
+  return getPotEquityCached(getHoleCards(index), boardCards, numOpponents);
 }
 
 int Info::getPosition(int index) const
@@ -333,4 +340,245 @@ const std::vector<Card>& Info::getHoleCards(int index) const
   return players[index].holeCards;
 }
 
+////////////////////////////////////////////////////////////////////////////////
+
+//same as getNextActivePlayer of game.cpp: the next player who can decide after current, -1 if there is none
+static int getNextDecidingPlayer(const std::vector<PlayerInfo>& players, int current)
+{
+  int result = current + 1;
+  for(;;)
+  {
+    if(result >= (int)players.size()) result = 0;
+    if(result == current) return -1;
+    if(players[result].canDecide()) return result;
+    result++;
+  }
+}
+
+InfoKeeper::InfoKeeper(const std::string& you)
+: you(you.empty() ? -1 : internName(you))
+{
+  reset();
+}
+
+void InfoKeeper::reset()
+{
+  info.yourIndex = -1;
+  info.dealer = 0;
+  info.current = 0;
+  info.round = R_PRE_FLOP;
+  info.turn = 0;
+  info.minRaiseAmount = info.rules.bigBlind;
+  info.boardCards.clear();
+  info.players.clear();
+  seats.assign(seats.size(), -1);
+  highestWager = 0;
+  cardsReceived = false;
+  unseatedCards.clear();
+}
+
+void InfoKeeper::setRules(const Rules& rules)
+{
+  info.rules = rules;
+}
+
+const Info& InfoKeeper::getInfo() const
+{
+  return info;
+}
+
+void InfoKeeper::putChips(PlayerInfo& player, int chips)
+{
+  if(chips > player.stack) chips = player.stack; //all-in
+  player.stack -= chips;
+  player.wager += chips;
+  if(player.wager > highestWager) highestWager = player.wager;
+}
+
+//same as getInitialPlayer of game.cpp
+void InfoKeeper::updateCurrent()
+{
+  const std::vector<PlayerInfo>& players = info.players;
+  if(players.size() < 2) info.current = -2;
+  else if(info.getNumDecidingPlayers() < 2) info.current = players.size() == 2 ? -3 : -4;
+  else if(players.size() == 2) info.current = info.wrap(info.round == R_PRE_FLOP ? info.dealer : info.dealer + 1);
+  else
+  {
+    int index = info.wrap(info.round == R_PRE_FLOP ? info.dealer + 3 : info.dealer + 1);
+    info.current = players[index].canDecide() ? index : getNextDecidingPlayer(players, index);
+  }
+}
 
+void InfoKeeper::startRound(Round round)
+{
+  info.round = round;
+  info.turn = 0;
+  updateCurrent();
+}
+
+void InfoKeeper::onEvent(const Event& event)
+{
+  int seat = event.playerId >= 0 && event.playerId < (int)seats.size() ? seats[event.playerId] : -1;
+  PlayerInfo* player = seat >= 0 ? &info.players[seat] : 0;
+  const Card* cards[5] = { &event.card1, &event.card2, &event.card3, &event.card4, &event.card5 };
+
+  switch(event.type)
+  {
+    case E_JOIN:
+    {
+      if(player || event.playerId < 0) break;
+      if(event.playerId >= (int)seats.size()) seats.resize(event.playerId + 1, -1);
+      seats[event.playerId] = (int)info.players.size();
+      if(event.playerId == you) info.yourIndex = (int)info.players.size();
+      info.players.resize(info.players.size() + 1);
+      PlayerInfo& p = info.players.back();
+      p.nameId = event.playerId;
+      p.folded = false;
+      p.stack = event.chips;
+      p.wager = 0;
+      p.lastAction = Action();
+      p.showdown = false;
+      p.holeCards.clear();
+      for(size_t i = 0; i < unseatedCards.size(); i++)
+      {
+        if(unseatedCards[i].playerId != event.playerId) continue;
+        p.holeCards.resize(2);
+        p.holeCards[0] = unseatedCards[i].card1;
+        p.holeCards[1] = unseatedCards[i].card2;
+      }
+      break;
+    }
+    case E_QUIT:
+    {
+      if(!player) break;
+      info.players.erase(info.players.begin() + seat);
+      seats[event.playerId] = -1;
+      for(size_t i = seat; i < info.players.size(); i++) seats[info.players[i].nameId] = (int)i;
+      if(info.yourIndex == seat) info.yourIndex = -1;
+      else if(info.yourIndex > seat) info.yourIndex--;
+      //the same as the Game does with the dealer
+      if(info.dealer > seat) info.dealer--;
+      if(info.dealer >= (int)info.players.size()) info.dealer = 0;
+      break;
+    }
+    case E_REBUY:
+    {
+      if(player) player->stack = event.chips;
+      break;
+    }
+    case E_NEW_DEAL:
+    {
+      info.rules.smallBlind = event.smallBlind;
+      info.rules.bigBlind = event.bigBlind;
+      info.rules.ante = event.ante;
+      for(size_t i = 0; i < info.players.size(); i++)
+      {
+        PlayerInfo& p = info.players[i];
+        p.folded = false;
+        p.showdown = false;
+        p.wager = 0;
+        if(!cardsReceived && !p.holeCards.empty()) p.holeCards.clear();
+        //like in the Game, lastAction stays what it was in the previous deal until the player acts
+      }
+      cardsReceived = false;
+      unseatedCards.clear();
+      highestWager = 0;
+      info.boardCards.clear();
+      info.minRaiseAmount = event.bigBlind;
+      startRound(R_PRE_FLOP);
+      break;
+    }
+    case E_RECEIVE_CARDS:
+    {
+      //they come right before E_NEW_DEAL, so the cards of the previous deal are forgotten here already
+      if(!cardsReceived)
+      {
+        for(size_t i = 0; i < info.players.size(); i++) info.players[i].holeCards.clear();
+        cardsReceived = true;
+      }
+      if(!player)
+      {
+        unseatedCards.push_back(event);
+        break;
+      }
+      player->holeCards.resize(2);
+      player->holeCards[0] = event.card1;
+      player->holeCards[1] = event.card2;
+      break;
+    }
+    case E_DEALER:
+    {
+      if(!player) break;
+      info.dealer = seat;
+      updateCurrent();
+      break;
+    }
+    case E_SMALL_BLIND:
+    case E_BIG_BLIND:
+    case E_ANTE:
+    {
+      if(!player) break;
+      putChips(*player, event.chips);
+      updateCurrent(); //whoever is all-in from the blinds can't start
+      break;
+    }
+    case E_FOLD:
+    case E_CHECK:
+    case E_CALL:
+    case E_RAISE:
+    {
+      if(!player) break;
+      int callAmount = highestWager - player->wager;
+      if(event.type == E_FOLD)
+      {
+        player->folded = true;
+        player->lastAction = Action(A_FOLD);
+      }
+      else if(event.type == E_CHECK) player->lastAction = Action(A_CHECK);
+      else if(event.type == E_CALL)
+      {
+        putChips(*player, callAmount);
+        player->lastAction = Action(A_CALL);
+      }
+      else
+      {
+        int amount = callAmount + event.chips;
+        if(amount != player->stack) info.minRaiseAmount = event.chips; //an all-in raise doesn't change the minimum raise
+        putChips(*player, amount);
+        player->lastAction = Action(A_RAISE, amount);
+      }
+      info.current = getNextDecidingPlayer(info.players, seat);
+      break;
+    }
+    case E_FLOP:
+    case E_TURN:
+    case E_RIVER:
+    {
+      size_t numBoard = event.type == E_FLOP ? 3 : event.type == E_TURN ? 4 : 5;
+      info.boardCards.resize(numBoard);
+      for(size_t i = 0; i < numBoard; i++) info.boardCards[i] = *cards[i];
+      startRound(event.type == E_FLOP ? R_FLOP : event.type == E_TURN ? R_TURN : R_RIVER);
+      break;
+    }
+    case E_PLAYER_SHOWDOWN:
+    case E_BOAST:
+    {
+      if(!player) break;
+      if(event.type == E_PLAYER_SHOWDOWN) player->showdown = true;
+      player->holeCards.resize(2);
+      player->holeCards[0] = event.card1;
+      player->holeCards[1] = event.card2;
+      break;
+    }
+    case E_WIN:
+    {
+      if(!player) break;
+      player->stack += event.chips;
+      //the pot is divided, like the Game does after the wins the wagers are back to 0
+      for(size_t i = 0; i < info.players.size(); i++) info.players[i].wager = 0;
+      highestWager = 0;
+      break;
+    }
+    default: break;
+  }
+}
@@ -52,14 +52,14 @@ struct PlayerInfo
 {
   bool folded; //if true, this player has already folded for this game. Either just now (if his action has FOLD in it), or earlier (if his action has ACTION_NONE in it).
 
-  std::string name; //name of the player
+  int nameId; //name of the player, as id in the name table of nametable.h. Use getName() to get the name itself.
   int stack;
   int wager; //how much money this player has bet during the whole game so far (where game is one hand)
 
   Action lastAction; //what the player did this turn (most recent action of this player)
 
   bool showdown; //if true, the hand card values of this player are stored in the holeCard variables.
-  std::vector<Card> holeCards;
+  std::vector<Card> holeCards; //room for 2 cards is reserved, so filling it in again never allocates
 
   PlayerInfo();
 
@@ -118,7 +118,7 @@ struct Info //all the info a player gets during a decision
   double getMRatio() const; //returns (your stack) / (small blind + big blind + total antes), in other words, the number of laps you can still survive with your current stack
   double getPotOdds() const; //this gives getPot() / getCallAmount(). Can be infinite if callamount is 0. Higher is better.
   double getPotOddsPercentage() const; //gets pot odds as a percengate. Gives callAmount / (total pot + callAmount). For example if the pot odds are 2:1, then the percentage is 33.3% (and the return value is 0.33 since it's a number in the range 0.0-1.0)
-  double getPotEquity() const; //see description in pokermath.h for more information about this function. This here is just a convenience wrapper.
+  double getPotEquity() const; //see description in pokermath.h for more information about this function. This here is a convenience wrapper, using the cached version from equity.h.
 
   //get std::vectors of cards, handy for calling some of the mathematical functions
   std::vector<Card> getHandTableVector() const;
@@ -156,7 +156,7 @@ struct Info //all the info a player gets during a decision
   double getMRatio(int index) const; //returns (your stack) / (small blind + big blind + total antes), in other words, the number of laps you can still survive with your current stack
   double getPotOdds(int index) const; //this gives getPot() / getCallAmount(). Can be infinite if callamount is 0. Higher is better.
   double getPotOddsPercentage(int index) const; //gets pot odds as a percengate. Gives callAmount / (total pot + callAmount). For example if the pot odds are 2:1, then the percentage is 33.3% (and the return value is 0.33 since it's a number in the range 0.0-1.0)
-  double getPotEquity(int index) const; //see description in pokermath.h for more information about this function. This here is just a convenience wrapper.
+  double getPotEquity(int index) const; //see description in pokermath.h for more information about this function. This here is a convenience wrapper, using the cached version from equity.h.
 
   ///Global Utility methods. Can always be used.
 
@@ -176,18 +176,40 @@ struct Info //all the info a player gets during a decision
 };
 
 
-//TODO: generate info from events
-//class InfoKeeper
-//{
-  //private:
-    //Info info;
-
-  //public:
-
-    //const Info& getInfo() const;
-
-    //InfoKeeper(int yourIndex); //set to -1 for global-only info
-    //~InfoKeeper();
-
-    //void onEvent(const Event& event);
-//};
+/*
+Generates the Info from the events, without a Table: the same Info that the Game gives to an AI (see makeInfo),
+but built up one event at a time, each in constant time. Since it needs nothing else than the events, it can
+also replay a log or a hand history (see handhistory.h), for example to compute features of every decision of
+a big hand history without running the game or the AI's again.
+
+The viewpoint is that of the player with the given name: like an AI, it knows its own hole cards from
+E_RECEIVE_CARDS. With an empty name the Info is global (yourIndex -1). Hole cards of other players are known
+from E_PLAYER_SHOWDOWN and E_BOAST, or from E_RECEIVE_CARDS if those are given too. The rules other than the
+blinds and ante aren't in the events, give them with setRules if needed.
+
+Things the Game does without telling it in an event, such as moving the dealer button after a deal, show up
+in the Info once the next event tells them (E_DEALER of the next deal).
+*/
+class InfoKeeper
+{
+  public:
+    InfoKeeper(const std::string& you = "");
+
+    void onEvent(const Event& event);
+    const Info& getInfo() const;
+
+    void setRules(const Rules& rules);
+    void reset(); //forgets all players and the deal, to replay another game with the same keeper
+
+  private:
+    void startRound(Round round);
+    void updateCurrent(); //the player who acts first this round, as the Game chooses it
+    void putChips(PlayerInfo& player, int chips); //moves chips from the stack to the wager
+
+    Info info;
+    int you; //name id, -1 for global
+    std::vector<int> seats; //index in info.players of each name id, -1 if not at the table
+    int highestWager;
+    bool cardsReceived; //E_RECEIVE_CARDS for the coming deal came already, so E_NEW_DEAL must keep them
+    std::vector<Event> unseatedCards; //E_RECEIVE_CARDS of players whose E_JOIN didn't come yet (the first deal sends them in that order)
+};
@@ -0,0 +1,428 @@
+/*
+OOPoker
+
+Copyright (c) 2010 Lode Vandevenne
+All rights reserved.
+
+This file is part of OOPoker.
+
+OOPoker is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+OOPoker is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with OOPoker.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "isomorphism.h"
+
+#include <algorithm>
+#include <map>
+
+#include "pokermath.h"
+
+namespace
+{
+  const int NUMRANKS = 13;
+  const int NUMSUITS = 4;
+  const int NUMROUNDS = 4;
+  const int NUMPARTS = 2; //the hand cards and the board cards
+  const int BOARDSIZE[NUMROUNDS] = { 0, 3, 4, 5 };
+
+  /*
+  The shape of a suit is how many hand cards (bits 0-2) and board cards (bits 3-5) it has.
+  A configuration is the shape of all 4 suits, sorted from high to low shape.
+  */
+  struct Configuration
+  {
+    int shapes[NUMSUITS];
+    CanonicalIndex suitSize[NUMSUITS]; //amount of possible rank combinations of a single suit with this shape
+    CanonicalIndex groupSize[NUMSUITS]; //for the first suit of a group of suits with the same shape: amount of multisets of the group. 0 for the other suits of the group
+    int groupCount[NUMSUITS]; //for the first suit of a group: amount of suits in the group
+    CanonicalIndex size;
+    CanonicalIndex offset;
+  };
+
+  struct RoundTable
+  {
+    std::vector<Configuration> configurations;
+    std::map<unsigned long long, int> lookup; //from the sorted shapes to the configuration
+    CanonicalIndex size;
+  };
+
+  struct IsomorphismTables
+  {
+    RoundTable rounds[NUMROUNDS];
+
+    IsomorphismTables();
+  };
+}
+
+static CanonicalIndex choose(CanonicalIndex n, CanonicalIndex k)
+{
+  if(k > n) return 0;
+  if(k > n - k) k = n - k;
+  CanonicalIndex result = 1;
+  for(CanonicalIndex i = 0; i < k; i++) result = result * (n - i) / (i + 1);
+  return result;
+}
+
+static int countBits(unsigned v)
+{
+  int result = 0;
+  while(v) { v &= v - 1; result++; }
+  return result;
+}
+
+static int getShapeCount(int shape, int part)
+{
+  return (shape >> (3 * part)) & 7;
+}
+
+static int getCardsInPart(int round, int part)
+{
+  return part == 0 ? 2 : BOARDSIZE[round];
+}
+
+static unsigned long long getConfigurationKey(const int* sortedShapes)
+{
+  unsigned long long key = 0;
+  for(int i = 0; i < NUMSUITS; i++) key = (key << 12) | sortedShapes[i];
+  return key;
+}
+
+//amount of ways to choose the ranks of a single suit with this shape
+static CanonicalIndex getSuitSize(int shape)
+{
+  CanonicalIndex result = 1;
+  int used = 0;
+  for(int p = 0; p < NUMPARTS; p++)
+  {
+    int count = getShapeCount(shape, p);
+    result *= choose(NUMRANKS - used, count);
+    used += count;
+  }
+  return result;
+}
+
+static void addConfigurations(RoundTable& table, int round, int part, int* shapes)
+{
+  if(part == NUMPARTS)
+  {
+    int sorted[NUMSUITS];
+    std::copy(shapes, shapes + NUMSUITS, sorted);
+    std::sort(sorted, sorted + NUMSUITS, std::greater<int>());
+
+    unsigned long long key = getConfigurationKey(sorted);
+    if(table.lookup.count(key)) return;
+
+    Configuration c;
+    c.size = 1;
+    for(int i = 0; i < NUMSUITS; i++)
+    {
+      c.shapes[i] = sorted[i];
+      c.suitSize[i] = getSuitSize(sorted[i]);
+      c.groupSize[i] = 0;
+      c.groupCount[i] = 0;
+    }
+    for(int i = 0; i < NUMSUITS;)
+    {
+      int j = i;
+      while(j < NUMSUITS && c.shapes[j] == c.shapes[i]) j++;
+      c.groupCount[i] = j - i;
+      c.groupSize[i] = choose(c.suitSize[i] + (j - i) - 1, j - i); //multisets of size j - i
+      c.size *= c.groupSize[i];
+      i = j;
+    }
+
+    table.lookup[key] = (int)table.configurations.size();
+    table.configurations.push_back(c);
+    return;
+  }
+
+  //distribute the cards of this part over the suits in all possible ways
+  int n = getCardsInPart(round, part);
+  for(int a = 0; a <= n; a++)
+  for(int b = 0; a + b <= n; b++)
+  for(int c = 0; a + b + c <= n; c++)
+  {
+    int d = n - a - b - c;
+    int counts[NUMSUITS] = { a, b, c, d };
+    int next[NUMSUITS];
+    for(int i = 0; i < NUMSUITS; i++) next[i] = shapes[i] | (counts[i] << (3 * part));
+    addConfigurations(table, round, part + 1, next);
+  }
+}
+
+IsomorphismTables::IsomorphismTables()
+{
+  for(int round = 0; round < NUMROUNDS; round++)
+  {
+    RoundTable& table = rounds[round];
+    int shapes[NUMSUITS] = { 0, 0, 0, 0 };
+    addConfigurations(table, round, 0, shapes);
+
+    //the order of the configurations only matters for consistency, the map already gives them sorted by key, so use that order
+    std::vector<Configuration> sorted;
+    for(std::map<unsigned long long, int>::iterator it = table.lookup.begin(); it != table.lookup.end(); ++it)
+    {
+      sorted.push_back(table.configurations[it->second]);
+      it->second = (int)sorted.size() - 1;
+    }
+    table.configurations.swap(sorted);
+
+    table.size = 0;
+    for(size_t i = 0; i < table.configurations.size(); i++)
+    {
+      table.configurations[i].offset = table.size;
+      table.size += table.configurations[i].size;
+    }
+  }
+}
+
+static const IsomorphismTables& getTables()
+{
+  static const IsomorphismTables tables; //thread safe initialization since C++11
+  return tables;
+}
+
+//combinatorial number system: index of the set of bit positions in mask
+static CanonicalIndex getSetIndex(unsigned mask)
+{
+  CanonicalIndex result = 0;
+  int i = 1;
+  for(int pos = 0; mask; pos++, mask >>= 1)
+  {
+    if(mask & 1) result += choose(pos, i++);
+  }
+  return result;
+}
+
+//inverse of getSetIndex for a set of count positions
+static unsigned getSetFromIndex(CanonicalIndex index, int count)
+{
+  unsigned result = 0;
+  for(int i = count; i >= 1; i--)
+  {
+    int pos = i - 1;
+    while(choose(pos + 1, i) <= index) pos++;
+    index -= choose(pos, i);
+    result |= 1u << pos;
+  }
+  return result;
+}
+
+//inverse of the multiset index: the largest b with choose(b, k) <= index, found with binary search because b can be large
+static CanonicalIndex findLargestChoose(CanonicalIndex index, int k, CanonicalIndex high)
+{
+  CanonicalIndex low = k - 1;
+  while(low < high)
+  {
+    CanonicalIndex mid = low + (high - low + 1) / 2;
+    if(choose(mid, k) <= index) low = mid;
+    else high = mid - 1;
+  }
+  return low;
+}
+
+//removes the used ranks from mask, so that the remaining ranks become consecutive positions
+static unsigned compressRanks(unsigned mask, unsigned used)
+{
+  unsigned result = 0;
+  int pos = 0;
+  for(int rank = 0; rank < NUMRANKS; rank++)
+  {
+    if(used & (1u << rank)) continue;
+    if(mask & (1u << rank)) result |= 1u << pos;
+    pos++;
+  }
+  return result;
+}
+
+//inverse of compressRanks
+static unsigned expandRanks(unsigned mask, unsigned used)
+{
+  unsigned result = 0;
+  int pos = 0;
+  for(int rank = 0; rank < NUMRANKS; rank++)
+  {
+    if(used & (1u << rank)) continue;
+    if(mask & (1u << pos)) result |= 1u << rank;
+    pos++;
+  }
+  return result;
+}
+
+static int getRoundForNumCards(int numCards)
+{
+  switch(numCards)
+  {
+    case 2: return 0;
+    case 5: return 1;
+    case 6: return 2;
+    case 7: return 3;
+    default: return -1;
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+CanonicalIndex getCanonicalSize(Round round)
+{
+  if(round < R_PRE_FLOP || round > R_RIVER) return 0;
+  return getTables().rounds[round].size;
+}
+
+CanonicalIndex getCanonicalIndex(const int* cards, int numCards)
+{
+  int round = getRoundForNumCards(numCards);
+  if(round < 0) return 0;
+
+  const RoundTable& table = getTables().rounds[round];
+
+  unsigned masks[NUMSUITS][NUMPARTS] = { { 0 } };
+  for(int i = 0; i < numCards; i++)
+  {
+    masks[cards[i] / NUMRANKS][i < 2 ? 0 : 1] |= 1u << (cards[i] % NUMRANKS);
+  }
+
+  //per suit: its shape and the index of its ranks
+  std::pair<int, CanonicalIndex> suits[NUMSUITS];
+  for(int s = 0; s < NUMSUITS; s++)
+  {
+    int shape = 0;
+    CanonicalIndex index = 0;
+    CanonicalIndex multiplier = 1;
+    unsigned used = 0;
+    for(int p = 0; p < NUMPARTS; p++)
+    {
+      int count = countBits(masks[s][p]);
+      shape |= count << (3 * p);
+      index += multiplier * getSetIndex(compressRanks(masks[s][p], used));
+      multiplier *= choose(NUMRANKS - countBits(used), count);
+      used |= masks[s][p];
+    }
+    suits[s] = std::make_pair(shape, index);
+  }
+  std::sort(suits, suits + NUMSUITS, std::greater<std::pair<int, CanonicalIndex> >());
+
+  int shapes[NUMSUITS];
+  for(int s = 0; s < NUMSUITS; s++) shapes[s] = suits[s].first;
+  const Configuration& c = table.configurations[table.lookup.find(getConfigurationKey(shapes))->second];
+
+  //each group of suits with the same shape is a multiset of suit indices, sorted from high to low
+  CanonicalIndex result = 0;
+  for(int s = 0; s < NUMSUITS; s += c.groupCount[s])
+  {
+    int k = c.groupCount[s];
+    CanonicalIndex index = 0;
+    for(int i = 0; i < k; i++) index += choose(suits[s + i].second + (k - 1 - i), k - i);
+    result = result * c.groupSize[s] + index;
+  }
+
+  return c.offset + result;
+}
+
+void getCanonicalCards(int* cards, Round round, CanonicalIndex index)
+{
+  if(round < R_PRE_FLOP || round > R_RIVER) return;
+
+  const RoundTable& table = getTables().rounds[round];
+
+  //find the configuration: the last one with offset <= index
+  size_t lo = 0, hi = table.configurations.size() - 1;
+  while(lo < hi)
+  {
+    size_t mid = (lo + hi + 1) / 2;
+    if(table.configurations[mid].offset <= index) lo = mid;
+    else hi = mid - 1;
+  }
+  const Configuration& c = table.configurations[lo];
+  index -= c.offset;
+
+  //undo the mixed radix combination of the groups, last group first
+  int groupStarts[NUMSUITS];
+  int numGroups = 0;
+  for(int s = 0; s < NUMSUITS; s += c.groupCount[s]) groupStarts[numGroups++] = s;
+
+  CanonicalIndex suitIndex[NUMSUITS];
+  for(int g = numGroups - 1; g >= 0; g--)
+  {
+    int s = groupStarts[g];
+    int k = c.groupCount[s];
+    CanonicalIndex groupIndex = index % c.groupSize[s];
+    index /= c.groupSize[s];
+
+    for(int i = 0; i < k; i++)
+    {
+      int j = k - i;
+      CanonicalIndex b = findLargestChoose(groupIndex, j, c.suitSize[s] + j - 1);
+      groupIndex -= choose(b, j);
+      suitIndex[s + i] = b - (j - 1);
+    }
+  }
+
+  //per suit, undo the rank index of the hand cards and the board cards
+  unsigned masks[NUMSUITS][NUMPARTS] = { { 0 } };
+  for(int s = 0; s < NUMSUITS; s++)
+  {
+    unsigned used = 0;
+    CanonicalIndex rest = suitIndex[s];
+    for(int p = 0; p < NUMPARTS; p++)
+    {
+      int count = getShapeCount(c.shapes[s], p);
+      CanonicalIndex size = choose(NUMRANKS - countBits(used), count);
+      masks[s][p] = expandRanks(getSetFromIndex(rest % size, count), used);
+      rest /= size;
+      used |= masks[s][p];
+    }
+  }
+
+  int n = 0;
+  for(int p = 0; p < NUMPARTS; p++)
+  for(int s = 0; s < NUMSUITS; s++)
+  for(int rank = 0; rank < NUMRANKS; rank++)
+  {
+    if(masks[s][p] & (1u << rank)) cards[n++] = s * NUMRANKS + rank;
+  }
+}
+
+CanonicalIndex getCanonicalIndex(const std::vector<Card>& holeCards, const std::vector<Card>& boardCards)
+{
+  int cards[7];
+  int n = 0;
+  for(size_t i = 0; i < holeCards.size() && n < 7; i++) cards[n++] = eval7_index(holeCards[i]);
+  for(size_t i = 0; i < boardCards.size() && n < 7; i++) cards[n++] = eval7_index(boardCards[i]);
+  return getCanonicalIndex(cards, n);
+}
+
+void getCanonicalCards(std::vector<Card>& holeCards, std::vector<Card>& boardCards, Round round, CanonicalIndex index)
+{
+  int cards[7];
+  getCanonicalCards(cards, round, index);
+
+  int numBoard = round == R_PRE_FLOP ? 0 : round + 2;
+  holeCards.clear();
+  boardCards.clear();
+  for(int i = 0; i < 2 + numBoard; i++)
+  {
+    //eval7_index is suit * 13 + value - 2
+    Card card(cards[i] % NUMRANKS + 2, (Suit)(cards[i] / NUMRANKS));
+    if(i < 2) holeCards.push_back(card);
+    else boardCards.push_back(card);
+  }
+}
+
+Round getRoundForBoardSize(int numBoardCards)
+{
+  if(numBoardCards < 3) return R_PRE_FLOP;
+  if(numBoardCards == 3) return R_FLOP;
+  if(numBoardCards == 4) return R_TURN;
+  return R_RIVER;
+}
@@ -0,0 +1,75 @@
+/*
+OOPoker
+
+Copyright (c) 2010 Lode Vandevenne
+All rights reserved.
+
+This file is part of OOPoker.
+
+OOPoker is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+OOPoker is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with OOPoker.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+/*
+Suit-isomorphic indexing of your hand cards together with the board.
+
+Two situations are isomorphic if one can be turned into the other by renaming the suits, for example
+AhKh on 2h7c9d is the same as AsKs on 2s7d9c. The order of the hand cards doesn't matter, and neither
+does the order of the board cards (a flop card and the turn card can be swapped). Everything that only
+depends on your own cards and the board (equity, hand strength, abstraction buckets, ...) has the same
+value for all isomorphic situations, so it only needs to be computed or stored once per canonical index.
+
+The indices are dense: they go from 0 to getCanonicalSize(round) - 1, so they can directly be used as
+index in a table. The amounts are:
+pre-flop: 169 (instead of 1326)
+flop: 1286792 (instead of 25989600)
+turn: 13960050 (instead of 305377800)
+river: 123156254 (instead of 2809475760)
+
+The cards are given in eval7 indices (see eval7_index in pokermath.h), the hand cards first, then the
+board cards, e.g. 7 cards at the river. There are also convenience versions with Card.
+
+This is the same idea as the hand isomorphism algorithm of Kevin Waugh, with the hand cards and the board
+as the two rounds: per suit, the ranks of its hand cards and board cards form an index, the suits with the
+same amount of hand and board cards are grouped and their indices combined as multiset, and each way to
+divide the cards over the suits gets its own range of indices.
+*/
+
+#include <vector>
+
+#include "card.h"
+#include "rules.h"
+
+typedef unsigned long long CanonicalIndex;
+
+//amount of canonical indices at this round (R_PRE_FLOP up to R_RIVER)
+CanonicalIndex getCanonicalSize(Round round);
+
+/*
+Returns the canonical index of the cards. numCards must be 2, 5, 6 or 7 (pre-flop, flop, turn, river).
+The cards must all be different.
+*/
+CanonicalIndex getCanonicalIndex(const int* cards /*eval7_index*/, int numCards);
+CanonicalIndex getCanonicalIndex(const std::vector<Card>& holeCards, const std::vector<Card>& boardCards);
+
+/*
+The inverse: returns a representative of the index, that is, cards that have this index. The output array
+must have room for 2, 5, 6 or 7 cards depending on the round.
+*/
+void getCanonicalCards(int* cards /*eval7_index*/, Round round, CanonicalIndex index);
+void getCanonicalCards(std::vector<Card>& holeCards, std::vector<Card>& boardCards, Round round, CanonicalIndex index);
+
+//the round for the amount of board cards (0, 3, 4 or 5)
+Round getRoundForBoardSize(int numBoardCards);
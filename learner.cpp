@@ -0,0 +1,152 @@
+#include "learner.h"
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include "ai_rl.h"
+
+LearnerSettings::LearnerSettings()
+  : replay_capacity(100000), min_replay(1000), update_every(256), batch_size(256), epochs(4)
+  , ppo(true), clip(0.2f), max_grad_norm(1.0f), baseline_decay(0.99f), seed(0), offline_fraction(0.5f) {}
+
+Learner::Learner(PokerNet& net, torch::optim::Optimizer& optimizer, const LearnerSettings& settings)
+  : net(net), optimizer(optimizer), settings(settings), replay(settings.replay_capacity), random(settings.seed)
+  , weights_version(0), added(0), added_at_update(0), updates(0), baseline(0.0f), last_loss(0.0f)
+{
+  if (!settings.spill_file.empty() && !spill.open(settings.spill_file)) {
+    std::cerr << "--- [ERROR] Can't open trajectory file " << settings.spill_file << " ---" << std::endl;
+  }
+} // end of constructor
+
+bool Learner::load_offline(const std::string& filename)
+{
+  // only the states the net can take, a file can also have those of runs with another network input
+  int input_size = (int)net->card_embedding->options.in_features();
+  if (!offline.open(filename, input_size)) return false;
+  if (offline.getNumSteps() == 0 || offline.getStateSize() != input_size) {
+    offline.close();
+    return false;
+  }
+  return true;
+} // end of load_offline
+
+void Learner::add(Trajectory& trajectory)
+{
+  {
+    std::lock_guard<std::mutex> lock(baseline_mutex);
+    float decay = added.load() == 0 ? 0.0f : settings.baseline_decay;
+    baseline = decay * baseline.load() + (1.0f - decay) * trajectory.reward;
+  }
+  if (spill.isOpen()) spill.add(trajectory);
+  replay.add(trajectory);
+  added++;
+} // end of add
+
+bool Learner::ready() const
+{
+  return added.load() - added_at_update.load() >= settings.update_every
+      && (long long)replay.getSize() >= settings.min_replay;
+} // end of ready
+
+void Learner::update()
+{
+  added_at_update = added.load();
+
+  // the offline part of the batch, or all of it if nothing was added yet
+  size_t num_offline = 0;
+  if (offline.getNumTrajectories() > 0) {
+    num_offline = replay.getSize() == 0 ? settings.batch_size : (size_t)(settings.batch_size * settings.offline_fraction + 0.5f);
+  }
+  replay.sample(batch, settings.batch_size - num_offline, random);
+  if (num_offline > 0) {
+    offline.sample(offline_batch, num_offline, random);
+    for (size_t i = 0; i < offline_batch.size(); i++) batch.push_back(std::move(offline_batch[i]));
+  }
+  if (batch.empty()) return;
+
+  // flatten the decisions of all sampled deals into batch tensors
+  std::vector<float> states, actions, old_means, advantages;
+  std::vector<torch::Tensor> histories;
+  std::vector<int64_t> lengths;
+  int64_t input_size = 0;
+  float current_baseline = baseline.load();
+  for (size_t i = 0; i < batch.size(); i++) {
+    for (size_t j = 0; j < batch[i].steps.size(); j++) {
+      TrajectoryStep& step = batch[i].steps[j];
+      input_size = (int64_t)step.state.size();
+      states.insert(states.end(), step.state.begin(), step.state.end());
+      actions.insert(actions.end(), step.action, step.action + 2);
+      old_means.insert(old_means.end(), step.mean, step.mean + 2);
+      advantages.push_back(batch[i].reward - current_baseline);
+      int64_t len = (int64_t)step.history.size() / 3;
+      histories.push_back(torch::from_blob(step.history.data(), {len, 3}, torch::kFloat));
+      lengths.push_back(len);
+    }
+  }
+  int64_t n = (int64_t)advantages.size();
+  if (n == 0) return;
+
+  torch::Tensor state = torch::from_blob(states.data(), {n, input_size}, torch::kFloat);
+  torch::Tensor history = torch::nn::utils::rnn::pad_sequence(histories); // [max_len, n, 3]
+  torch::Tensor length = torch::tensor(lengths);
+  torch::Tensor action = torch::from_blob(actions.data(), {n, 2}, torch::kFloat);
+  torch::Tensor old_mean = torch::from_blob(old_means.data(), {n, 2}, torch::kFloat);
+  torch::Tensor advantage = torch::from_blob(advantages.data(), {n}, torch::kFloat);
+  if (n > 1) advantage = advantage / (advantage.std() + 1e-6f); // only the scale, the baseline already centers it
+  torch::Tensor opp = torch::zeros({n, 10});
+
+  // log probability of the gaussian exploration of AIRL, without the constant that cancels out anyway
+  const float sigma = AIRL::NOISE_SCALE;
+  torch::Tensor old_log_prob = -0.5f * torch::pow((action - old_mean) / sigma, 2).sum(1);
+
+  net->train();
+  for (int epoch = 0; epoch < settings.epochs; epoch++) {
+    torch::Tensor mean = std::get<0>(net->forward_batch(state, history, length, opp, net->initial_state(n)));
+    torch::Tensor log_prob = -0.5f * torch::pow((action - mean) / sigma, 2).sum(1);
+
+    torch::Tensor loss;
+    if (settings.ppo) {
+      torch::Tensor ratio = torch::exp(log_prob - old_log_prob);
+      torch::Tensor clipped = torch::clamp(ratio, 1.0f - settings.clip, 1.0f + settings.clip);
+      loss = -torch::min(ratio * advantage, clipped * advantage).mean();
+    } else {
+      loss = -(log_prob * advantage).mean();
+    }
+
+    optimizer.zero_grad();
+    loss.backward();
+    if (settings.max_grad_norm > 0) torch::nn::utils::clip_grad_norm_(net->parameters(), settings.max_grad_norm);
+    {
+      std::lock_guard<std::mutex> lock(weights_mutex);
+      optimizer.step();
+      weights_version++;
+    }
+    last_loss = loss.item<float>();
+  }
+  updates++;
+} // end of update
+
+PokerNet& Learner::get_net()
+{
+  return net;
+} // end of get_net
+
+std::mutex& Learner::get_weights_mutex()
+{
+  return weights_mutex;
+} // end of get_weights_mutex
+
+int Learner::get_weights_version() const
+{
+  return weights_version.load();
+} // end of get_weights_version
+
+LearnerStats Learner::get_stats() const
+{
+  LearnerStats stats;
+  stats.trajectories = added.load();
+  stats.updates = updates.load();
+  stats.replay_size = replay.getSize();
+  stats.baseline = baseline.load();
+  stats.last_loss = last_loss.load();
+  return stats;
+} // end of get_stats
@@ -0,0 +1,90 @@
+#pragma once
+#include <torch/torch.h>
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "poker_net.h"
+#include "random.h"
+#include "replaybuffer.h"
+#include "trajectory.h"
+#include "trajectoryfile.h"
+
+struct LearnerSettings {
+    size_t replay_capacity; // trajectories kept in the replay buffer
+    int min_replay;         // no updates before the replay buffer has this many trajectories
+    int update_every;       // new trajectories between two updates, so every update is amortized over this many hands
+    int batch_size;         // trajectories sampled from the replay buffer per update
+    int epochs;             // gradient steps per update on the same batch
+    bool ppo;               // clipped PPO objective, otherwise REINFORCE with baseline
+    float clip;             // PPO clip range of the probability ratio
+    float max_grad_norm;    // gradients are clipped to this norm, 0 for no clipping
+    float baseline_decay;   // the baseline is an exponential moving average of the rewards with this decay
+    uint64_t seed;          // for sampling the replay buffer
+    std::string spill_file; // if not empty, every added trajectory is also appended to this trajectory file (see trajectoryfile.h)
+    float offline_fraction; // part of every batch that comes from the offline file, if one is loaded
+
+    LearnerSettings();
+};
+
+struct LearnerStats {
+    long long trajectories; // added so far
+    long long updates;
+    size_t replay_size;
+    float baseline;         // current average reward, in big blinds per deal
+    float last_loss;
+};
+
+/*
+Policy gradient learner for PokerNet. The actors (AIRL agents) only play and hand in their trajectories
+with add, the rewards are the stack differences of their deals. The learner keeps them in a replay buffer
+and, every update_every new trajectories, does an update on a random batch: the advantage of a decision
+is the reward of its deal minus a moving average baseline (normalized over the batch), and the loss is
+either plain REINFORCE or the clipped PPO objective. PPO uses the network output stored at acting time
+as the old policy, which also keeps replayed old trajectories from pushing the policy too far.
+
+add and ready can be called from any thread, update from one thread at a time. Whoever runs the
+network in another thread during update must hold get_weights_mutex() while doing so, unless it
+works on its own copy of the weights.
+
+Trajectories of earlier runs can be used too: load_offline memory-maps a trajectory file (e.g. the
+spill_file of an earlier run), and from then on offline_fraction of every batch is sampled from it. To
+train only offline, load a file and call update in a loop, without adding anything.
+*/
+class Learner {
+public:
+    Learner(PokerNet& net, torch::optim::Optimizer& optimizer, const LearnerSettings& settings = LearnerSettings());
+
+    void add(Trajectory& trajectory); // moves the trajectory into the replay buffer
+    bool ready() const; // true if update_every trajectories came in since the last update and the replay buffer is big enough
+    void update();
+
+    bool load_offline(const std::string& filename); // only uses the trajectories with the input size of the net, returns false if there are none
+
+    PokerNet& get_net();
+    std::mutex& get_weights_mutex(); // held while the optimizer changes the weights
+    int get_weights_version() const; // increases with every optimizer step
+    LearnerStats get_stats() const;
+
+private:
+    PokerNet& net;
+    torch::optim::Optimizer& optimizer;
+    LearnerSettings settings;
+
+    ReplayBuffer replay;
+    RandomStream random;
+    std::vector<Trajectory> batch;
+    std::vector<Trajectory> offline_batch;
+    TrajectoryWriter spill;
+    TrajectoryFile offline;
+
+    std::mutex weights_mutex;
+    std::atomic<int> weights_version;
+    std::atomic<long long> added;
+    std::atomic<long long> added_at_update; // value of added at the last update
+    std::atomic<long long> updates;
+    std::atomic<float> baseline;
+    std::atomic<float> last_loss;
+    std::mutex baseline_mutex;
+};
@@ -0,0 +1,133 @@
+/*
+OOPoker
+
+Copyright (c) 2010 Lode Vandevenne
+All rights reserved.
+
+This file is part of OOPoker.
+
+OOPoker is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+OOPoker is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with OOPoker.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <utility>
+
+/*
+Bounded multi-producer multi-consumer queue that doesn't use locks (the array based queue of Dmitry
+Vyukov). Used to pass work between threads that must never wait for each other, such as the self-play
+tables handing finished hands to the learner.
+
+Every cell has a sequence number that tells whether it's ready to be written or to be read in the
+current lap around the array, so producers and consumers only contend on their own position counter.
+The capacity is rounded up to a power of two. tryPush and tryPop return false instead of waiting when
+the queue is full or empty, what to do then (retry, drop, sleep) is up to the caller.
+*/
+template<typename T>
+class LockFreeQueue
+{
+  public:
+    LockFreeQueue(size_t capacity)
+    : mask(roundCapacity(capacity) - 1)
+    , cells(new Cell[mask + 1])
+    , enqueuePos(0)
+    , dequeuePos(0)
+    {
+      for(size_t i = 0; i <= mask; i++) cells[i].sequence.store(i, std::memory_order_relaxed);
+    }
+
+    //moves value into the queue if there's room, otherwise leaves value alone and returns false
+    bool tryPush(T& value)
+    {
+      Cell* cell;
+      size_t pos = enqueuePos.load(std::memory_order_relaxed);
+      for(;;)
+      {
+        cell = &cells[pos & mask];
+        size_t sequence = cell->sequence.load(std::memory_order_acquire);
+        ptrdiff_t diff = (ptrdiff_t)sequence - (ptrdiff_t)pos;
+        if(diff == 0)
+        {
+          if(enqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) break;
+        }
+        else if(diff < 0) return false; //full
+        else pos = enqueuePos.load(std::memory_order_relaxed);
+      }
+      cell->data = std::move(value);
+      cell->sequence.store(pos + 1, std::memory_order_release);
+      return true;
+    }
+
+    //moves the oldest element into value, returns false if the queue is empty
+    bool tryPop(T& value)
+    {
+      Cell* cell;
+      size_t pos = dequeuePos.load(std::memory_order_relaxed);
+      for(;;)
+      {
+        cell = &cells[pos & mask];
+        size_t sequence = cell->sequence.load(std::memory_order_acquire);
+        ptrdiff_t diff = (ptrdiff_t)sequence - (ptrdiff_t)(pos + 1);
+        if(diff == 0)
+        {
+          if(dequeuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) break;
+        }
+        else if(diff < 0) return false; //empty
+        else pos = dequeuePos.load(std::memory_order_relaxed);
+      }
+      value = std::move(cell->data);
+      cell->sequence.store(pos + mask + 1, std::memory_order_release);
+      return true;
+    }
+
+    //amount of elements, only exact when no other thread is pushing or popping at the same time
+    size_t getSizeApprox() const
+    {
+      size_t pushed = enqueuePos.load(std::memory_order_relaxed);
+      size_t popped = dequeuePos.load(std::memory_order_relaxed);
+      return pushed > popped ? pushed - popped : 0;
+    }
+
+    size_t getCapacity() const
+    {
+      return mask + 1;
+    }
+
+  private:
+    LockFreeQueue(const LockFreeQueue&); //not copyable
+    LockFreeQueue& operator=(const LockFreeQueue&);
+
+    static size_t roundCapacity(size_t capacity)
+    {
+      size_t result = 2;
+      while(result < capacity) result *= 2;
+      return result;
+    }
+
+    struct Cell
+    {
+      std::atomic<size_t> sequence;
+      T data;
+    };
+
+    const size_t mask;
+    std::unique_ptr<Cell[]> cells;
+    //on separate cache lines, so producers and consumers don't slow each other down
+    alignas(64) std::atomic<size_t> enqueuePos;
+    alignas(64) std::atomic<size_t> dequeuePos;
+};
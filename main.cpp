@@ -58,6 +58,7 @@ for his/her enjoyment.
 #include "info.h"
 #include "io_terminal.h"
 #include "observer.h"
+#include "observer_async.h"
 #include "observer_terminal.h"
 #include "observer_terminal_quiet.h"
 #include "observer_log.h"
@@ -69,10 +70,12 @@ for his/her enjoyment.
 #include <torch/torch.h>
 #include "poker_net.h"
 #include "ai_rl.h" 
+#include "learner.h"
+#include "selfplay.h"
 
 // returns whether user wants to quit
 
-bool doGame(PokerNet& net, torch::optim::Optimizer& optimizer)
+bool doGame(PokerNet& net, Learner& learner)
 {
   std::cout << "Welcome to OOPoker RL Trainer\n" << std::endl;
 
@@ -82,6 +85,7 @@ bool doGame(PokerNet& net, torch::optim::Optimizer& optimizer)
 3: AI battle\n\
 4: AI battle heads-up\n\
 6: RL Self-Play Training (NEW)\n\
+7: RL Self-Play Arena (many tables at once, all CPU cores)\n\
 q: quit" << std::endl;
   
 //  char c = getChar();
@@ -90,6 +94,15 @@ q: quit" << std::endl;
   int gameType = (c == '6') ? 6 : (c - '0');
   if(c == 'q') return true;
 
+  if(gameType == 7) // RL self-play on parallel tables, see selfplay.h
+  {
+    SelfPlayArena arena(learner);
+    arena.run(100000);
+    torch::save(net, "./logs/poker_model.pt");
+    std::cout << "Model saved to ./logs/poker_model.pt" << std::endl;
+    return false;
+  }
+
   Rules rules;
   rules.buyIn = 1000;
   rules.bigBlind = 10;
@@ -107,15 +120,19 @@ q: quit" << std::endl;
   {
     rules.smallBlind = 5;
     std::cout << "Starting Self-Play Session..." << std::endl;
-    // use standard terminal observer to see progress
-    game.addObserver(new ObserverTerminalQuiet());
+    // use standard terminal observer to see progress, printing on its own thread so it doesn't slow down training
+    game.addObserver(new ObserverAsync(new ObserverTerminalQuiet()));
 
     // both players use the SAME network (shared_ptr) to learn against themselves
     //auto agent1 = std::make_shared<AIRL>(net, optimizer);
     //auto agent2 = std::make_shared<AIRL>(net, optimizer);
 
-    AIRL* agent1 = new AIRL(net, optimizer);
-    AIRL* agent2 = new AIRL(net, optimizer);
+    // every deal the agent played goes to the learner, which updates the net every few hundred deals
+    AIRL* agent1 = new AIRL(net, [&learner](Trajectory& trajectory) {
+      learner.add(trajectory);
+      if (learner.ready()) learner.update();
+    });
+    AIRL* agent2 = new AIRL(net);
 
     game.addPlayer(Player(agent1, "RL_Agent_A"));
     game.addPlayer(Player(new AISmart() , "AISmart -- from oopoker"));
@@ -193,7 +210,7 @@ q: quit" << std::endl;
   else if(gameType == 3) // example of using the bot in a normal battle
   {
     game.addObserver(new ObserverTerminal());
-    game.addPlayer(Player(new AIRL(net, optimizer), "Trained_Bot"));
+    game.addPlayer(Player(new AIRL(net), "Trained_Bot"));
     for(int i = 0; i < 5; ++i) game.addPlayer(Player(new AISmart(), getRandomName()));
   }
 
@@ -213,6 +230,14 @@ int main()
     // 1. Initialize the global neural network and optimizer
     PokerNet global_net(23, 128);
     torch::optim::Adam optimizer(global_net->parameters(), 1e-4);
+    // every played deal is also saved, and the deals of earlier runs are replayed
+    LearnerSettings learner_settings;
+    std::string trajectory_path = "./logs/trajectories.dat";
+    learner_settings.spill_file = trajectory_path;
+    Learner learner(global_net, optimizer, learner_settings); // keeps its replay buffer over all sessions
+    if (learner.load_offline(trajectory_path)) {
+        std::cout << "--- [INFO] Replaying trajectories of earlier runs from " << trajectory_path << " ---" << std::endl;
+    }
     CheckpointManager cp_manager("poker_model", 1000);
 
     // 2. Load existing weights if they exist
@@ -231,7 +256,7 @@ int main()
 
     // 3. Training Loop
     for(int epoch = 0; ; epoch++) {
-        bool quit = doGame(global_net, optimizer);
+        bool quit = doGame(global_net, learner);
         
         // every 10 sessions, run a formal evaluation
         if (epoch % 10 == 0) {
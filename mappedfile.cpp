@@ -0,0 +1,168 @@
+/*
+OOPoker
+
+Copyright (c) 2010 Lode Vandevenne
+All rights reserved.
+
+This file is part of OOPoker.
+
+OOPoker is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+OOPoker is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with OOPoker.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "mappedfile.h"
+
+#include <cstdio>
+
+#if !defined(_WIN32)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+MappedFile::MappedFile()
+: data(0)
+, size(0)
+, mapped(false)
+{
+}
+
+MappedFile::~MappedFile()
+{
+  close();
+}
+
+#if defined(_WIN32)
+
+bool MappedFile::open(const std::string& filename)
+{
+  close();
+
+  FILE* file = fopen(filename.c_str(), "rb");
+  if(!file) return false;
+
+  fseek(file, 0, SEEK_END);
+  long fileSize = ftell(file);
+  fseek(file, 0, SEEK_SET);
+
+  if(fileSize > 0)
+  {
+    buffer.resize(fileSize);
+    if(fread(&buffer[0], 1, fileSize, file) != (size_t)fileSize) buffer.clear();
+  }
+  fclose(file);
+
+  if(buffer.empty()) return false;
+
+  data = &buffer[0];
+  size = buffer.size();
+  return true;
+}
+
+void MappedFile::close()
+{
+  buffer.clear();
+  data = 0;
+  size = 0;
+}
+
+#else
+
+bool MappedFile::open(const std::string& filename)
+{
+  close();
+
+  int fd = ::open(filename.c_str(), O_RDONLY);
+  if(fd < 0) return false;
+
+  struct stat st;
+  if(fstat(fd, &st) != 0 || st.st_size <= 0)
+  {
+    ::close(fd);
+    return false;
+  }
+
+  void* p = mmap(0, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  ::close(fd); //the mapping stays valid after closing the file descriptor
+  if(p == MAP_FAILED) return false;
+
+  data = (const unsigned char*)p;
+  size = (size_t)st.st_size;
+  mapped = true;
+  return true;
+}
+
+void MappedFile::close()
+{
+  if(mapped) munmap((void*)data, size);
+  buffer.clear();
+  data = 0;
+  size = 0;
+  mapped = false;
+}
+
+#endif
+
+bool MappedFile::isOpen() const
+{
+  return data != 0;
+}
+
+const unsigned char* MappedFile::getData() const
+{
+  return data;
+}
+
+size_t MappedFile::getSize() const
+{
+  return size;
+}
+
+bool writeFileAtomic(const std::string& filename, const void* data, size_t size)
+{
+  std::string temp = filename + ".tmp";
+
+  FILE* file = fopen(temp.c_str(), "wb");
+  if(!file) return false;
+
+  bool success = fwrite(data, 1, size, file) == size;
+  success = (fflush(file) == 0) && success;
+#if !defined(_WIN32)
+  success = success && (fsync(fileno(file)) == 0);
+#endif
+  success = (fclose(file) == 0) && success;
+
+  if(success)
+  {
+#if defined(_WIN32)
+    std::remove(filename.c_str()); //rename doesn't overwrite on Windows
+#endif
+    success = std::rename(temp.c_str(), filename.c_str()) == 0;
+  }
+
+  if(!success) std::remove(temp.c_str());
+  return success;
+}
+
+unsigned getDataChecksum(const void* data, size_t size)
+{
+  const unsigned char* bytes = (const unsigned char*)data;
+  unsigned hash = 2166136261u;
+  for(size_t i = 0; i < size; i++)
+  {
+    hash ^= bytes[i];
+    hash *= 16777619u;
+  }
+  return hash;
+}
@@ -0,0 +1,64 @@
+/*
+OOPoker
+
+Copyright (c) 2010 Lode Vandevenne
+All rights reserved.
+
+This file is part of OOPoker.
+
+OOPoker is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+OOPoker is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with OOPoker.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <string>
+#include <vector>
+
+/*
+Read-only view of a whole file, for the big generated tables. On Linux (and other POSIX systems) the file
+is memory-mapped, so it costs no loading time and the operating system shares it between processes. On
+Windows the file is simply read into memory instead.
+*/
+class MappedFile
+{
+  public:
+    MappedFile();
+    ~MappedFile();
+
+    bool open(const std::string& filename); //returns false if the file can't be opened or is empty
+    void close();
+
+    bool isOpen() const;
+    const unsigned char* getData() const;
+    size_t getSize() const;
+
+  private:
+    MappedFile(const MappedFile&); //not copyable
+    MappedFile& operator=(const MappedFile&);
+
+    const unsigned char* data;
+    size_t size;
+    bool mapped; //if false, data points into buffer
+    std::vector<unsigned char> buffer;
+};
+
+/*
+Writes the file in a way that never leaves a half written file behind: it's first written to
+filename + ".tmp", and only renamed to filename once it's complete.
+Returns false on error.
+*/
+bool writeFileAtomic(const std::string& filename, const void* data, size_t size);
+
+//FNV-1a hash, used as checksum of the data in generated table files
+unsigned getDataChecksum(const void* data, size_t size);
@@ -0,0 +1,84 @@
+/*
+OOPoker
+
+Copyright (c) 2010 Lode Vandevenne
+All rights reserved.
+
+This file is part of OOPoker.
+
+OOPoker is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+OOPoker is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with OOPoker.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include "nametable.h"
+
+#include <atomic>
+#include <cstdlib>
+#include <iostream>
+#include <mutex>
+#include <unordered_map>
+
+/*
+The names are stored in chunks that are allocated once and never move or get freed. internName only
+publishes a new count after the name and its chunk are written, so getInternedName can read without
+the mutex: every id below the count is complete.
+*/
+namespace
+{
+  const int CHUNK_BITS = 10;
+  const int CHUNK_SIZE = 1 << CHUNK_BITS;
+  const int MAX_CHUNKS = 65536; //64M names
+
+  std::mutex nameMutex; //for adding names
+  std::string* chunks[MAX_CHUNKS];
+  std::atomic<int> numNames(0);
+  std::unordered_map<std::string, int> nameIds;
+}
+
+int internName(const std::string& name)
+{
+  std::lock_guard<std::mutex> lock(nameMutex);
+  std::unordered_map<std::string, int>::iterator it = nameIds.find(name);
+  if(it != nameIds.end()) return it->second;
+
+  int id = numNames.load(std::memory_order_relaxed);
+  if((id & (CHUNK_SIZE - 1)) == 0)
+  {
+    if((id >> CHUNK_BITS) >= MAX_CHUNKS)
+    {
+      std::cerr << "Too many player names. Quitting program." << std::endl;
+      std::exit(1);
+    }
+    chunks[id >> CHUNK_BITS] = new std::string[CHUNK_SIZE];
+  }
+  chunks[id >> CHUNK_BITS][id & (CHUNK_SIZE - 1)] = name;
+  nameIds[name] = id;
+  numNames.store(id + 1, std::memory_order_release);
+  return id;
+}
+
+int findInternedName(const std::string& name)
+{
+  std::lock_guard<std::mutex> lock(nameMutex);
+  std::unordered_map<std::string, int>::iterator it = nameIds.find(name);
+  return it == nameIds.end() ? -1 : it->second;
+}
+
+const std::string& getInternedName(int id)
+{
+  static const std::string none;
+  //acquire pairs with the release in internName, so the name is visible even if the id came from another thread
+  if(id < 0 || id >= numNames.load(std::memory_order_acquire)) return none;
+  return chunks[id >> CHUNK_BITS][id & (CHUNK_SIZE - 1)];
+}
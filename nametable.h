@@ -0,0 +1,40 @@
+/*
+OOPoker
+
+Copyright (c) 2010 Lode Vandevenne
+All rights reserved.
+
+This file is part of OOPoker.
+
+OOPoker is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+OOPoker is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with OOPoker.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#pragma once
+
+/*
+Interned player names: every name gets a small id, and the same name always gets the same id. The Info
+an AI gets for each decision stores the ids instead of copies of the names, so that filling it in
+doesn't copy strings. The name behind an id never changes, and the reference to it stays valid for the
+whole program.
+
+Thread safe, several games can run at the same time (e.g. the self-play arena). Only adding a name takes
+a lock, getting the name of an id doesn't.
+*/
+
+#include <string>
+
+int internName(const std::string& name); //returns the id of the name, adds it if it's new
+const std::string& getInternedName(int id); //id must come from internName, an empty string otherwise
+int findInternedName(const std::string& name); //the id of the name, or -1 if it was never added. Doesn't add it.
@@ -36,4 +36,6 @@ class Observer
     virtual ~Observer(){}
 
     virtual void onEvent(const Event& event) = 0;
+
+    virtual void flush() {} //returns once all events given so far are fully processed, for observers that process them later (see ObserverAsync)
 };
@@ -0,0 +1,127 @@
+/*
+OOPoker
+
+Copyright (c) 2010 Lode Vandevenne
+All rights reserved.
+
+This file is part of OOPoker.
+
+OOPoker is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+OOPoker is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with OOPoker.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include "observer_async.h"
+
+ObserverAsync::ObserverAsync(Observer* observer, AsyncBackpressure backpressure, size_t capacity)
+: observer(observer)
+, backpressure(backpressure)
+, queue(capacity, Event(E_NUM_EVENTS))
+, pendingBegin(0)
+, numPushed(0)
+, numDropped(0)
+, numProcessed(0)
+, quit(false)
+, sleeping(false)
+{
+  thread = std::thread(&ObserverAsync::run, this);
+}
+
+ObserverAsync::~ObserverAsync()
+{
+  flush();
+  {
+    std::lock_guard<std::mutex> lock(wakeMutex);
+    quit = true;
+  }
+  wake.notify_one();
+  thread.join();
+  delete observer;
+}
+
+void ObserverAsync::run()
+{
+  for(;;)
+  {
+    Event* event = queue.front();
+    if(event)
+    {
+      observer->onEvent(*event);
+      queue.pop();
+      numProcessed.fetch_add(1, std::memory_order_release);
+      continue;
+    }
+    if(quit) break;
+
+    //the fences of here and wakeObserver make sure that either the game sees sleeping, or this sees its event
+    std::unique_lock<std::mutex> lock(wakeMutex);
+    sleeping.store(true, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    wake.wait(lock, [this]() { return queue.front() != 0 || quit; });
+    sleeping.store(false, std::memory_order_relaxed);
+  }
+}
+
+void ObserverAsync::wakeObserver()
+{
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  if(sleeping.load(std::memory_order_relaxed))
+  {
+    std::lock_guard<std::mutex> lock(wakeMutex);
+    wake.notify_one();
+  }
+}
+
+bool ObserverAsync::pushPending()
+{
+  while(pendingBegin < pending.size())
+  {
+    if(!queue.tryPush(pending[pendingBegin])) return false;
+    pendingBegin++;
+    numPushed++;
+    wakeObserver();
+  }
+  pending.clear(); //keeps its capacity for the next time the observer falls behind
+  pendingBegin = 0;
+  return true;
+}
+
+void ObserverAsync::onEvent(const Event& event)
+{
+  if(backpressure == ASYNC_BUFFER)
+  {
+    //events that are already waiting go first, to keep the order
+    if(!pushPending() || !queue.tryPush(event))
+    {
+      pending.push_back(event);
+      return;
+    }
+  }
+  else if(!queue.tryPush(event))
+  {
+    if(backpressure == ASYNC_DROP)
+    {
+      numDropped++;
+      return;
+    }
+    while(!queue.tryPush(event)) std::this_thread::yield();
+  }
+  numPushed++;
+  wakeObserver();
+}
+
+void ObserverAsync::flush()
+{
+  while(!pushPending()) std::this_thread::yield();
+  while(numProcessed.load(std::memory_order_acquire) < numPushed) std::this_thread::yield();
+}
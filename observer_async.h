@@ -0,0 +1,87 @@
+/*
+OOPoker
+
+Copyright (c) 2010 Lode Vandevenne
+All rights reserved.
+
+This file is part of OOPoker.
+
+OOPoker is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+OOPoker is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with OOPoker.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#pragma once
+
+#include "event.h"
+#include "observer.h"
+#include "spscqueue.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+//what ObserverAsync does with an event when its queue is full
+enum AsyncBackpressure
+{
+  ASYNC_BLOCK, //the game waits until the observer thread has made room. No event is lost.
+  ASYNC_DROP, //the event is thrown away (counted, see getNumDropped). The game never waits.
+  ASYNC_BUFFER //the event goes into a buffer on the game thread, handed over in order once there's room. None are lost and the game never waits, but the buffer has no limit: it grows for as long as the observer is behind.
+};
+
+/*
+Runs another observer on its own thread, so that a slow observer (writing a log to disk, printing to the
+terminal) doesn't slow down the game. onEvent only copies the event into a single-producer single-consumer
+queue, and the thread of this observer takes them out and gives them to the wrapped observer, in the same
+order. When the queue is empty the thread sleeps until the game pushes again.
+
+The game calls flush before onGameDone of the host, so by then the wrapped observer has seen every event.
+Use flush yourself before reading results out of the wrapped observer at other times.
+*/
+class ObserverAsync : public Observer
+{
+  public:
+    //takes ownership of observer
+    ObserverAsync(Observer* observer, AsyncBackpressure backpressure = ASYNC_BLOCK, size_t capacity = 4096);
+    virtual ~ObserverAsync(); //lets the observer process the remaining events, then deletes it
+
+    virtual void onEvent(const Event& event);
+    virtual void flush(); //returns once the wrapped observer has processed every event given so far (except dropped ones)
+
+    Observer* getObserver() { return observer; }
+    size_t getNumDropped() const { return numDropped; }
+
+  private:
+    ObserverAsync(const ObserverAsync&); //not copyable
+    ObserverAsync& operator=(const ObserverAsync&);
+
+    void run(); //the observer thread
+    bool pushPending(); //moves buffered events (ASYNC_BUFFER) into the queue while there's room, returns true if none are left
+    void wakeObserver(); //call after pushing to the queue
+
+    Observer* observer;
+    AsyncBackpressure backpressure;
+    SPSCQueue<Event> queue;
+    std::vector<Event> pending; //only used with ASYNC_BUFFER
+    size_t pendingBegin; //first event of pending that isn't in the queue yet
+    size_t numPushed; //events given to the queue
+    size_t numDropped;
+    std::atomic<size_t> numProcessed; //events the wrapped observer is done with
+    std::atomic<bool> quit;
+    std::atomic<bool> sleeping; //the observer thread waits for wake, or is about to
+    std::mutex wakeMutex;
+    std::condition_variable wake;
+    std::thread thread;
+};
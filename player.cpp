@@ -24,6 +24,7 @@ along with OOPoker.  If not, see <http://www.gnu.org/licenses/>.
 #include "info.h"
 #include "ai.h"
 #include "ai_human.h"
+#include "nametable.h"
 #include "random.h"
 
 #include <set>
@@ -36,6 +37,7 @@ Player::Player(AI* ai, const std::string& name)
 , folded(false)
 , showdown(false)
 , name(name)
+, nameId(internName(name))
 {
 }
 
@@ -55,6 +55,7 @@ struct Player
   bool showdown; //this player (has to or wants to) show their cards
 
   std::string name;
+  int nameId; //internName(name), see nametable.h
 
   Action lastAction; //used for filling it in the Info
 
@@ -101,6 +101,48 @@ struct PokerNetImpl : torch::nn::Module {
 
         return action_head(combined);
     }
+
+    // the recurrent state (h, c) of the lstm, both [1, batch, hidden]
+    typedef std::tuple<torch::Tensor, torch::Tensor> State;
+
+    State initial_state(int64_t batch = 1) {
+        int64_t hidden = rnn->options.hidden_size();
+        return State(torch::zeros({1, batch, hidden}), torch::zeros({1, batch, hidden}));
+    }
+
+    // the output vector for a given last hidden state [batch, hidden], without running the lstm
+    torch::Tensor forward_from_hidden(torch::Tensor static_feat, torch::Tensor last_hidden, torch::Tensor opp_ctx) {
+        auto x_static = torch::relu(card_embedding(static_feat));
+        auto x_opp = torch::relu(opponent_context(opp_ctx));
+        auto combined = torch::cat({x_static, last_hidden, x_opp}, 1);
+        return action_head(combined);
+    }
+
+    // stepwise version of forward_with_history: new_actions [n, 1, 3] (n >= 1) are only the actions since
+    // the previous call, state is what that call returned (or initial_state()). gives the same output
+    // as forward_with_history on the whole history, but costs only the new actions.
+    std::tuple<torch::Tensor, State> forward_step(torch::Tensor static_feat, torch::Tensor new_actions, torch::Tensor opp_ctx, State state) {
+        auto x_history = torch::relu(action_embedding(new_actions));
+        auto rnn_output = rnn(x_history, state);
+        State new_state = std::get<1>(rnn_output);
+        auto out = forward_from_hidden(static_feat, std::get<0>(new_state)[-1], opp_ctx);
+        return std::make_tuple(out, new_state);
+    }
+
+    // forward_step for a batch of decisions at once (see inference.h). static_feat is [batch, input],
+    // new_actions is padded to [max_len, batch, 3] with the real lengths (at least 1, int64 on the cpu)
+    // in lengths, opp_ctx is [batch, 10], state is [1, batch, hidden] each.
+    std::tuple<torch::Tensor, State> forward_batch(torch::Tensor static_feat, torch::Tensor new_actions, torch::Tensor lengths, torch::Tensor opp_ctx, State state) {
+        auto x_history = torch::relu(action_embedding(new_actions));
+
+        // packing makes the lstm stop at the real end of every sequence, so h_n is the last output of
+        // each of them, in the original batch order
+        auto packed = torch::nn::utils::rnn::pack_padded_sequence(x_history, lengths, false, false);
+        auto rnn_output = rnn->forward_with_packed_input(packed, state);
+        State new_state = std::get<1>(rnn_output);
+        auto out = forward_from_hidden(static_feat, std::get<0>(new_state).squeeze(0), opp_ctx);
+        return std::make_tuple(out, new_state);
+    }
 };
 
 
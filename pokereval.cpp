@@ -44,6 +44,9 @@ POSSIBILITY OF SUCH DAMAGE.
 #include <string.h>
 #include <string>
 #include <iostream>
+#include <vector>
+
+#include "mappedfile.h"
 
 static std::string HANDRANKSFILE = "handranks.dat";
 
@@ -2093,7 +2096,7 @@ namespace PokerEval
   const char HandRanks[][16] = {"BAD!!","High Card","Pair","Two Pair","Three of a Kind","Straight","Flush","Full House","Four of a Kind","Straight Flush"};
 
   int64_t IDs[612978];
-  int HR[32487834];
+  static const int HR_SIZE = 32487834;
 
   int numIDs = 1;
   int numcards = 0;
@@ -2342,9 +2345,10 @@ namespace PokerEval
    return handrank;  // now a handrank that I like
   }
 
-  void generateTable()
+  //HR must have room for HR_SIZE ints
+  void generateTable(int* HR)
   {
-    printf("\nData table file for fast poker hand evaluation not yet created.\nGenerating now. This may take a while.\nThis will write a 124MB file to disk.\n");
+    printf("\nGenerating data table for fast poker hand evaluation. This may take a while.\n");
 
     int IDslot, card = 0, count = 0;
     int64_t ID;
@@ -2355,7 +2359,9 @@ namespace PokerEval
     // Clear our arrays
     memset(handTypeSum, 0, sizeof(handTypeSum));
     memset(IDs, 0, sizeof(IDs));
-    memset(HR, 0, sizeof(HR));
+    memset(HR, 0, HR_SIZE * sizeof(int));
+    numIDs = 1;
+    maxID = 0;
 
 
     // step through the ID array - always shifting the current ID and adding 52 cards to the end of the array.
@@ -2450,19 +2456,148 @@ namespace PokerEval
    printf("\nTotal Hands = %d\n", count);
   }
 
-  int writeTableToFile()
+  /*
+  The compact format: the rows of the table that are reached after 6 cards only contain hand ranks
+  (the 7th card gives the hand rank, and slot 0 has the rank of the 6 cards), which all fit in 16 bits.
+  Those rows are moved to a separate 16-bit leaf table, the other rows are renumbered and their
+  pointers to the 6-card rows now point into the leaf table. Like in the full table, the root row is
+  at offset 53, and invalid card combinations (the same card twice) point to the root row (or leaf
+  row 0 at the last step), so GetHandValue stays in range.
+  */
+  void compactTable(const int* HR, std::vector<int>& inner, std::vector<unsigned short>& leaves)
   {
-   // output the array now that I have it!!
-   FILE * fout = fopen(HANDRANKSFILE.c_str(), "wb");
-   if (!fout) {
-    printf("Problem creating the Output File!\n");
-    return 1;
-   }
-   fwrite(HR, sizeof(HR), 1, fout);  // big write, but quick
+    static const int ROOT = 53;
+    int numRows = HR_SIZE / 53;
+    std::vector<int> level(numRows, -1); //amount of cards of each row, -1 if not reachable
+    std::vector<int> index(numRows, 0); //new row index in inner (starting at 1, row 0 is unused like in HR) or in leaves
+    std::vector<int> rows; //rows in order of level
+    int numInner = 1, numLeaves = 0;
+
+    level[1] = 0;
+    index[1] = numInner++;
+    rows.push_back(1);
+    for(size_t i = 0; i < rows.size(); i++)
+    {
+      int row = rows[i];
+      if(level[row] == 6) continue;
+      for(int card = 1; card < 53; card++)
+      {
+        int next = HR[row * 53 + card] / 53;
+        if(HR[row * 53 + card] <= ROOT || level[next] >= 0) continue;
+        level[next] = level[row] + 1;
+        index[next] = level[next] == 6 ? numLeaves++ : numInner++;
+        rows.push_back(next);
+      }
+    }
+
+    inner.assign(numInner * 53, 0);
+    leaves.assign(numLeaves * 53, 0);
+    for(size_t i = 0; i < rows.size(); i++)
+    {
+      int row = rows[i];
+      const int* in = &HR[row * 53];
+      if(level[row] == 6)
+      {
+        for(int card = 0; card < 53; card++) leaves[index[row] * 53 + card] = (unsigned short)in[card];
+        continue;
+      }
+
+      int* out = &inner[index[row] * 53];
+      out[0] = in[0];
+      for(int card = 1; card < 53; card++)
+      {
+        int next = in[card] / 53;
+        bool valid = in[card] > ROOT && level[next] == level[row] + 1;
+        if(level[row] == 5) out[card] = valid ? index[next] * 53 : 0;
+        else out[card] = valid ? index[next] * 53 : ROOT;
+      }
+    }
+  }
+
+  /*
+  The handranks file starts with a header, followed by the inner table (ints) and in the compact format the
+  leaf table (unsigned shorts). Files of the old format, which was only the raw full table, can still be used.
+  */
+  struct HandRanksHeader
+  {
+    char magic[4]; //"OOHR"
+    unsigned version;
+    unsigned format; //HandRanksFormat
+    unsigned innerSize; //amount of ints
+    unsigned leafSize; //amount of unsigned shorts, 0 in the full format
+    unsigned checksum; //of everything after the header
+    unsigned padding[2];
+  };
+
+  static const unsigned HANDRANKS_VERSION = 1;
+
+  static MappedFile handRanksFile;
+  static std::vector<int> handRanksBuffer; //only used if the generated table couldn't be written to a file
+  static const int* HRTable = 0; //the full table, or the inner table of the compact format
+  static const unsigned short* HRLeaves = 0; //the leaf table of the compact format, else 0
+
+  //returns true if the mapped data is a valid handranks file, and gives the tables in that case
+  static bool parseHandRanks(const unsigned char* data, size_t size, bool verifyChecksum, const int** table, const unsigned short** leaves)
+  {
+    if(size == HR_SIZE * sizeof(int)) //old format without header
+    {
+      *table = (const int*)data;
+      *leaves = 0;
+      return true;
+    }
+
+    if(size < sizeof(HandRanksHeader)) return false;
+    HandRanksHeader header;
+    memcpy(&header, data, sizeof(header));
+    if(memcmp(header.magic, "OOHR", 4) != 0 || header.version != HANDRANKS_VERSION) return false;
+    if(header.format == HR_FORMAT_FULL && (header.innerSize != (unsigned)HR_SIZE || header.leafSize != 0)) return false;
+    if(header.format != HR_FORMAT_FULL && header.format != HR_FORMAT_COMPACT) return false;
+    size_t dataSize = header.innerSize * sizeof(int) + header.leafSize * sizeof(unsigned short);
+    if(size != sizeof(header) + dataSize) return false;
+    if(verifyChecksum && getDataChecksum(data + sizeof(header), dataSize) != header.checksum) return false;
+
+    *table = (const int*)(data + sizeof(header));
+    *leaves = header.format == HR_FORMAT_COMPACT ? (const unsigned short*)(data + sizeof(header) + header.innerSize * sizeof(int)) : 0;
+    return true;
+  }
 
-   fclose(fout);
+  static bool writeHandRanks(const std::string& filename, HandRanksFormat format, const int* HR)
+  {
+    std::vector<int> inner;
+    std::vector<unsigned short> leaves;
+    if(format == HR_FORMAT_COMPACT) compactTable(HR, inner, leaves);
+    else inner.assign(HR, HR + HR_SIZE);
+
+    HandRanksHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, "OOHR", 4);
+    header.version = HANDRANKS_VERSION;
+    header.format = format;
+    header.innerSize = (unsigned)inner.size();
+    header.leafSize = (unsigned)leaves.size();
+
+    std::vector<unsigned char> file(sizeof(header) + inner.size() * sizeof(int) + leaves.size() * sizeof(unsigned short));
+    memcpy(&file[sizeof(header)], &inner[0], inner.size() * sizeof(int));
+    if(!leaves.empty()) memcpy(&file[sizeof(header) + inner.size() * sizeof(int)], &leaves[0], leaves.size() * sizeof(unsigned short));
+    header.checksum = getDataChecksum(&file[sizeof(header)], file.size() - sizeof(header));
+    memcpy(&file[0], &header, sizeof(header));
+
+    return writeFileAtomic(filename, &file[0], file.size());
+  }
+
+  bool generateHandRanksFile(const std::string& filename, HandRanksFormat format)
+  {
+    std::vector<int> HR(HR_SIZE);
+    generateTable(&HR[0]);
+    return writeHandRanks(filename, format, &HR[0]);
+  }
 
-   return 0;
+  bool checkHandRanksFile(const std::string& filename)
+  {
+    MappedFile file;
+    const int* table;
+    const unsigned short* leaves;
+    return file.open(filename) && parseHandRanks(file.getData(), file.getSize(), true, &table, &leaves);
   }
 
   ///////////////////////////////// end code!!
@@ -3094,34 +3229,36 @@ namespace PokerEval
   }
 
 
-// Initialize the 2+2 evaluator by loading the HANDRANKS.DAT file and
-// mapping it to our 32-million member HR array. Call this once and
-// forget about it.
+// Initialize the 2+2 evaluator by memory-mapping the HANDRANKS.DAT file
+// (read-only, so all processes share the same pages). If the file doesn't
+// exist or is invalid, it's generated and written first. Call this once
+// and forget about it.
 void InitTheEvaluator()
 {
-  bool success = true;
-
-  memset(HR, 0, sizeof(HR));
-  FILE * fin = fopen(HANDRANKSFILE.c_str(), "rb");
+  if(HRTable) return;
 
-  if(fin)
+  //the checksum isn't verified here, that would read the whole file and take away the fast startup
+  if(handRanksFile.open(HANDRANKSFILE) && parseHandRanks(handRanksFile.getData(), handRanksFile.getSize(), false, &HRTable, &HRLeaves))
   {
-    // Load the HANDRANKS.DAT file data into the HR array
-    std::cout << "reading " << HANDRANKSFILE << std::endl;
-    size_t count = fread(HR, sizeof(HR), 1, fin);
-    fclose(fin);
+    std::cout << "mapped " << HANDRANKSFILE << std::endl;
+    return;
+  }
 
-    if(count != 1) success = false;
+  std::cout << HANDRANKSFILE << " has to be created" << std::endl;
+  handRanksFile.close();
+  handRanksBuffer.resize(HR_SIZE);
+  generateTable(&handRanksBuffer[0]);
 
-    if(success) std::cout << HANDRANKSFILE << " read" << std::endl;
-    else std::cout << HANDRANKSFILE << " has to be created" << std::endl;
+  if(writeHandRanks(HANDRANKSFILE, HR_FORMAT_FULL, &handRanksBuffer[0]) && handRanksFile.open(HANDRANKSFILE)
+     && parseHandRanks(handRanksFile.getData(), handRanksFile.getSize(), false, &HRTable, &HRLeaves))
+  {
+    std::vector<int>().swap(handRanksBuffer);
   }
-  else success = false;
-
-  if(!success)
+  else
   {
-    generateTable();
-    writeTableToFile();
+    std::cout << "Problem writing " << HANDRANKSFILE << ", using the table from memory" << std::endl;
+    HRTable = &handRanksBuffer[0];
+    HRLeaves = 0;
   }
 }
 
@@ -3130,13 +3267,14 @@ void InitTheEvaluator()
 // a value between 1 and 52.
 int GetHandValue(const int* pCards)
 {
-    int p = HR[53 + *pCards++];
-    p = HR[p + *pCards++];
-    p = HR[p + *pCards++];
-    p = HR[p + *pCards++];
-    p = HR[p + *pCards++];
-    p = HR[p + *pCards++];
-    return HR[p + *pCards++];
+    int p = HRTable[53 + *pCards++];
+    p = HRTable[p + *pCards++];
+    p = HRTable[p + *pCards++];
+    p = HRTable[p + *pCards++];
+    p = HRTable[p + *pCards++];
+    p = HRTable[p + *pCards++];
+    if(HRLeaves) return HRLeaves[p + *pCards];
+    return HRTable[p + *pCards];
 }
 
 //
@@ -34,7 +34,7 @@ namespace PokerEval
   Output: integer, the higher the better combination. Return value >> 12 gives combination rank (1 for high card to 9 for straight flush), return value & 0xFFF gives rank within that combination.
   */
   int GetHandValue(const int* pCards);
-  void InitTheEvaluator();
+  void InitTheEvaluator(); //memory-maps the handranks.dat file, or generates it first if it doesn't exist yet
 
   //input: integers gotten using init_deck. But init_deck again has its own again different card format at input. See pokermath.h for a more convenient interface around all this.
   short eval_5hand(const int *hand ); //returns 1 for best possible hand, 7462 for worse possible hand
@@ -42,4 +42,19 @@ namespace PokerEval
   short eval_7hand(const int *hand );
 
   void setHandsRanksFilePath(const std::string& path);
+
+  /*
+  The handranks.dat file has a header with version and checksum, followed by the table. The full format is
+  the table of the 2+2 evaluator as is (32487834 ints, 124MB). The compact format stores the last step of the
+  lookup, which only contains hand ranks, in 16 bits, and is 88MB instead of 124MB. GetHandValue works with both.
+  Files of older OOPoker versions, which are the full table without header, can still be used.
+  */
+  enum HandRanksFormat
+  {
+    HR_FORMAT_FULL,
+    HR_FORMAT_COMPACT
+  };
+
+  bool generateHandRanksFile(const std::string& filename, HandRanksFormat format); //writes the file atomically, returns false on error
+  bool checkHandRanksFile(const std::string& filename); //returns true if the file is valid, including its checksum
 }
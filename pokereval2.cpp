@@ -17,6 +17,11 @@ Applied bugfix mentioned in http://poker-ai.org/archive/pokerai.org/pf3/viewtopi
 
 #include <stdlib.h>
 
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define POKEREVAL2_SIMD //AVX2 and AVX-512 versions of RankHandBatch, chosen at runtime depending on the CPU
+#include <immintrin.h>
+#endif
+
 namespace PokerEval2
 {
 
@@ -30,17 +35,41 @@ namespace PokerEval2
 #define QUAD_FLAG     0x800000
 #define STRFLUSH_FLAG 0x900000
 
-unsigned int Flush[8129];
-unsigned int Straight[8129];
-unsigned int Top1_16[8129];
-unsigned int Top1_12[8129];
-unsigned int Top1_8[8129];
-unsigned int Top2_12[8129];
-unsigned int Top2_8[8129];
-unsigned int Top3_4[8129];
-unsigned int Top5[8129];
-unsigned int Bit1[8129];
-unsigned int Bit2[8129];
+/*
+All tables are rows of one array, so that the SIMD versions can look up different tables for
+different hands in a single gather, using table * TABLE_SIZE + index as index.
+*/
+enum
+{
+  T_FLUSH,
+  T_STRAIGHT,
+  T_TOP1_16,
+  T_TOP1_12,
+  T_TOP1_8,
+  T_TOP2_12,
+  T_TOP2_8,
+  T_TOP3_4,
+  T_TOP5,
+  T_BIT1,
+  T_BIT2,
+  NUM_TABLES
+};
+
+static const int TABLE_SIZE = 8192;
+
+alignas(64) static unsigned int RankTables[NUM_TABLES][TABLE_SIZE];
+
+unsigned int (&Flush)[TABLE_SIZE] = RankTables[T_FLUSH];
+unsigned int (&Straight)[TABLE_SIZE] = RankTables[T_STRAIGHT];
+unsigned int (&Top1_16)[TABLE_SIZE] = RankTables[T_TOP1_16];
+unsigned int (&Top1_12)[TABLE_SIZE] = RankTables[T_TOP1_12];
+unsigned int (&Top1_8)[TABLE_SIZE] = RankTables[T_TOP1_8];
+unsigned int (&Top2_12)[TABLE_SIZE] = RankTables[T_TOP2_12];
+unsigned int (&Top2_8)[TABLE_SIZE] = RankTables[T_TOP2_8];
+unsigned int (&Top3_4)[TABLE_SIZE] = RankTables[T_TOP3_4];
+unsigned int (&Top5)[TABLE_SIZE] = RankTables[T_TOP5];
+unsigned int (&Bit1)[TABLE_SIZE] = RankTables[T_BIT1];
+unsigned int (&Bit2)[TABLE_SIZE] = RankTables[T_BIT2];
 
 HandMask HandMasksTable[52] = 
 {
@@ -257,5 +286,281 @@ void InitializeHandRankingTables(void)
   }
 }
 
+////////////////////////////////////////////////////////////////////////////////
+
+/*
+Batch versions of RankHand. The SIMD versions compute the same as RankHand, but for 8 (AVX2) or
+16 (AVX-512) hands at once and without branches per hand:
+-the four 13-bit suit fields are extracted from the masks of all hands
+-a suit with 5 or more cards (found with a popcount) gives the index in the Flush table
+-p1..p4 (ranks present at least 1..4 times) are computed as in RankHand
+-the category (high card, pair, two pair, trips, full house, quads) follows from which of p2..p4
+ are non-zero, and selects per hand which two tables are looked up, so that all categories
+ need only two gathers. Two pair and full house first need one more gather in Bit1/Bit2.
+-the Flush, Straight and Bit gathers are skipped when no hand in the batch needs them
+*/
+
+static void RankHandBatchScalar(const HandMask* hands, HandVal* out, size_t n)
+{
+  for(size_t i = 0; i < n; i++) out[i] = RankHand(hands[i]);
+}
+
+#ifdef POKEREVAL2_SIMD
+
+__attribute__((target("avx2")))
+static inline __m256i popcount13AVX2(__m256i v)
+{
+  const __m256i lut = _mm256_setr_epi8(0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4,
+                                       0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4);
+  const __m256i nibble = _mm256_set1_epi8(0x0f);
+  __m256i bytes = _mm256_add_epi8(_mm256_shuffle_epi8(lut, _mm256_and_si256(v, nibble)),
+                                  _mm256_shuffle_epi8(lut, _mm256_and_si256(_mm256_srli_epi16(v, 4), nibble)));
+  //sum the bytes of each 32-bit lane
+  return _mm256_madd_epi16(_mm256_maddubs_epi16(bytes, _mm256_set1_epi8(1)), _mm256_set1_epi16(1));
+}
+
+__attribute__((target("avx2")))
+static void RankHandBatchAVX2(const HandMask* hands, HandVal* out, size_t n)
+{
+  const int* base = (const int*)&RankTables[0][0];
+  const __m256i zero = _mm256_setzero_si256();
+  const __m256i ones = _mm256_set1_epi32(-1);
+  const __m256i m13 = _mm256_set1_epi32(0x1fff);
+  const __m256i four = _mm256_set1_epi32(4);
+  const __m256i wheel = _mm256_set1_epi32(0x100f);
+  const __m256i evenOdd = _mm256_setr_epi32(0, 2, 4, 6, 1, 3, 5, 7);
+
+  size_t i = 0;
+  for(; i + 8 <= n; i += 8)
+  {
+    //split the 64-bit masks in their low and high 32 bits
+    __m256i a = _mm256_permutevar8x32_epi32(_mm256_loadu_si256((const __m256i*)(hands + i)), evenOdd);
+    __m256i b = _mm256_permutevar8x32_epi32(_mm256_loadu_si256((const __m256i*)(hands + i + 4)), evenOdd);
+    __m256i lo = _mm256_permute2x128_si256(a, b, 0x20);
+    __m256i hi = _mm256_permute2x128_si256(a, b, 0x31);
+
+    __m256i s = _mm256_and_si256(lo, m13);
+    __m256i h = _mm256_and_si256(_mm256_srli_epi32(lo, 16), m13);
+    __m256i d = _mm256_and_si256(hi, m13);
+    __m256i c = _mm256_and_si256(_mm256_srli_epi32(hi, 16), m13);
+
+    //flush: at most one suit can have 5 or more of the 7 cards
+    __m256i f = _mm256_and_si256(s, _mm256_cmpgt_epi32(popcount13AVX2(s), four));
+    f = _mm256_or_si256(f, _mm256_and_si256(h, _mm256_cmpgt_epi32(popcount13AVX2(h), four)));
+    f = _mm256_or_si256(f, _mm256_and_si256(d, _mm256_cmpgt_epi32(popcount13AVX2(d), four)));
+    f = _mm256_or_si256(f, _mm256_and_si256(c, _mm256_cmpgt_epi32(popcount13AVX2(c), four)));
+    __m256i flush = zero;
+    if(!_mm256_testz_si256(f, f)) flush = _mm256_i32gather_epi32(base, f, 4); //T_FLUSH is table 0
+
+    __m256i p1 = s;
+    __m256i p2 = _mm256_and_si256(p1, h); p1 = _mm256_or_si256(p1, h);
+    __m256i p3 = _mm256_and_si256(p2, d); p2 = _mm256_or_si256(p2, _mm256_and_si256(p1, d)); p1 = _mm256_or_si256(p1, d);
+    __m256i p4 = _mm256_and_si256(p3, c); p3 = _mm256_or_si256(p3, _mm256_and_si256(p2, c)); p2 = _mm256_or_si256(p2, _mm256_and_si256(p1, c)); p1 = _mm256_or_si256(p1, c);
+
+    //straight: 5 consecutive ranks, or the wheel
+    __m256i st = _mm256_and_si256(_mm256_and_si256(p1, _mm256_srli_epi32(p1, 1)), _mm256_and_si256(_mm256_srli_epi32(p1, 2), _mm256_srli_epi32(p1, 3)));
+    st = _mm256_and_si256(st, _mm256_srli_epi32(p1, 4));
+    st = _mm256_or_si256(st, _mm256_cmpeq_epi32(_mm256_and_si256(p1, wheel), wheel));
+    __m256i straight = zero;
+    if(!_mm256_testz_si256(st, st)) straight = _mm256_i32gather_epi32(base + T_STRAIGHT * TABLE_SIZE, p1, 4);
+
+    __m256i noP2 = _mm256_cmpeq_epi32(p2, zero);
+    __m256i noP3 = _mm256_cmpeq_epi32(p3, zero);
+    __m256i noP4 = _mm256_cmpeq_epi32(p4, zero);
+    __m256i p2Single = _mm256_cmpeq_epi32(_mm256_and_si256(p2, _mm256_add_epi32(p2, ones)), zero);
+    __m256i p3Single = _mm256_cmpeq_epi32(_mm256_and_si256(p3, _mm256_add_epi32(p3, ones)), zero);
+
+    __m256i withP3 = _mm256_andnot_si256(noP3, noP4); //trips or full house
+    __m256i house = _mm256_and_si256(withP3, _mm256_or_si256(_mm256_cmpgt_epi32(p2, p3), _mm256_xor_si256(p3Single, ones)));
+    __m256i trips = _mm256_andnot_si256(house, withP3);
+    __m256i withP2 = _mm256_andnot_si256(noP2, noP3); //one or more pairs, no trips
+    __m256i pair = _mm256_and_si256(withP2, p2Single);
+    __m256i twoPair = _mm256_andnot_si256(p2Single, withP2);
+    __m256i quads = _mm256_xor_si256(noP4, ones);
+
+    //highest two pairs, or highest trips
+    __m256i bitsNeeded = _mm256_or_si256(twoPair, house);
+    __m256i bits = zero;
+    if(!_mm256_testz_si256(bitsNeeded, bitsNeeded))
+    {
+      __m256i index = _mm256_blendv_epi8(_mm256_add_epi32(p3, _mm256_set1_epi32(T_BIT1 * TABLE_SIZE)), _mm256_add_epi32(p2, _mm256_set1_epi32(T_BIT2 * TABLE_SIZE)), twoPair);
+      bits = _mm256_and_si256(_mm256_i32gather_epi32(base, index, 4), bitsNeeded);
+    }
+
+    //high card by default, then overwritten per category
+    __m256i flag = _mm256_set1_epi32(HIGH_FLAG);
+    __m256i index1 = _mm256_add_epi32(p1, _mm256_set1_epi32(T_TOP5 * TABLE_SIZE));
+    __m256i index2 = _mm256_set1_epi32(T_TOP1_16 * TABLE_SIZE); //Top1_16[0] is 0
+
+    flag = _mm256_blendv_epi8(flag, _mm256_set1_epi32(PAIR_FLAG), pair);
+    index1 = _mm256_blendv_epi8(index1, _mm256_add_epi32(p2, _mm256_set1_epi32(T_TOP1_16 * TABLE_SIZE)), pair);
+    index2 = _mm256_blendv_epi8(index2, _mm256_add_epi32(_mm256_xor_si256(p1, p2), _mm256_set1_epi32(T_TOP3_4 * TABLE_SIZE)), pair);
+
+    flag = _mm256_blendv_epi8(flag, _mm256_set1_epi32(TWOPAIR_FLAG), twoPair);
+    index1 = _mm256_blendv_epi8(index1, _mm256_add_epi32(p2, _mm256_set1_epi32(T_TOP2_12 * TABLE_SIZE)), twoPair);
+    index2 = _mm256_blendv_epi8(index2, _mm256_add_epi32(_mm256_xor_si256(p1, bits), _mm256_set1_epi32(T_TOP1_8 * TABLE_SIZE)), twoPair);
+
+    flag = _mm256_blendv_epi8(flag, _mm256_set1_epi32(TRIP_FLAG), trips);
+    index1 = _mm256_blendv_epi8(index1, _mm256_add_epi32(p3, _mm256_set1_epi32(T_TOP1_16 * TABLE_SIZE)), trips);
+    index2 = _mm256_blendv_epi8(index2, _mm256_add_epi32(_mm256_xor_si256(p1, p3), _mm256_set1_epi32(T_TOP2_8 * TABLE_SIZE)), trips);
+
+    flag = _mm256_blendv_epi8(flag, _mm256_set1_epi32(HOUSE_FLAG), house);
+    index1 = _mm256_blendv_epi8(index1, _mm256_add_epi32(p3, _mm256_set1_epi32(T_TOP1_16 * TABLE_SIZE)), house);
+    index2 = _mm256_blendv_epi8(index2, _mm256_add_epi32(_mm256_xor_si256(p2, bits), _mm256_set1_epi32(T_TOP1_12 * TABLE_SIZE)), house);
+
+    flag = _mm256_blendv_epi8(flag, _mm256_set1_epi32(QUAD_FLAG), quads);
+    index1 = _mm256_blendv_epi8(index1, _mm256_add_epi32(p4, _mm256_set1_epi32(T_TOP1_16 * TABLE_SIZE)), quads);
+    index2 = _mm256_blendv_epi8(index2, _mm256_add_epi32(_mm256_xor_si256(p1, p4), _mm256_set1_epi32(T_TOP1_12 * TABLE_SIZE)), quads);
+
+    __m256i result = _mm256_or_si256(flag, _mm256_or_si256(_mm256_i32gather_epi32(base, index1, 4), _mm256_i32gather_epi32(base, index2, 4)));
+    result = _mm256_blendv_epi8(straight, result, _mm256_cmpeq_epi32(straight, zero));
+    result = _mm256_blendv_epi8(flush, result, _mm256_cmpeq_epi32(flush, zero));
+
+    _mm256_storeu_si256((__m256i*)(out + i), result);
+  }
+
+  RankHandBatchScalar(hands + i, out + i, n - i);
+}
+
+//GCC warns about the deliberately undefined values inside its own AVX-512 intrinsics
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+
+__attribute__((target("avx512f,avx512bw")))
+static inline __m512i popcount13AVX512(__m512i v)
+{
+  const __m512i lut = _mm512_broadcast_i32x4(_mm_setr_epi8(0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4));
+  const __m512i nibble = _mm512_set1_epi8(0x0f);
+  __m512i bytes = _mm512_add_epi8(_mm512_shuffle_epi8(lut, _mm512_and_si512(v, nibble)),
+                                  _mm512_shuffle_epi8(lut, _mm512_and_si512(_mm512_srli_epi16(v, 4), nibble)));
+  return _mm512_madd_epi16(_mm512_maddubs_epi16(bytes, _mm512_set1_epi8(1)), _mm512_set1_epi16(1));
+}
+
+__attribute__((target("avx512f,avx512bw")))
+static void RankHandBatchAVX512(const HandMask* hands, HandVal* out, size_t n)
+{
+  const int* base = (const int*)&RankTables[0][0];
+  const __m512i zero = _mm512_setzero_si512();
+  const __m512i m13 = _mm512_set1_epi32(0x1fff);
+  const __m512i four = _mm512_set1_epi32(4);
+  const __m512i wheel = _mm512_set1_epi32(0x100f);
+  const __m512i even = _mm512_setr_epi32(0, 2, 4, 6, 8, 10, 12, 14, 16, 18, 20, 22, 24, 26, 28, 30);
+  const __m512i odd = _mm512_setr_epi32(1, 3, 5, 7, 9, 11, 13, 15, 17, 19, 21, 23, 25, 27, 29, 31);
+
+  size_t i = 0;
+  for(; i + 16 <= n; i += 16)
+  {
+    __m512i a = _mm512_loadu_si512((const void*)(hands + i));
+    __m512i b = _mm512_loadu_si512((const void*)(hands + i + 8));
+    __m512i lo = _mm512_permutex2var_epi32(a, even, b);
+    __m512i hi = _mm512_permutex2var_epi32(a, odd, b);
+
+    __m512i s = _mm512_and_si512(lo, m13);
+    __m512i h = _mm512_and_si512(_mm512_srli_epi32(lo, 16), m13);
+    __m512i d = _mm512_and_si512(hi, m13);
+    __m512i c = _mm512_and_si512(_mm512_srli_epi32(hi, 16), m13);
+
+    __m512i f = _mm512_maskz_mov_epi32(_mm512_cmpgt_epi32_mask(popcount13AVX512(s), four), s);
+    f = _mm512_mask_mov_epi32(f, _mm512_cmpgt_epi32_mask(popcount13AVX512(h), four), h);
+    f = _mm512_mask_mov_epi32(f, _mm512_cmpgt_epi32_mask(popcount13AVX512(d), four), d);
+    f = _mm512_mask_mov_epi32(f, _mm512_cmpgt_epi32_mask(popcount13AVX512(c), four), c);
+    __mmask16 isFlush = _mm512_test_epi32_mask(f, f);
+    __m512i flush = zero;
+    if(isFlush) flush = _mm512_mask_i32gather_epi32(zero, isFlush, f, base, 4);
+
+    __m512i p1 = s;
+    __m512i p2 = _mm512_and_si512(p1, h); p1 = _mm512_or_si512(p1, h);
+    __m512i p3 = _mm512_and_si512(p2, d); p2 = _mm512_or_si512(p2, _mm512_and_si512(p1, d)); p1 = _mm512_or_si512(p1, d);
+    __m512i p4 = _mm512_and_si512(p3, c); p3 = _mm512_or_si512(p3, _mm512_and_si512(p2, c)); p2 = _mm512_or_si512(p2, _mm512_and_si512(p1, c)); p1 = _mm512_or_si512(p1, c);
+
+    __m512i st = _mm512_and_si512(_mm512_and_si512(p1, _mm512_srli_epi32(p1, 1)), _mm512_and_si512(_mm512_srli_epi32(p1, 2), _mm512_srli_epi32(p1, 3)));
+    st = _mm512_and_si512(st, _mm512_srli_epi32(p1, 4));
+    __mmask16 isStraight = _mm512_test_epi32_mask(st, st) | _mm512_cmpeq_epi32_mask(_mm512_and_si512(p1, wheel), wheel);
+    __m512i straight = zero;
+    if(isStraight) straight = _mm512_mask_i32gather_epi32(zero, isStraight, p1, base + T_STRAIGHT * TABLE_SIZE, 4);
+
+    __mmask16 withP2 = _mm512_test_epi32_mask(p2, p2);
+    __mmask16 withP3 = _mm512_test_epi32_mask(p3, p3);
+    __mmask16 quads = _mm512_test_epi32_mask(p4, p4);
+    __mmask16 p2Multi = _mm512_test_epi32_mask(p2, _mm512_sub_epi32(p2, _mm512_set1_epi32(1)));
+    __mmask16 p3Multi = _mm512_test_epi32_mask(p3, _mm512_sub_epi32(p3, _mm512_set1_epi32(1)));
+
+    withP3 &= ~quads;
+    __mmask16 house = withP3 & (_mm512_cmpgt_epi32_mask(p2, p3) | p3Multi);
+    __mmask16 trips = withP3 & ~house;
+    withP2 &= ~(withP3 | quads);
+    __mmask16 pair = withP2 & ~p2Multi;
+    __mmask16 twoPair = withP2 & p2Multi;
+
+    __m512i bits = zero;
+    if(twoPair | house)
+    {
+      __m512i index = _mm512_mask_blend_epi32(twoPair, _mm512_add_epi32(p3, _mm512_set1_epi32(T_BIT1 * TABLE_SIZE)), _mm512_add_epi32(p2, _mm512_set1_epi32(T_BIT2 * TABLE_SIZE)));
+      bits = _mm512_mask_i32gather_epi32(zero, twoPair | house, index, base, 4);
+    }
+
+    __m512i flag = _mm512_set1_epi32(HIGH_FLAG);
+    __m512i index1 = _mm512_add_epi32(p1, _mm512_set1_epi32(T_TOP5 * TABLE_SIZE));
+    __m512i index2 = _mm512_set1_epi32(T_TOP1_16 * TABLE_SIZE);
+
+    flag = _mm512_mask_mov_epi32(flag, pair, _mm512_set1_epi32(PAIR_FLAG));
+    index1 = _mm512_mask_mov_epi32(index1, pair, _mm512_add_epi32(p2, _mm512_set1_epi32(T_TOP1_16 * TABLE_SIZE)));
+    index2 = _mm512_mask_mov_epi32(index2, pair, _mm512_add_epi32(_mm512_xor_si512(p1, p2), _mm512_set1_epi32(T_TOP3_4 * TABLE_SIZE)));
+
+    flag = _mm512_mask_mov_epi32(flag, twoPair, _mm512_set1_epi32(TWOPAIR_FLAG));
+    index1 = _mm512_mask_mov_epi32(index1, twoPair, _mm512_add_epi32(p2, _mm512_set1_epi32(T_TOP2_12 * TABLE_SIZE)));
+    index2 = _mm512_mask_mov_epi32(index2, twoPair, _mm512_add_epi32(_mm512_xor_si512(p1, bits), _mm512_set1_epi32(T_TOP1_8 * TABLE_SIZE)));
+
+    flag = _mm512_mask_mov_epi32(flag, trips, _mm512_set1_epi32(TRIP_FLAG));
+    index1 = _mm512_mask_mov_epi32(index1, trips, _mm512_add_epi32(p3, _mm512_set1_epi32(T_TOP1_16 * TABLE_SIZE)));
+    index2 = _mm512_mask_mov_epi32(index2, trips, _mm512_add_epi32(_mm512_xor_si512(p1, p3), _mm512_set1_epi32(T_TOP2_8 * TABLE_SIZE)));
+
+    flag = _mm512_mask_mov_epi32(flag, house, _mm512_set1_epi32(HOUSE_FLAG));
+    index1 = _mm512_mask_mov_epi32(index1, house, _mm512_add_epi32(p3, _mm512_set1_epi32(T_TOP1_16 * TABLE_SIZE)));
+    index2 = _mm512_mask_mov_epi32(index2, house, _mm512_add_epi32(_mm512_xor_si512(p2, bits), _mm512_set1_epi32(T_TOP1_12 * TABLE_SIZE)));
+
+    flag = _mm512_mask_mov_epi32(flag, quads, _mm512_set1_epi32(QUAD_FLAG));
+    index1 = _mm512_mask_mov_epi32(index1, quads, _mm512_add_epi32(p4, _mm512_set1_epi32(T_TOP1_16 * TABLE_SIZE)));
+    index2 = _mm512_mask_mov_epi32(index2, quads, _mm512_add_epi32(_mm512_xor_si512(p1, p4), _mm512_set1_epi32(T_TOP1_12 * TABLE_SIZE)));
+
+    __m512i result = _mm512_or_si512(flag, _mm512_or_si512(_mm512_i32gather_epi32(index1, base, 4), _mm512_i32gather_epi32(index2, base, 4)));
+    result = _mm512_mask_mov_epi32(result, _mm512_test_epi32_mask(straight, straight), straight);
+    result = _mm512_mask_mov_epi32(result, _mm512_test_epi32_mask(flush, flush), flush);
+
+    _mm512_storeu_si512((void*)(out + i), result);
+  }
+
+  RankHandBatchAVX2(hands + i, out + i, n - i);
+}
+
+#pragma GCC diagnostic pop
+
+#endif //POKEREVAL2_SIMD
+
+typedef void (*RankHandBatchFunction)(const HandMask*, HandVal*, size_t);
+
+static RankHandBatchFunction ChooseRankHandBatch(const char** name)
+{
+#ifdef POKEREVAL2_SIMD
+  __builtin_cpu_init();
+  if(__builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512bw")) { *name = "avx512"; return RankHandBatchAVX512; }
+  if(__builtin_cpu_supports("avx2")) { *name = "avx2"; return RankHandBatchAVX2; }
+#endif
+  *name = "scalar";
+  return RankHandBatchScalar;
+}
+
+static const char* RankHandBatchName = "";
+static const RankHandBatchFunction RankHandBatchChosen = ChooseRankHandBatch(&RankHandBatchName);
+
+void RankHandBatch(const HandMask* hands, HandVal* out, size_t n)
+{
+  RankHandBatchChosen(hands, out, n);
+}
+
+const char* GetRankHandBatchKernel()
+{
+  return RankHandBatchName;
+}
 
 }
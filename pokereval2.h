@@ -5,6 +5,7 @@ Cleaned up a bit, made work with g++ compiler, and placed two .c files in one .c
 */
 
 
+#include <stddef.h>
 #include <stdint.h>
 
 namespace PokerEval2
@@ -19,4 +20,11 @@ typedef unsigned int HandVal;
 void InitializeHandRankingTables(void);
 extern HandVal RankHand(HandMask hand);
 
+/*
+Ranks n hands at once, out[i] = RankHand(hands[i]). Uses AVX-512 or AVX2 if the CPU supports it
+(checked at runtime), otherwise a plain loop. The hands must have exactly 7 cards.
+*/
+void RankHandBatch(const HandMask* hands, HandVal* out, size_t n);
+const char* GetRankHandBatchKernel(); //"avx512", "avx2" or "scalar", the version used by RankHandBatch
+
 }
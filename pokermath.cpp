@@ -26,6 +26,9 @@ along with OOPoker.  If not, see <http://www.gnu.org/licenses/>.
 #include "pokereval.h"
 #include "pokereval2.h"
 #include "random.h"
+#include "threadpool.h"
+
+#include <algorithm>
 
 
 double factorial(int i)
@@ -250,140 +253,152 @@ void getHighestNearFlush(std::vector<Card>& result, const std::vector<Card>& car
 ////////////////////////////////////////////////////////////////////////////////
 
 
+/*
+The exhaustive heads-up functions below don't call eval7 for every combination. Instead they work with
+the bit masks of PokerEval2 directly, and avoid evaluating the same 7 cards more than once:
+-Your hand only depends on the board, so it's evaluated once per possible board, not once per opponent hand.
+-The 7 cards of the opponent are the known board plus the unknown cards (the rest of the board and his
+ hand), and which of the unknown cards are board and which are hand doesn't matter for his 7 cards. So
+ every set of unknown cards is evaluated once, and then compared against your value for each way to
+ split it into board cards and opponent hand. At the flop that's 178365 evaluations instead of 2140380
+ (both 7-card hands for each of the 1081 boards times 990 opponent hands), plus 1081 for your hand.
+-The sets are enumerated with nested loops that each OR one more card to the mask of the loop above,
+ so the innermost loop only has to do a single OR and RankHand. At the flop, the sets of the two
+ innermost loops are collected and evaluated together with the SIMD batch evaluator (RankHandBatch).
+*/
+static void initEvalTables()
+{
+  static const bool inited = (PokerEval2::InitializeHandRankingTables(), true); //thread safe initialization
+  (void)inited;
+}
+
+//fills masks with the masks of all cards that are not in used, returns the amount
+static int getRemainingMasks(PokerEval2::HandMask* masks, PokerEval2::HandMask used)
+{
+  int n = 0;
+  for(int i = 0; i < 52; i++)
+  {
+    if(!(used & PokerEval2::HandMasksTable[i])) masks[n++] = PokerEval2::HandMasksTable[i];
+  }
+  return n;
+}
+
 void getWinChanceAgainst1AtFlop(double& win, double& tie, double& lose
                               , const Card& hand1, const Card& hand2
                               , const Card& table1, const Card& table2, const Card& table3)
 {
-  win = tie = lose = 0.0;
-
-  //an array of 9 values, set up to contain your hand, the 5 table cards, and then the randomly generated players hand
-  int c[9];
+  initEvalTables();
 
-  c[0] = eval7_index(hand1);
-  c[1] = eval7_index(hand2);
-  c[2] = eval7_index(table1);
-  c[3] = eval7_index(table2);
-  c[4] = eval7_index(table3);
+  PokerEval2::HandMask hand = PokerEval2::HandMasksTable[eval7_index(hand1)] | PokerEval2::HandMasksTable[eval7_index(hand2)];
+  PokerEval2::HandMask board = PokerEval2::HandMasksTable[eval7_index(table1)] | PokerEval2::HandMasksTable[eval7_index(table2)]
+                             | PokerEval2::HandMasksTable[eval7_index(table3)];
 
   static const int NUMOTHER = 47;
 
-  int others[NUMOTHER];
+  PokerEval2::HandMask others[NUMOTHER];
+  getRemainingMasks(others, hand | board);
 
-  int j = 0;
-  for(int i = 0; i < 52; i++)
+  //your value for each possible turn and river
+  static const int NUMOTHER2 = NUMOTHER * NUMOTHER;
+  PokerEval2::HandVal yours[NUMOTHER2];
+  for(int i = 0; i < NUMOTHER - 1; i++)
   {
-    int v = eval7_index(Card(i));
-    if(v == c[0] || v == c[1]) continue;
-    if(v == c[2] || v == c[3] || v == c[4]) continue;
-    if(j >= NUMOTHER) break;
-
-    others[j] = v;
-    j++;
+    PokerEval2::HandMask h = hand | board | others[i];
+    for(int j = i + 1; j < NUMOTHER; j++) yours[i * NUMOTHER + j] = PokerEval2::RankHand(h | others[j]);
   }
 
-  int wins = 0;
-  int ties = 0;
-  int losses = 0;
-
-  int count = 0;
+  //every set of 4 unknown cards, split in 6 ways in 2 board cards and 2 opponent cards
+  long long wins = 0;
+  long long ties = 0;
+  long long count = 0;
+  PokerEval2::HandMask masks[NUMOTHER2];
+  PokerEval2::HandVal otherVals[NUMOTHER2];
 
-  //all possible 2-hand combinations of the other player + cards on the table
-  for(int i = 0; i < NUMOTHER - 1; i++) //table
-  for(int j = i + 1; j < NUMOTHER; j++) //table
-  for(int k = 0; k < NUMOTHER - 1; k++) //opponent hand
+  for(int a = 0; a < NUMOTHER - 3; a++)
   {
-    if(k == i || k == j) continue;
-    for(int l = k + 1; l < NUMOTHER; l++) //opponent hand
+    PokerEval2::HandMask boardA = board | others[a];
+    for(int b = a + 1; b < NUMOTHER - 2; b++)
     {
-      if(l == i || l == j) continue;
-      c[5] = others[i];
-      c[6] = others[j];
-      c[7] = others[k];
-      c[8] = others[l];
+      PokerEval2::HandMask boardB = boardA | others[b];
+      PokerEval2::HandVal ab = yours[a * NUMOTHER + b];
 
-      int yourVal = eval7(&c[0]);
-      int otherVal = eval7(&c[2]);
+      //the values of the two inner loops are first all computed at once with the batch evaluator
+      int n = 0;
+      for(int c = b + 1; c < NUMOTHER - 1; c++)
+      {
+        PokerEval2::HandMask boardC = boardB | others[c];
+        for(int d = c + 1; d < NUMOTHER; d++) masks[n++] = boardC | others[d];
+      }
+      PokerEval2::RankHandBatch(masks, otherVals, n);
 
-      if(otherVal == yourVal) ties++;
-      else if(otherVal < yourVal) wins++;
-      else losses++;
+      int i = 0;
+      for(int c = b + 1; c < NUMOTHER - 1; c++)
+      {
+        PokerEval2::HandVal ac = yours[a * NUMOTHER + c];
+        PokerEval2::HandVal bc = yours[b * NUMOTHER + c];
+        for(int d = c + 1; d < NUMOTHER; d++)
+        {
+          PokerEval2::HandVal otherVal = otherVals[i++];
+          PokerEval2::HandVal ad = yours[a * NUMOTHER + d];
+          PokerEval2::HandVal bd = yours[b * NUMOTHER + d];
+          PokerEval2::HandVal cd = yours[c * NUMOTHER + d];
 
-      count++;
+          wins += (ab > otherVal) + (ac > otherVal) + (ad > otherVal) + (bc > otherVal) + (bd > otherVal) + (cd > otherVal);
+          ties += (ab == otherVal) + (ac == otherVal) + (ad == otherVal) + (bc == otherVal) + (bd == otherVal) + (cd == otherVal);
+        }
+        count += 6 * (NUMOTHER - 1 - c);
+      }
     }
   }
 
   win = (double)wins / count;
   tie = (double)ties / count;
-  lose = (double)losses / count;
+  lose = (double)(count - wins - ties) / count;
 }
 
 void getWinChanceAgainst1AtTurn(double& win, double& tie, double& lose
                               , const Card& hand1, const Card& hand2
                               , const Card& table1, const Card& table2, const Card& table3, const Card& table4)
 {
-  win = tie = lose = 0.0;
-
-  //an array of 9 values, set up to contain your hand, the 5 table cards, and then the randomly generated players hand
-  int c[9];
+  initEvalTables();
 
-  c[0] = eval7_index(hand1);
-  c[1] = eval7_index(hand2);
-  c[2] = eval7_index(table1);
-  c[3] = eval7_index(table2);
-  c[4] = eval7_index(table3);
-  c[5] = eval7_index(table4);
+  PokerEval2::HandMask hand = PokerEval2::HandMasksTable[eval7_index(hand1)] | PokerEval2::HandMasksTable[eval7_index(hand2)];
+  PokerEval2::HandMask board = PokerEval2::HandMasksTable[eval7_index(table1)] | PokerEval2::HandMasksTable[eval7_index(table2)]
+                             | PokerEval2::HandMasksTable[eval7_index(table3)] | PokerEval2::HandMasksTable[eval7_index(table4)];
 
   static const int NUMOTHER = 46;
 
-  int others[NUMOTHER];
-
-  int j = 0;
-  for(int i = 0; i < 52; i++)
-  {
-    int v = eval7_index(Card(i));
-    if(v == c[0] || v == c[1]) continue;
-    if(v == c[2] || v == c[3] || v == c[4] || v == c[5]) continue;
-    if(j >= NUMOTHER) break;
-
-    others[j] = v;
-    j++;
-  }
-
+  PokerEval2::HandMask others[NUMOTHER];
+  getRemainingMasks(others, hand | board);
 
+  //your value for each possible river
+  PokerEval2::HandVal yours[NUMOTHER];
+  for(int i = 0; i < NUMOTHER; i++) yours[i] = PokerEval2::RankHand(hand | board | others[i]);
 
-  int wins = 0;
-  int ties = 0;
-  int losses = 0;
-
-  int count = 0;
+  //every set of 3 unknown cards, split in 3 ways in 1 board card and 2 opponent cards
+  long long wins = 0;
+  long long ties = 0;
+  long long count = 0;
 
-  //all possible 2-hand combinations of the other player + cards on the table
-  for(int i = 0; i < NUMOTHER; i++) //table
-  for(int j = 0; j < NUMOTHER - 1; j++) //opponent hand
+  for(int a = 0; a < NUMOTHER - 2; a++)
   {
-    if(j == i) continue;
-    for(int k = j + 1; k < NUMOTHER; k++) //opponent hand
+    PokerEval2::HandMask boardA = board | others[a];
+    for(int b = a + 1; b < NUMOTHER - 1; b++)
     {
-      if(k == i) continue;
-
-      c[6] = others[i];
-      c[7] = others[j];
-      c[8] = others[k];
-
-      int yourVal = eval7(&c[0]);
-      int otherVal = eval7(&c[2]);
-
-      if(otherVal == yourVal) ties++;
-      else if(otherVal < yourVal) wins++;
-      else losses++;
-
-      count++;
+      PokerEval2::HandMask boardB = boardA | others[b];
+      for(int c = b + 1; c < NUMOTHER; c++)
+      {
+        PokerEval2::HandVal otherVal = PokerEval2::RankHand(boardB | others[c]);
+        wins += (yours[a] > otherVal) + (yours[b] > otherVal) + (yours[c] > otherVal);
+        ties += (yours[a] == otherVal) + (yours[b] == otherVal) + (yours[c] == otherVal);
+      }
+      count += 3 * (NUMOTHER - 1 - b);
     }
   }
 
   win = (double)wins / count;
   tie = (double)ties / count;
-  lose = (double)losses / count;
+  lose = (double)(count - wins - ties) / count;
 }
 
 void getWinChanceAgainst1AtRiver(double& win, double& tie, double& lose
@@ -458,297 +473,140 @@ void getWinChanceAgainst1AtRiver(double& win, double& tie, double& lose
 ////////////////////////////////////////////////////////////////////////////////
 
 /*
-This function is there for efficiently choosing "amount" unique random cards
-out of a list of "size" cards. For that, this function shuffles the first "amount"
-cards of the list.
-The intention is that this function is:
--Fast (it's for monte carlo simulations of many hands)
--Properly Random (no errors that skew the randomness)
-So the function is made O(amount), instead of shuffling
-the whole deck all the time which would result in an O(size) function.
-When the function is done, use the first "amount" cards from "values" to
-have your really new randomly shuffled cards.
+The getWinChanceAgainstN functions share one Monte Carlo kernel. It's a template on the amount of known
+board cards and on the amount of opponents, and each combination is instantiated separately:
+-The amount of cards to draw per sample is a constant, so the partial shuffle has a fixed trip count.
+-The loop over the opponents has a fixed trip count, so the compiler can unroll it. It only keeps the
+ best opponent value, win, tie and lose are counted from a single comparison at the end without
+ branches. It still stops at the first opponent that beats you: with many opponents most samples
+ are lost early, and evaluating the remaining opponents anyway was measured to be slower.
+-It works with the bit masks of PokerEval2 directly, the known part of the board is ORed together once
+ per call, and the drawn board cards once per sample instead of once per opponent.
+-At the river nothing of the board is drawn, so your value is the same every sample and is evaluated
+ only once, before the loop.
+NUMOPP 0 is the generic version for more opponents than MAXKERNELOPPONENTS, with a runtime count.
 */
-static void shuffleN(int* values, int size, int amount)
-{
-  for(int i = 0; i < amount; i++)
-  {
-    int r = getRandomFast(0, size - 1);
-    std::swap(values[i], values[r]);
-  }
-}
+static const int MAXKERNELOPPONENTS = 9;
 
-void getWinChanceAgainstNAtPreFlop(double& win, double& tie, double& lose
-                                 , const Card& hand1, const Card& hand2
-                                 , int numOpponents, int numSamples)
+template<int KNOWN, int NUMOPP>
+static void winChanceKernel(int& wins, int& ties, int& losses
+                          , PokerEval2::HandMask hand, PokerEval2::HandMask board
+                          , PokerEval2::HandMask* others, int numOther
+                          , int runtimeOpponents, int numSamples, RandomStream& stream)
 {
-  win = tie = lose = 0.0;
-
-  //an array of 9 values, set up to contain your hand, the 5 table cards, and then the randomly generated players hand
-  int c[9];
-
-  c[0] = eval7_index(hand1);
-  c[1] = eval7_index(hand2);
-
-  static const int NUMOTHER = 50;
-
-  int others[NUMOTHER];
-
-  int j = 0;
-  for(int i = 0; i < 52; i++)
-  {
-    int v = eval7_index(Card(i));
-    if(v == c[0] || v == c[1]) continue;
-    if(j >= NUMOTHER) break;
-
-    others[j] = v;
-    j++;
-  }
-
-  int wins = 0;
-  int ties = 0;
-  int losses = 0;
+  const int numOpponents = NUMOPP > 0 ? NUMOPP : runtimeOpponents;
+  const int numBoard = 5 - KNOWN; //unknown board cards, the first ones drawn
+  const int amount = numBoard + numOpponents * 2;
+  const PokerEval2::HandVal riverVal = numBoard == 0 ? PokerEval2::RankHand(board | hand) : 0;
 
   for(int i = 0; i < numSamples; i++)
   {
-    shuffleN(others, NUMOTHER, 2 + numOpponents * 2); //the two extra table cards, and the cards of all opponents
-
-    c[2] = others[0];
-    c[3] = others[1];
-    c[4] = others[2];
-    c[5] = others[3];
-    c[6] = others[4];
+    //same draws as shuffleN
+    for(int j = 0; j < amount; j++)
+    {
+      int r = stream.nextInt(j, numOther - 1);
+      std::swap(others[j], others[r]);
+    }
 
-    int yourVal = eval7(&c[0]);
+    PokerEval2::HandMask full = board;
+    for(int j = 0; j < numBoard; j++) full |= others[j];
 
-    int status = 2; //2: you win, 1: you tie, 0: you lose
+    PokerEval2::HandVal yourVal = numBoard == 0 ? riverVal : PokerEval2::RankHand(full | hand);
 
+    PokerEval2::HandVal best = 0;
     for(int j = 0; j < numOpponents; j++)
     {
-      //opponents hand
-      c[7] = others[5 + j * 2];
-      c[8] = others[6 + j * 2];
-
-      int opponentVal = eval7(&c[2]);
-
-      if(opponentVal == yourVal) status = 1; //tie
-      else if(opponentVal > yourVal) { status = 0; break; } //lose, stop rest of loop.
+      PokerEval2::HandVal opponentVal = PokerEval2::RankHand(full | others[numBoard + j * 2] | others[numBoard + j * 2 + 1]);
+      best = std::max(best, opponentVal);
+      if(best > yourVal) break; //lost already
     }
 
-    if(status == 0) losses++;
-    else if(status == 1) ties++;
-    else wins++;
+    wins += best < yourVal;
+    ties += best == yourVal;
+    losses += best > yourVal;
   }
-
-  win = (double)wins / numSamples;
-  tie = (double)ties / numSamples;
-  lose = (double)losses / numSamples;
 }
 
-void getWinChanceAgainstNAtFlop(double& win, double& tie, double& lose
-                               , const Card& hand1, const Card& hand2
-                               , const Card& table1, const Card& table2, const Card& table3
-                               , int numOpponents, int numSamples)
+template<int KNOWN>
+static void runWinChanceKernel(int& wins, int& ties, int& losses
+                             , PokerEval2::HandMask hand, PokerEval2::HandMask board
+                             , PokerEval2::HandMask* others, int numOther
+                             , int numOpponents, int numSamples, RandomStream& stream)
 {
-  win = tie = lose = 0.0;
-
-  //an array of 9 values, set up to contain your hand, the 5 table cards, and then the randomly generated players hand
-  int c[9];
-
-  c[0] = eval7_index(hand1);
-  c[1] = eval7_index(hand2);
-  c[2] = eval7_index(table1);
-  c[3] = eval7_index(table2);
-  c[4] = eval7_index(table3);
-
-  static const int NUMOTHER = 47;
+  switch(numOpponents)
+  {
+    case 1: winChanceKernel<KNOWN, 1>(wins, ties, losses, hand, board, others, numOther, 1, numSamples, stream); break;
+    case 2: winChanceKernel<KNOWN, 2>(wins, ties, losses, hand, board, others, numOther, 2, numSamples, stream); break;
+    case 3: winChanceKernel<KNOWN, 3>(wins, ties, losses, hand, board, others, numOther, 3, numSamples, stream); break;
+    case 4: winChanceKernel<KNOWN, 4>(wins, ties, losses, hand, board, others, numOther, 4, numSamples, stream); break;
+    case 5: winChanceKernel<KNOWN, 5>(wins, ties, losses, hand, board, others, numOther, 5, numSamples, stream); break;
+    case 6: winChanceKernel<KNOWN, 6>(wins, ties, losses, hand, board, others, numOther, 6, numSamples, stream); break;
+    case 7: winChanceKernel<KNOWN, 7>(wins, ties, losses, hand, board, others, numOther, 7, numSamples, stream); break;
+    case 8: winChanceKernel<KNOWN, 8>(wins, ties, losses, hand, board, others, numOther, 8, numSamples, stream); break;
+    case 9: winChanceKernel<KNOWN, 9>(wins, ties, losses, hand, board, others, numOther, 9, numSamples, stream); break;
+    default: winChanceKernel<KNOWN, 0>(wins, ties, losses, hand, board, others, numOther, numOpponents, numSamples, stream); break;
+  }
+}
 
-  int others[NUMOTHER];
+//table has KNOWN cards
+template<int KNOWN>
+static void getWinChanceAgainstN(double& win, double& tie, double& lose
+                               , const Card& hand1, const Card& hand2, const Card* table
+                               , int numOpponents, int numSamples, RandomStream* random)
+{
+  initEvalTables();
+  RandomStream& stream = random ? *random : getThreadRandomStream();
 
-  int j = 0;
-  for(int i = 0; i < 52; i++)
-  {
-    int v = eval7_index(Card(i));
-    if(v == c[0] || v == c[1]) continue;
-    if(v == c[2] || v == c[3] || v == c[4]) continue;
-    if(j >= NUMOTHER) break;
+  PokerEval2::HandMask hand = eval7_mask(hand1) | eval7_mask(hand2);
+  PokerEval2::HandMask board = 0;
+  for(int i = 0; i < KNOWN; i++) board |= eval7_mask(table[i]);
 
-    others[j] = v;
-    j++;
-  }
+  PokerEval2::HandMask others[52];
+  int numOther = getRemainingMasks(others, hand | board);
 
   int wins = 0;
   int ties = 0;
   int losses = 0;
 
-  for(int i = 0; i < numSamples; i++)
-  {
-    shuffleN(others, NUMOTHER, 2 + numOpponents * 2); //the two extra table cards, and the cards of all opponents
-
-    c[5] = others[0];
-    c[6] = others[1];
-
-    int yourVal = eval7(&c[0]);
-
-    int status = 2; //2: you win, 1: you tie, 0: you lose
-
-    for(int j = 0; j < numOpponents; j++)
-    {
-      //opponents hand
-      c[7] = others[2 + j * 2];
-      c[8] = others[3 + j * 2];
-
-      int opponentVal = eval7(&c[2]);
-
-      if(opponentVal == yourVal) status = 1; //tie
-      else if(opponentVal > yourVal) { status = 0; break; } //lose, stop rest of loop.
-    }
-
-    if(status == 0) losses++;
-    else if(status == 1) ties++;
-    else wins++;
-  }
+  runWinChanceKernel<KNOWN>(wins, ties, losses, hand, board, others, numOther, numOpponents, numSamples, stream);
 
   win = (double)wins / numSamples;
   tie = (double)ties / numSamples;
   lose = (double)losses / numSamples;
 }
 
+void getWinChanceAgainstNAtPreFlop(double& win, double& tie, double& lose
+                                 , const Card& hand1, const Card& hand2
+                                 , int numOpponents, int numSamples, RandomStream* random)
+{
+  getWinChanceAgainstN<0>(win, tie, lose, hand1, hand2, 0, numOpponents, numSamples, random);
+}
+
+void getWinChanceAgainstNAtFlop(double& win, double& tie, double& lose
+                               , const Card& hand1, const Card& hand2
+                               , const Card& table1, const Card& table2, const Card& table3
+                               , int numOpponents, int numSamples, RandomStream* random)
+{
+  Card table[3] = { table1, table2, table3 };
+  getWinChanceAgainstN<3>(win, tie, lose, hand1, hand2, table, numOpponents, numSamples, random);
+}
+
 void getWinChanceAgainstNAtTurn(double& win, double& tie, double& lose
                                , const Card& hand1, const Card& hand2
                                , const Card& table1, const Card& table2, const Card& table3, const Card& table4
-                               , int numOpponents, int numSamples)
+                               , int numOpponents, int numSamples, RandomStream* random)
 {
-  win = tie = lose = 0.0;
-
-  //an array of 9 values, set up to contain your hand, the 5 table cards, and then the randomly generated players hand
-  int c[9];
-
-  c[0] = eval7_index(hand1);
-  c[1] = eval7_index(hand2);
-  c[2] = eval7_index(table1);
-  c[3] = eval7_index(table2);
-  c[4] = eval7_index(table3);
-  c[5] = eval7_index(table4);
-
-  static const int NUMOTHER = 46;
-
-  int others[NUMOTHER];
-
-  int j = 0;
-  for(int i = 0; i < 52; i++)
-  {
-    int v = eval7_index(Card(i));
-    if(v == c[0] || v == c[1]) continue;
-    if(v == c[2] || v == c[3] || v == c[4] || v == c[5]) continue;
-    if(j >= NUMOTHER) break;
-
-    others[j] = v;
-    j++;
-  }
-
-  int wins = 0;
-  int ties = 0;
-  int losses = 0;
-
-  for(int i = 0; i < numSamples; i++)
-  {
-    shuffleN(others, NUMOTHER, 1 + numOpponents * 2); //the one extra table card, and the cards of all opponents
-
-    c[6] = others[0];
-
-    int yourVal = eval7(&c[0]);
-
-    int status = 2; //2: you win, 1: you tie, 0: you lose
-
-    for(int j = 0; j < numOpponents; j++)
-    {
-      //opponents hand
-      c[7] = others[1 + j * 2];
-      c[8] = others[2 + j * 2];
-
-      int opponentVal = eval7(&c[2]);
-
-      if(opponentVal == yourVal) status = 1; //tie
-      else if(opponentVal > yourVal) { status = 0; break; } //lose, stop rest of loop.
-    }
-
-    if(status == 0) losses++;
-    else if(status == 1) ties++;
-    else wins++;
-  }
-
-  win = (double)wins / numSamples;
-  tie = (double)ties / numSamples;
-  lose = (double)losses / numSamples;
+  Card table[4] = { table1, table2, table3, table4 };
+  getWinChanceAgainstN<4>(win, tie, lose, hand1, hand2, table, numOpponents, numSamples, random);
 }
 
 void getWinChanceAgainstNAtRiver(double& win, double& tie, double& lose
                                 , const Card& hand1, const Card& hand2
                                 , const Card& table1, const Card& table2, const Card& table3, const Card& table4, const Card& table5
-                                , int numOpponents, int numSamples)
+                                , int numOpponents, int numSamples, RandomStream* random)
 {
-  win = tie = lose = 0.0;
-
-  //an array of 9 values, set up to contain your hand, the 5 table cards, and then the randomly generated players hand
-  int c[9];
-
-  c[0] = eval7_index(hand1);
-  c[1] = eval7_index(hand2);
-  c[2] = eval7_index(table1);
-  c[3] = eval7_index(table2);
-  c[4] = eval7_index(table3);
-  c[5] = eval7_index(table4);
-  c[6] = eval7_index(table5);
-
-  static const int NUMOTHER = 45;
-
-  int others[NUMOTHER];
-
-  int j = 0;
-  for(int i = 0; i < 52; i++)
-  {
-    int v = eval7_index(Card(i));
-    if(v == c[0] || v == c[1]) continue;
-    if(v == c[2] || v == c[3] || v == c[4] || v == c[5] || v == c[6]) continue;
-    if(j >= NUMOTHER) break;
-
-    others[j] = v;
-    j++;
-  }
-
-  int wins = 0;
-  int ties = 0;
-  int losses = 0;
-
-  for(int i = 0; i < numSamples; i++)
-  {
-    shuffleN(others, NUMOTHER,  numOpponents * 2); //the cards of all opponents
-
-    int yourVal = eval7(&c[0]);
-
-    int status = 2; //2: you win, 1: you tie, 0: you lose
-
-    for(int j = 0; j < numOpponents; j++)
-    {
-      //opponents hand
-      c[7] = others[0 + j * 2];
-      c[8] = others[1 + j * 2];
-
-      int opponentVal = eval7(&c[2]);
-
-      if(opponentVal == yourVal) status = 1; //tie
-      else if(opponentVal > yourVal) { status = 0; break; } //lose, stop rest of loop.
-    }
-
-    if(status == 0) losses++;
-    else if(status == 1) ties++;
-    else wins++;
-  }
-
-  win = (double)wins / numSamples;
-  tie = (double)ties / numSamples;
-  lose = (double)losses / numSamples;
+  Card table[5] = { table1, table2, table3, table4, table5 };
+  getWinChanceAgainstN<5>(win, tie, lose, hand1, hand2, table, numOpponents, numSamples, random);
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -827,8 +685,7 @@ ComboType eval7_category(int result)
 
 int eval7(const int* cards)
 {
-  static bool inited = false;
-  if(!inited) { PokerEval2::InitializeHandRankingTables(); inited = true; }
+  initEvalTables(); //thread safe, the simulations can run on multiple threads
 
   return (int)PokerEval2::RankHand( PokerEval2::HandMasksTable[cards[0]] | PokerEval2::HandMasksTable[cards[1]] |
                                     PokerEval2::HandMasksTable[cards[2]] | PokerEval2::HandMasksTable[cards[3]] |
@@ -852,6 +709,22 @@ ComboType eval7_category(int result)
 
 #endif
 
+void eval7_batch(const uint64_t* masks, uint32_t* out, size_t n)
+{
+  initEvalTables();
+  PokerEval2::RankHandBatch(masks, out, n);
+}
+
+uint64_t eval7_mask(const Card& card)
+{
+  return PokerEval2::HandMasksTable[(card.value - 2) + (int)card.suit * 13];
+}
+
+const char* eval7_batch_kernel()
+{
+  return PokerEval2::GetRankHandBatchKernel();
+}
+
 
 ////////////////////////////////////////////////////////////////////////////////
 
@@ -977,27 +850,27 @@ ComboType eval4_2_5_3_slow_category(int result)
 ////////////////////////////////////////////////////////////////////////////////
 ////////////////////////////////////////////////////////////////////////////////
 
-double getPotEquity(const std::vector<Card>& holeCards, const std::vector<Card>& boardCards, int numOpponents, int numSamples)
+double getPotEquity(const std::vector<Card>& holeCards, const std::vector<Card>& boardCards, int numOpponents, int numSamples, RandomStream* random)
 {
   double win = 0, tie = 0, lose = 0;
 
   if(boardCards.empty()) //pre-flop
   {
-    getWinChanceAgainstNAtPreFlop(win, tie, lose, holeCards[0], holeCards[1], numOpponents, numSamples);
+    getWinChanceAgainstNAtPreFlop(win, tie, lose, holeCards[0], holeCards[1], numOpponents, numSamples, random);
   }
   else if(boardCards.size() == 3) //flop
   {
-    getWinChanceAgainstNAtFlop(win, tie, lose, holeCards[0], holeCards[1], boardCards[0], boardCards[1], boardCards[2], numOpponents, numSamples);
+    getWinChanceAgainstNAtFlop(win, tie, lose, holeCards[0], holeCards[1], boardCards[0], boardCards[1], boardCards[2], numOpponents, numSamples, random);
   }
   else if(boardCards.size() == 4) //turn
   {
     if(numOpponents == 1) getWinChanceAgainst1AtTurn(win, tie, lose, holeCards[0], holeCards[1], boardCards[0], boardCards[1], boardCards[2], boardCards[3]);
-    else getWinChanceAgainstNAtTurn(win, tie, lose, holeCards[0], holeCards[1], boardCards[0], boardCards[1], boardCards[2], boardCards[3], numOpponents, numSamples);
+    else getWinChanceAgainstNAtTurn(win, tie, lose, holeCards[0], holeCards[1], boardCards[0], boardCards[1], boardCards[2], boardCards[3], numOpponents, numSamples, random);
   }
   else if(boardCards.size() == 5) //river
   {
     if(numOpponents == 1) getWinChanceAgainst1AtRiver(win, tie, lose, holeCards[0], holeCards[1], boardCards[0], boardCards[1], boardCards[2], boardCards[3], boardCards[4]);
-    else getWinChanceAgainstNAtRiver(win, tie, lose, holeCards[0], holeCards[1], boardCards[0], boardCards[1], boardCards[2], boardCards[3], boardCards[4], numOpponents, numSamples);
+    else getWinChanceAgainstNAtRiver(win, tie, lose, holeCards[0], holeCards[1], boardCards[0], boardCards[1], boardCards[2], boardCards[3], boardCards[4], numOpponents, numSamples, random);
   }
 
   double result = win;
@@ -1079,8 +952,9 @@ bool getWinChanceWithKnownHands(std::vector<double>& win, std::vector<double>& t
                               , const std::vector<Card>& holeCards1
                               , const std::vector<Card>& holeCards2
                               , const std::vector<Card>& boardCards
-                              , int numSamples)
+                              , int numSamples, RandomStream* random)
 {
+  RandomStream& stream = random ? *random : getThreadRandomStream();
   int numPlayers = holeCards1.size();
   int numBoard = (int)boardCards.size();
   if(numPlayers != (int)holeCards2.size()) return false;
@@ -1163,7 +1037,7 @@ bool getWinChanceWithKnownHands(std::vector<double>& win, std::vector<double>& t
 
     for(int i = 0; i < numSamples; i++)
     {
-      shuffleN(&other[0], numOther,  numUnknown); //the cards of all opponents
+      shuffleN(&other[0], numOther, numUnknown, stream); //the cards of all opponents
       testPlayers(&wins[0], &ties[0], &losses[0], &v[0], &val[0], &holeCardsInt1[0], &holeCardsInt2[0], numPlayers);
     }
   }
@@ -1298,3 +1172,115 @@ bool getWinChanceWithKnownHands(std::vector<double>& win, std::vector<double>& t
 
   return true;
 }
+
+////////////////////////////////////////////////////////////////////////////////
+
+//the random streams of all chunks: stream k is jumped k times
+static void makeChunkStreams(std::vector<RandomStream>& streams, int numSamples, uint64_t seed)
+{
+  int numChunks = (numSamples + PARALLEL_CHUNK_SAMPLES - 1) / PARALLEL_CHUNK_SAMPLES;
+  streams.assign(numChunks, RandomStream(seed));
+  for(int k = 1; k < numChunks; k++)
+  {
+    streams[k] = streams[k - 1];
+    streams[k].jump();
+  }
+}
+
+static int getChunkSamples(int chunk, int numSamples)
+{
+  return std::min(PARALLEL_CHUNK_SAMPLES, numSamples - chunk * PARALLEL_CHUNK_SAMPLES);
+}
+
+void getWinChanceAgainstNParallel(double& win, double& tie, double& lose
+                                , const std::vector<Card>& holeCards, const std::vector<Card>& boardCards
+                                , int numOpponents, int numSamples, uint64_t seed)
+{
+  win = tie = lose = 0.0;
+  if(numSamples <= 0) return;
+
+  std::vector<RandomStream> streams;
+  makeChunkStreams(streams, numSamples, seed);
+  int numChunks = (int)streams.size();
+  std::vector<double> results(numChunks * 3); //win, tie and lose of each chunk
+
+  getThreadPool().run(numChunks, [&](int k)
+  {
+    const std::vector<Card>& h = holeCards;
+    const std::vector<Card>& b = boardCards;
+    double* r = &results[k * 3];
+    int n = getChunkSamples(k, numSamples);
+    RandomStream* random = &streams[k];
+
+    if(b.empty()) getWinChanceAgainstNAtPreFlop(r[0], r[1], r[2], h[0], h[1], numOpponents, n, random);
+    else if(b.size() == 3) getWinChanceAgainstNAtFlop(r[0], r[1], r[2], h[0], h[1], b[0], b[1], b[2], numOpponents, n, random);
+    else if(b.size() == 4) getWinChanceAgainstNAtTurn(r[0], r[1], r[2], h[0], h[1], b[0], b[1], b[2], b[3], numOpponents, n, random);
+    else getWinChanceAgainstNAtRiver(r[0], r[1], r[2], h[0], h[1], b[0], b[1], b[2], b[3], b[4], numOpponents, n, random);
+  });
+
+  for(int k = 0; k < numChunks; k++)
+  {
+    double weight = (double)getChunkSamples(k, numSamples) / numSamples;
+    win += results[k * 3 + 0] * weight;
+    tie += results[k * 3 + 1] * weight;
+    lose += results[k * 3 + 2] * weight;
+  }
+}
+
+double getPotEquityParallel(const std::vector<Card>& holeCards, const std::vector<Card>& boardCards, int numOpponents, int numSamples, uint64_t seed)
+{
+  //heads-up at turn and river is exact and fast already, same as in getPotEquity
+  if(numOpponents == 1 && boardCards.size() >= 4) return getPotEquity(holeCards, boardCards, numOpponents);
+
+  double win = 0, tie = 0, lose = 0;
+  getWinChanceAgainstNParallel(win, tie, lose, holeCards, boardCards, numOpponents, numSamples, seed);
+
+  double result = win;
+  result += tie / numOpponents; //split pots
+  return result;
+}
+
+bool getWinChanceWithKnownHandsParallel(std::vector<double>& win, std::vector<double>& tie, std::vector<double>& lose
+                                      , const std::vector<Card>& holeCards1
+                                      , const std::vector<Card>& holeCards2
+                                      , const std::vector<Card>& boardCards
+                                      , int numSamples, uint64_t seed)
+{
+  //if all boards can be enumerated with less than numSamples, getWinChanceWithKnownHands does that, no randomness involved
+  int numOther = 52 - (int)holeCards1.size() * 2 - (int)boardCards.size();
+  int numUnknown = 5 - (int)boardCards.size();
+  if(numSamples <= 0 || numOther < numUnknown || combination(numOther, numUnknown) + 0.5 <= (double)numSamples)
+  {
+    return getWinChanceWithKnownHands(win, tie, lose, holeCards1, holeCards2, boardCards, numSamples);
+  }
+
+  std::vector<RandomStream> streams;
+  makeChunkStreams(streams, numSamples, seed);
+  int numChunks = (int)streams.size();
+  std::vector<std::vector<double> > wins(numChunks), ties(numChunks), losses(numChunks);
+  std::vector<char> valid(numChunks);
+
+  getThreadPool().run(numChunks, [&](int k)
+  {
+    valid[k] = getWinChanceWithKnownHands(wins[k], ties[k], losses[k], holeCards1, holeCards2, boardCards, getChunkSamples(k, numSamples), &streams[k]);
+  });
+
+  for(int k = 0; k < numChunks; k++) if(!valid[k]) return false;
+
+  size_t numPlayers = holeCards1.size();
+  win.assign(numPlayers, 0.0);
+  tie.assign(numPlayers, 0.0);
+  lose.assign(numPlayers, 0.0);
+  for(int k = 0; k < numChunks; k++)
+  {
+    double weight = (double)getChunkSamples(k, numSamples) / numSamples;
+    for(size_t i = 0; i < numPlayers; i++)
+    {
+      win[i] += wins[k][i] * weight;
+      tie[i] += ties[k][i] * weight;
+      lose[i] += losses[k][i] * weight;
+    }
+  }
+
+  return true;
+}
@@ -28,9 +28,14 @@ This source file contains various more complex mathematical poker functions.
 Check combination.h, statistics.h, info.h, util.h and game.h for a bit more poker math functions!
 */
 
+#include <cstddef>
+#include <cstdint>
+
 #include "card.h"
 #include "combination.h"
 
+class RandomStream;
+
 double factorial(int i); //note: only works if result fits in double
 double combination(int n, int p); //Binomial coefficient. Number of rows of p elements that can be made out of n elements, where order doesn't matter.
 
@@ -79,8 +84,9 @@ holeCards: vector must have size 2, represents your two hand cards
 boardCards: vector must have size 0, 3, 4 or 5 (pre-flop, flop, turn, river), represents the known board cards
 numOpponents: number of active opponents
 numSamples: used when this function will use many samples to simulate many possible hand combinations. The higher the value, the more accurate the result, but the slower the function. 50000 is a good value.
+random: the random generator for the simulation (see random.h), or 0 to use the one of the calling thread. With a stream with a known seed, the result is reproducible.
 */
-double getPotEquity(const std::vector<Card>& holeCards, const std::vector<Card>& boardCards, int numOpponents, int numSamples = 50000);
+double getPotEquity(const std::vector<Card>& holeCards, const std::vector<Card>& boardCards, int numOpponents, int numSamples = 50000, RandomStream* random = 0);
 
 
 /*
@@ -93,6 +99,7 @@ win, tie and lose: this are std::vectors that will have the same size as the num
 holeCards1, holeCards2: the hand cards of all players. The size of these vectors must be the same and indicates the amount of players.
 boardCards: 0 to 5 cards on the table.
 numSamples: used when this function will use many samples to simulate many possible hand combinations. The higher the value, the more accurate the result, but the slower the function. 50000 is a good value.
+random: the random generator for the simulation (see random.h), or 0 to use the one of the calling thread. With a stream with a known seed, the result is reproducible.
 
 returns false if error happened (such as invalid parameters)
 */
@@ -100,7 +107,7 @@ bool getWinChanceWithKnownHands(std::vector<double>& win, std::vector<double>& t
                               , const std::vector<Card>& holeCards1
                               , const std::vector<Card>& holeCards2
                               , const std::vector<Card>& boardCards
-                              , int numSamples = 50000);
+                              , int numSamples = 50000, RandomStream* random = 0);
 
 
 
@@ -115,6 +122,16 @@ int eval7(const int* cards /*NOT card.getIndex()!!!*/);
 int eval7_index(const Card& card);
 ComboType eval7_category(int result); //converts result from eval to named combo type (without info about card values)
 
+/*
+Evaluates many combinations of 7 cards at once, for simulations that can first collect a batch of
+hands. Each input is a bit mask of 7 cards, made by OR-ing eval7_mask of the cards. out[i] gets the
+same value as eval7 would give for the 7 cards of masks[i] (with the default PokerEval2 evaluator).
+Depending on what the CPU supports, 16 or 8 hands are evaluated at once with AVX-512 or AVX2.
+*/
+void eval7_batch(const uint64_t* masks, uint32_t* out, size_t n);
+uint64_t eval7_mask(const Card& card);
+const char* eval7_batch_kernel(); //name of the version eval7_batch uses on this CPU: "avx512", "avx2" or "scalar"
+
 /*
 Similar to eval7 but for 5 cards. Note: integer values related to eval7 and evan7index are NOT
 interchangeable with those of eval5!
@@ -177,25 +194,50 @@ They use monte-carlo integration instead: you can choose an amount of random sam
 
 The higher the numSamples parameter, the more precise the solution, but the more calculation
 time is needed. Setting it lower makes your bot faster.
+
+random is the random generator used for the samples, as for getPotEquity.
+
+All four share one kernel that is compiled separately for every street and every amount of
+opponents from 1 to 9 (more opponents use a generic version of it).
 */
 
 void getWinChanceAgainstNAtPreFlop(double& win, double& tie, double& lose
                                  , const Card& hand1, const Card& hand2
-                                 , int numOpponents, int numSamples = 50000);
+                                 , int numOpponents, int numSamples = 50000, RandomStream* random = 0);
 
 
 void getWinChanceAgainstNAtFlop(double& win, double& tie, double& lose
                                , const Card& hand1, const Card& hand2
                                , const Card& table1, const Card& table2, const Card& table3
-                               , int numOpponents, int numSamples = 50000);
+                               , int numOpponents, int numSamples = 50000, RandomStream* random = 0);
 
 void getWinChanceAgainstNAtTurn(double& win, double& tie, double& lose
                                , const Card& hand1, const Card& hand2
                                , const Card& table1, const Card& table2, const Card& table3, const Card& table4
-                               , int numOpponents, int numSamples = 50000);
+                               , int numOpponents, int numSamples = 50000, RandomStream* random = 0);
 
 void getWinChanceAgainstNAtRiver(double& win, double& tie, double& lose
                                , const Card& hand1, const Card& hand2
                                , const Card& table1, const Card& table2, const Card& table3, const Card& table4, const Card& table5
-                               , int numOpponents, int numSamples = 50000);
+                               , int numOpponents, int numSamples = 50000, RandomStream* random = 0);
+
+/*
+Multi-threaded versions of getPotEquity, the getWinChanceAgainstN functions (for any board size) and
+getWinChanceWithKnownHands, for big amounts of samples. The samples are split in chunks of
+PARALLEL_CHUNK_SAMPLES, which run on the thread pool of threadpool.h. Chunk k uses the random
+stream RandomStream(seed, k), and the results of the chunks are added together in the order of the
+chunks, so the result only depends on the seed and numSamples, not on the amount of threads.
+*/
+const int PARALLEL_CHUNK_SAMPLES = 8192;
+
+double getPotEquityParallel(const std::vector<Card>& holeCards, const std::vector<Card>& boardCards, int numOpponents, int numSamples = 500000, uint64_t seed = 0);
+
+void getWinChanceAgainstNParallel(double& win, double& tie, double& lose
+                                , const std::vector<Card>& holeCards, const std::vector<Card>& boardCards
+                                , int numOpponents, int numSamples = 500000, uint64_t seed = 0);
 
+bool getWinChanceWithKnownHandsParallel(std::vector<double>& win, std::vector<double>& tie, std::vector<double>& lose
+                                      , const std::vector<Card>& holeCards1
+                                      , const std::vector<Card>& holeCards2
+                                      , const std::vector<Card>& boardCards
+                                      , int numSamples = 500000, uint64_t seed = 0);
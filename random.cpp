@@ -24,56 +24,158 @@ along with OOPoker.  If not, see <http://www.gnu.org/licenses/>.
 
 #include "os.h"
 
+#include <atomic>
+#include <cstdlib>
 #include <iostream>
+#include <utility>
 
 #if defined(_WIN32)
 
 #include <windows.h>
 
-unsigned int getRandomUint()
+static void getOSRandomBytes(void* buffer, size_t size)
 {
-  unsigned int r;
+  bool success = false;
 
   HMODULE hLib=LoadLibrary("ADVAPI32.DLL");
   if(hLib) {
     BOOLEAN (APIENTRY *pfn)(void*, ULONG) =
         (BOOLEAN (APIENTRY *)(void*,ULONG))GetProcAddress(hLib,"SystemFunction036");
-    if(pfn) {
-      char buff[4];
-      ULONG ulCbBuff = sizeof(buff);
-      if(pfn(buff,ulCbBuff)) {
-        // use buff full of random goop
-        r = buff[0] + 256 * buff[1] + 256 * 256 * buff[2] + 256 * 256 * 256 * buff[3];
-      }
-    }
+    if(pfn) success = pfn(buffer, (ULONG)size);
 
     FreeLibrary(hLib);
   }
 
-  return r;
+  if(!success) {
+    std::cerr << "SystemFunction036 failed! Need a random source to operate. Quitting program." << std::endl;
+    std::exit(1);
+  }
+}
+
+static void registerForkHandler(void (*)())
+{
+  //no fork on Windows
 }
 
 // TODO: OS_UNKNOWN may not have /dev/urandom, provide alternative implementation
 #elif defined(OS_LINUX) || defined(OS_UNKNOWN)
 
-#include <string>
-#include <fstream>
+#include <cstdio>
+#include <pthread.h>
 
-unsigned int getRandomUint()
+static void getOSRandomBytes(void* buffer, size_t size)
 {
-  unsigned int r;
-  static std::string filename = "/dev/urandom";
-  static std::ifstream file(filename.c_str(), std::ios::in|std::ios::binary|std::ios::ate);
-  if(!file) {
+  FILE* file = fopen("/dev/urandom", "rb");
+  if(!file || fread(buffer, 1, size, file) != size) {
     std::cerr << "no /dev/urandom found! Need a random source to operate. Quitting program." << std::endl;
     std::exit(1);
   }
-  file.read((char*)(&r), sizeof(r));
-  return r;
+  fclose(file);
+}
+
+static void registerForkHandler(void (*handler)())
+{
+  pthread_atfork(0, 0, handler);
 }
 
 #endif
 
+////////////////////////////////////////////////////////////////////////////////
+
+static inline uint32_t rotl32(uint32_t x, int k)
+{
+  return (x << k) | (x >> (32 - k));
+}
+
+#define CHACHA_QUARTERROUND(a, b, c, d)\
+  a += b; d = rotl32(d ^ a, 16);\
+  c += d; b = rotl32(b ^ c, 12);\
+  a += b; d = rotl32(d ^ a, 8);\
+  c += d; b = rotl32(b ^ c, 7);
+
+//one 64-byte block of the ChaCha20 stream of the key, for the given block counter (nonce 0)
+static void chacha20Block(uint32_t out[16], const uint32_t key[8], uint64_t counter)
+{
+  uint32_t in[16] = { 0x61707865, 0x3320646e, 0x79622d32, 0x6b206574, //"expand 32-byte k"
+                      key[0], key[1], key[2], key[3], key[4], key[5], key[6], key[7],
+                      (uint32_t)counter, (uint32_t)(counter >> 32), 0, 0 };
+  uint32_t x[16];
+  for(int i = 0; i < 16; i++) x[i] = in[i];
+
+  for(int i = 0; i < 10; i++)
+  {
+    CHACHA_QUARTERROUND(x[0], x[4], x[8], x[12]);
+    CHACHA_QUARTERROUND(x[1], x[5], x[9], x[13]);
+    CHACHA_QUARTERROUND(x[2], x[6], x[10], x[14]);
+    CHACHA_QUARTERROUND(x[3], x[7], x[11], x[15]);
+    CHACHA_QUARTERROUND(x[0], x[5], x[10], x[15]);
+    CHACHA_QUARTERROUND(x[1], x[6], x[11], x[12]);
+    CHACHA_QUARTERROUND(x[2], x[7], x[8], x[13]);
+    CHACHA_QUARTERROUND(x[3], x[4], x[9], x[14]);
+  }
+
+  for(int i = 0; i < 16; i++) out[i] = x[i] + in[i];
+}
+
+SecureRandom::SecureRandom()
+: pos(BUFFER_SIZE)
+, counter(0)
+, output(RESEED_AMOUNT)
+{
+  static const bool registered = (registerForkHandler(&SecureRandom::afterFork), true);
+  (void)registered;
+}
+
+/*
+Fills the buffer with the next blocks of the ChaCha20 stream. The first 8 words of the new output
+become the next key and are never given out, and nextUint clears every word it gives out, so the
+values that were already given out can't be reconstructed from the state (this is the same
+construction as arc4random of OpenBSD). A new key is taken from the operating system at the start
+and after every RESEED_AMOUNT words.
+*/
+void SecureRandom::refill()
+{
+  if(output >= RESEED_AMOUNT)
+  {
+    getOSRandomBytes(key, sizeof(key));
+    counter = 0;
+    output = 0;
+  }
+
+  for(int i = 0; i < BUFFER_SIZE / 16; i++) chacha20Block(&buffer[i * 16], key, counter++);
+  for(int i = 0; i < 8; i++)
+  {
+    key[i] = buffer[i];
+    buffer[i] = 0;
+  }
+  pos = 8;
+  output += BUFFER_SIZE - 8;
+}
+
+/*
+Runs in the child process after a fork. Only the thread that forked exists there, so that's the only
+generator to reset: it must not give out the rest of its buffer or continue with the key of the parent,
+else the parent and child would give the same numbers.
+*/
+void SecureRandom::afterFork()
+{
+  SecureRandom& random = getThreadSecureRandom();
+  for(int i = 0; i < BUFFER_SIZE; i++) random.buffer[i] = 0;
+  random.pos = BUFFER_SIZE;
+  random.output = RESEED_AMOUNT;
+}
+
+SecureRandom& getThreadSecureRandom()
+{
+  thread_local SecureRandom random;
+  return random;
+}
+
+unsigned int getRandomUint()
+{
+  return getThreadSecureRandom().nextUint();
+}
+
 double getRandom()
 {
   return getRandomUint() / 4294967296.0;
@@ -81,27 +183,18 @@ double getRandom()
 
 int getRandom(int low, int high)
 {
-  return getRandomUint() % (high - low + 1) + low;
+  return getThreadSecureRandom().nextInt(low, high);
 }
 
 
-static unsigned int m_w = 1;
-static unsigned int m_z = 2;
-
-//"Multiply-With-Carry" generator of G. Marsaglia
 unsigned int getRandomUintFast()
 {
-  m_z = 36969 * (m_z & 65535) + (m_z >> 16);
-  m_w = 18000 * (m_w & 65535) + (m_w >> 16);
-  return (m_z << 16) + m_w;  //32-bit result
+  return getThreadRandomStream().nextUint();
 }
 
 void seedRandomFast(unsigned int seed1, unsigned int seed2)
 {
-  if(seed1 == 0) seed1 = 1;
-  if(seed2 == 0) seed2 = 1;
-  m_w = seed1;
-  m_z = seed2;
+  getThreadRandomStream().seed(((uint64_t)seed1 << 32) | seed2);
 }
 
 void seedRandomFastWithRandomSlow()
@@ -116,5 +209,72 @@ double getRandomFast()
 
 int getRandomFast(int low, int high)
 {
-  return getRandomUintFast() % (high - low + 1) + low;
+  return getThreadRandomStream().nextInt(low, high);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+RandomStream::RandomStream(uint64_t seed)
+{
+  this->seed(seed);
+}
+
+RandomStream::RandomStream(uint64_t seed, int stream)
+{
+  this->seed(seed);
+  for(int i = 0; i < stream; i++) jump();
+}
+
+//the state is filled with the splitmix64 generator, as recommended for xoshiro, so that it's never all zero
+void RandomStream::seed(uint64_t seed)
+{
+  for(int i = 0; i < 4; i++)
+  {
+    uint64_t z = (seed += 0x9e3779b97f4a7c15ull);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+    s[i] = z ^ (z >> 31);
+  }
+}
+
+void RandomStream::jump()
+{
+  static const uint64_t JUMP[4] = { 0x180ec6d33cfd0abaull, 0xd5a61266f0c9392cull, 0xa9582618e03fc9aaull, 0x39abdc4529b1661cull };
+
+  uint64_t t[4] = { 0, 0, 0, 0 };
+  for(int i = 0; i < 4; i++)
+  {
+    for(int b = 0; b < 64; b++)
+    {
+      if(JUMP[i] & (1ull << b))
+      {
+        for(int j = 0; j < 4; j++) t[j] ^= s[j];
+      }
+      next();
+    }
+  }
+  for(int j = 0; j < 4; j++) s[j] = t[j];
+}
+
+//the seed of all thread streams, taken from the secure generator once per process
+static uint64_t getThreadStreamSeed()
+{
+  static const uint64_t seed = ((uint64_t)getRandomUint() << 32) | getRandomUint();
+  return seed;
+}
+
+RandomStream& getThreadRandomStream()
+{
+  static std::atomic<int> numThreads(0);
+  thread_local RandomStream stream(getThreadStreamSeed(), numThreads++);
+  return stream;
+}
+
+void shuffleN(int* values, int size, int amount, RandomStream& random)
+{
+  for(int i = 0; i < amount; i++)
+  {
+    int r = random.nextInt(i, size - 1);
+    std::swap(values[i], values[r]);
+  }
 }
@@ -22,16 +22,130 @@ along with OOPoker.  If not, see <http://www.gnu.org/licenses/>.
 
 #pragma once
 
-//these methods use the true-random facilities provided by the operating system (non blocking, so not necessarily every returned value is true random!)
-//it uses SystemFunction036 on Windows, /dev/urandom on Linux.
+#include <cstdint>
+
+/*
+Uniform random integer in range low-high (high included) from the 32-bit values of generator.nextUint(), with
+the multiply-and-shift method of Daniel Lemire. Unlike a modulo, this doesn't make some values more likely.
+*/
+template<typename Generator>
+int getBoundedRandom(Generator& generator, int low, int high)
+{
+  uint64_t range = (uint64_t)((int64_t)high - low) + 1;
+  uint64_t m = (uint64_t)generator.nextUint() * range;
+  if((uint32_t)m < range) //rarely needed: reject the values that would make some results more likely
+  {
+    uint32_t threshold = (uint32_t)((0x100000000ull - range) % range);
+    while((uint32_t)m < threshold) m = (uint64_t)generator.nextUint() * range;
+  }
+  return (int)(low + (int64_t)(m >> 32));
+}
+
+/*
+Cryptographically secure random generator: ChaCha20, keyed with random bytes from the operating system
+(SystemFunction036 on Windows, /dev/urandom on Linux). It generates 1KB at a time, so only one in 256 calls
+does any real work, and the operating system is only asked for a new key once per 64MB of output, and in the
+child after a fork.
+*/
+class SecureRandom
+{
+  public:
+    SecureRandom();
+
+    unsigned int nextUint()
+    {
+      if(pos >= BUFFER_SIZE) refill();
+      unsigned int result = buffer[pos];
+      buffer[pos++] = 0; //so that it can't be read back from the state later
+      return result;
+    }
+
+    int nextInt(int low, int high) { return getBoundedRandom(*this, low, high); }
+
+  private:
+    void refill();
+    static void afterFork(); //drops the buffer and key of the thread that forked, in the child process
+
+    static const int BUFFER_SIZE = 256; //in 32-bit words, 16 ChaCha20 blocks
+    static const uint64_t RESEED_AMOUNT = 1 << 24; //in 32-bit words
+
+    uint32_t buffer[BUFFER_SIZE];
+    int pos;
+    uint32_t key[8];
+    uint64_t counter;
+    uint64_t output; //words generated since the last key from the operating system
+};
+
+SecureRandom& getThreadSecureRandom(); //the SecureRandom of the calling thread
+
+//these methods use the secure random generator of the calling thread, which is seeded by the operating system.
 unsigned int getRandomUint();
 double getRandom(); //returns random double in range 0.0-1.0
 int getRandom(int low, int high); //returns random in the given range. high is included.
 
-//much faster than the true-random functions above, but only pseudo-random.
+//much faster than the true-random functions above, but only pseudo-random. They use the RandomStream of the calling thread (see below).
 unsigned int getRandomUintFast();
 double getRandomFast(); //returns random double in range 0.0-1.0
 int getRandomFast(int low, int high); //returns random in the given range. high is included.
 
-void seedRandomFast(unsigned int seed1, unsigned int seed2);
-void seedRandomFastWithRandomSlow(); //seed the fast random generator, with two values from the slow random generator.
+void seedRandomFast(unsigned int seed1, unsigned int seed2); //seeds the RandomStream of the calling thread
+void seedRandomFastWithRandomSlow(); //seeds the RandomStream of the calling thread (only), with two values from the slow random generator.
+
+/*
+A fast pseudo-random generator (xoshiro256**) with its own state, for Monte Carlo simulations.
+
+Each thread that simulates should use its own RandomStream, then there are no data races, and a
+simulation that is given a stream with a known seed gives exactly the same result every time.
+
+For parallel simulations, give each worker the stream RandomStream(seed, worker): these are the same
+sequence as RandomStream(seed), but each one jumped 2^128 steps further than the previous one, so the
+streams of the workers never overlap.
+*/
+class RandomStream
+{
+  public:
+    RandomStream(uint64_t seed = 0);
+    RandomStream(uint64_t seed, int stream);
+
+    void seed(uint64_t seed);
+    void jump(); //advances the state 2^128 steps
+
+    uint64_t next()
+    {
+      uint64_t result = rotl(s[1] * 5, 7) * 9;
+      uint64_t t = s[1] << 17;
+      s[2] ^= s[0];
+      s[3] ^= s[1];
+      s[1] ^= s[2];
+      s[0] ^= s[3];
+      s[2] ^= t;
+      s[3] = rotl(s[3], 45);
+      return result;
+    }
+
+    unsigned int nextUint() { return (unsigned int)(next() >> 32); }
+    double nextDouble() { return (next() >> 11) * (1.0 / 9007199254740992.0); } //in range 0.0-1.0, 1.0 not included
+
+    int nextInt(int low, int high) { return getBoundedRandom(*this, low, high); } //returns random in the given range, high is included
+
+  private:
+    static uint64_t rotl(uint64_t x, int k) { return (x << k) | (x >> (64 - k)); }
+
+    uint64_t s[4];
+};
+
+/*
+The default RandomStream of the calling thread, used by getRandomFast and by the simulation functions
+when no stream is given to them. All threads use one seed, chosen with the secure generator the first
+time any thread needs its stream, so the results differ from run to run: the first thread that uses it
+gets RandomStream(seed, 0), the next thread RandomStream(seed, 1), and so on, which never overlap.
+To replay a simulation, give it a RandomStream with a known seed instead.
+*/
+RandomStream& getThreadRandomStream();
+
+/*
+For efficiently choosing "amount" unique random values out of a list of "size" values, as is needed
+to deal cards in Monte Carlo simulations: this shuffles only the first "amount" values of the list, so
+it's O(amount) instead of O(size). Afterwards, use the first "amount" values.
+*/
+void shuffleN(int* values, int size, int amount, RandomStream& random);
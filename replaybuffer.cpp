@@ -0,0 +1,71 @@
+/*
+OOPoker
+
+Copyright (c) 2010 Lode Vandevenne
+All rights reserved.
+
+This file is part of OOPoker.
+
+OOPoker is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+OOPoker is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with OOPoker.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include "replaybuffer.h"
+
+#include <utility>
+
+ReplayBuffer::ReplayBuffer(size_t capacity)
+: capacity(capacity < 1 ? 1 : capacity)
+, next(0)
+, numAdded(0)
+{
+}
+
+void ReplayBuffer::add(Trajectory& trajectory)
+{
+  std::lock_guard<std::mutex> lock(mutex);
+  if(items.size() < capacity) items.push_back(std::move(trajectory));
+  else
+  {
+    items[next] = std::move(trajectory);
+    next = (next + 1) % capacity;
+  }
+  numAdded++;
+}
+
+void ReplayBuffer::sample(std::vector<Trajectory>& result, size_t amount, RandomStream& random) const
+{
+  std::lock_guard<std::mutex> lock(mutex);
+  result.clear();
+  if(items.empty()) return;
+  result.resize(amount);
+  for(size_t i = 0; i < amount; i++) result[i] = items[random.nextInt(0, (int)items.size() - 1)];
+}
+
+size_t ReplayBuffer::getSize() const
+{
+  std::lock_guard<std::mutex> lock(mutex);
+  return items.size();
+}
+
+size_t ReplayBuffer::getCapacity() const
+{
+  return capacity;
+}
+
+long long ReplayBuffer::getNumAdded() const
+{
+  std::lock_guard<std::mutex> lock(mutex);
+  return numAdded;
+}
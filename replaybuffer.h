@@ -0,0 +1,59 @@
+/*
+OOPoker
+
+Copyright (c) 2010 Lode Vandevenne
+All rights reserved.
+
+This file is part of OOPoker.
+
+OOPoker is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+OOPoker is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with OOPoker.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#pragma once
+
+#include <cstddef>
+#include <mutex>
+#include <vector>
+
+#include "random.h"
+#include "trajectory.h"
+
+/*
+Experience replay for the RL learner: keeps the most recent trajectories (one per deal an agent played),
+so an update can train on a random sample of many hands instead of only the last few, and every hand
+can be used by several updates. When it's full, new trajectories overwrite the oldest ones.
+
+All functions are thread safe, so actors can add while the learner samples.
+*/
+class ReplayBuffer
+{
+  public:
+    ReplayBuffer(size_t capacity);
+
+    void add(Trajectory& trajectory); //moves the trajectory into the buffer
+    //replaces result with amount trajectories chosen uniformly at random (with replacement). Empty if the buffer is empty.
+    void sample(std::vector<Trajectory>& result, size_t amount, RandomStream& random) const;
+
+    size_t getSize() const;
+    size_t getCapacity() const;
+    long long getNumAdded() const; //total ever added, including the overwritten ones
+
+  private:
+    mutable std::mutex mutex;
+    std::vector<Trajectory> items;
+    size_t capacity;
+    size_t next; //where the next one goes once the buffer is full
+    long long numAdded;
+};
@@ -0,0 +1,137 @@
+/*
+OOPoker
+
+Copyright (c) 2010 Lode Vandevenne
+All rights reserved.
+
+This file is part of OOPoker.
+
+OOPoker is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+OOPoker is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with OOPoker.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include "riverranker.h"
+
+#include <algorithm>
+
+#include "pokermath.h"
+
+RiverRanker::RiverRanker()
+: board(0)
+, size(0)
+, values(NUM_COMBOS, 0)
+, combos(NUM_COMBOS)
+, sortedValues(NUM_COMBOS)
+, card1(NUM_COMBOS)
+, card2(NUM_COMBOS)
+, keys(NUM_COMBOS)
+{
+}
+
+void RiverRanker::setBoard(uint64_t board, const unsigned char* needed)
+{
+  this->board = board;
+  std::fill(values.begin(), values.end(), 0);
+
+  //the hands go in keys first, then their values in sortedValues
+  std::vector<uint64_t>& hands = keys;
+  size = 0;
+  for(int i = 0; i < NUM_COMBOS; i++)
+  {
+    uint64_t mask = getComboMask(i);
+    if((mask & board) || (needed && !needed[i])) continue;
+    combos[size] = i;
+    hands[size] = board | mask;
+    size++;
+  }
+  if(size == 0) return;
+  eval7_batch(&hands[0], &sortedValues[0], size);
+
+  for(int i = 0; i < size; i++)
+  {
+    values[combos[i]] = sortedValues[i];
+    keys[i] = ((uint64_t)sortedValues[i] << 16) | (uint64_t)combos[i];
+  }
+  std::sort(keys.begin(), keys.begin() + size);
+
+  for(int i = 0; i < size; i++)
+  {
+    int combo = (int)(keys[i] & 0xffff);
+    int a, b;
+    getComboCards(a, b, combo);
+    combos[i] = combo;
+    sortedValues[i] = (uint32_t)(keys[i] >> 16);
+    card1[i] = (unsigned char)a;
+    card2[i] = (unsigned char)b;
+  }
+}
+
+void RiverRanker::setBoard(const std::vector<Card>& boardCards)
+{
+  uint64_t mask = 0;
+  for(size_t i = 0; i < boardCards.size(); i++) mask |= eval7_mask(boardCards[i]);
+  setBoard(mask);
+}
+
+void RiverRanker::getShowdown(double* equity, double* total, const float* weights) const
+{
+  double grandTotal = 0.0;
+  double cardTotal[52] = { 0.0 };
+  for(int i = 0; i < size; i++)
+  {
+    float w = weights[combos[i]];
+    grandTotal += w;
+    cardTotal[card1[i]] += w;
+    cardTotal[card2[i]] += w;
+  }
+
+  //go through groups of equal value from low to high
+  double lessTotal = 0.0;
+  double lessCard[52] = { 0.0 };
+  double equalCard[52] = { 0.0 };
+  for(int i = 0; i < size;)
+  {
+    int j = i;
+    double equalTotal = 0.0;
+    while(j < size && sortedValues[j] == sortedValues[i])
+    {
+      float w = weights[combos[j]];
+      equalTotal += w;
+      equalCard[card1[j]] += w;
+      equalCard[card2[j]] += w;
+      j++;
+    }
+
+    for(int k = i; k < j; k++)
+    {
+      int a = card1[k], b = card2[k];
+      float w = weights[combos[k]];
+      double less = lessTotal - lessCard[a] - lessCard[b];
+      double equal = equalTotal - equalCard[a] - equalCard[b] + w; //+w because the combo itself is subtracted twice
+      equity[combos[k]] = less + 0.5 * equal;
+      total[combos[k]] = grandTotal - cardTotal[a] - cardTotal[b] + w;
+    }
+
+    lessTotal += equalTotal;
+    for(int k = i; k < j; k++)
+    {
+      float w = weights[combos[k]];
+      lessCard[card1[k]] += w;
+      lessCard[card2[k]] += w;
+      equalCard[card1[k]] = 0.0;
+      equalCard[card2[k]] = 0.0;
+    }
+    i = j;
+  }
+}
@@ -0,0 +1,88 @@
+/*
+OOPoker
+
+Copyright (c) 2010 Lode Vandevenne
+All rights reserved.
+
+This file is part of OOPoker.
+
+OOPoker is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+OOPoker is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with OOPoker.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#pragma once
+
+/*
+Ranks all hole card combos on one river board at once.
+
+Anything that works with ranges at the river (range equity, hand strength for abstraction buckets, ...)
+needs the hand value of every possible holding on the same 5 board cards. Instead of calling eval7 for
+each of them, the RiverRanker ORs the board mask with the mask of every combo that doesn't share a card
+with it, ranks all of them with one call of eval7_batch, and sorts them from worst to best.
+
+From the sorted order, the showdown of every combo against a whole weighted range is computed in a
+single pass (the usual trick of CFR solvers): walking from the worst to the best hand, keep the total
+weight of the weaker hands, and per card the weight of the weaker hands that contain that card. The
+weight a combo beats is then the total minus the weaker hands that share one of its two cards (a hand
+that shares both is the combo itself, which isn't weaker). Ties are done the same way within groups of
+equal value. That makes it O(n) after the sort instead of O(n^2) comparisons.
+
+Combos are numbered as in handrange.h.
+*/
+
+#include <stdint.h>
+#include <vector>
+
+#include "card.h"
+#include "handrange.h"
+
+class RiverRanker
+{
+  public:
+    RiverRanker();
+
+    /*
+    Ranks the combos for this board (5 cards, as bit mask of eval7_mask). If needed is given, only
+    the combos with needed[combo] != 0 are ranked, the others are left out as if they contain a board card.
+    */
+    void setBoard(uint64_t board, const unsigned char* needed = 0);
+    void setBoard(const std::vector<Card>& boardCards);
+    uint64_t getBoard() const { return board; }
+
+    //the ranked combos, sorted from lowest to highest value
+    int getSize() const { return size; }
+    int getCombo(int i) const { return combos[i]; }
+    uint32_t getValue(int i) const { return sortedValues[i]; }
+
+    uint32_t getComboValue(int combo) const { return values[combo]; } //same value as eval7, 0 if the combo isn't ranked
+
+    /*
+    For every ranked combo: equity[combo] gets the weight of the combos of the opponent range it beats plus
+    half the weight of the ones it ties with, and total[combo] the weight of all combos of the opponent range
+    that don't share a card with it, so equity / total is its equity against the range. weights has
+    NUM_COMBOS values, equity and total must have room for NUM_COMBOS values. Entries of combos that
+    aren't ranked are not touched.
+    */
+    void getShowdown(double* equity, double* total, const float* weights) const;
+
+  private:
+    uint64_t board;
+    int size;
+    std::vector<uint32_t> values; //per combo
+    std::vector<int> combos; //sorted
+    std::vector<uint32_t> sortedValues;
+    std::vector<unsigned char> card1; //sorted, eval7 index of the cards of the combo
+    std::vector<unsigned char> card2;
+    std::vector<uint64_t> keys; //value in the high bits and combo in the low bits, for sorting
+};
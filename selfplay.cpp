@@ -0,0 +1,183 @@
+#include "selfplay.h"
+#include <algorithm>
+#include <iostream>
+#include <string>
+#include <thread>
+#include "ai_rl.h"
+#include "game.h"
+#include "host.h"
+#include "player.h"
+#include "random.h"
+
+// host of a self-play table: nobody watches, it only ends the deals of the agents and stops on request
+class HostSelfPlay : public Host {
+public:
+    HostSelfPlay(const std::atomic<bool>& stop, const std::function<void()>& on_deal_done)
+      : stop(stop), on_deal_done(on_deal_done) {}
+
+    void onFrame() override {}
+    void onGameBegin(const Info&) override {}
+    void onDealDone(const Info&) override { on_deal_done(); }
+    void onGameDone(const Info&) override {}
+
+    bool wantToQuit() const override { return stop.load(std::memory_order_relaxed); }
+    void resetWantToQuit() override {}
+
+private:
+    const std::atomic<bool>& stop;
+    std::function<void()> on_deal_done;
+};
+
+SelfPlaySettings::SelfPlaySettings()
+  : num_tables(0), players_per_table(2), deals_per_game(1000)
+  , queue_capacity(4096), report_seconds(5.0), seed(0)
+  , batched_inference(true), inference_max_batch(64), inference_max_wait_us(200) {}
+
+SelfPlayArena::SelfPlayArena(Learner& learner, const SelfPlaySettings& settings)
+  : learner(learner), net(learner.get_net()), settings(settings), queue(settings.queue_capacity)
+  , stop(false), hands(0), stalls(0)
+  , start_time(std::chrono::steady_clock::now())
+{
+  if (this->settings.num_tables <= 0) {
+    this->settings.num_tables = std::max(1, (int)std::thread::hardware_concurrency() - 1);
+  }
+} // end of constructor
+
+void SelfPlayArena::copy_weights(PokerNet& dst, int& version)
+{
+  if (learner.get_weights_version() == version) return;
+
+  std::lock_guard<std::mutex> lock(learner.get_weights_mutex());
+  torch::NoGradGuard no_grad;
+  auto src_params = net->parameters();
+  auto dst_params = dst->parameters();
+  for (size_t i = 0; i < src_params.size(); i++) dst_params[i].copy_(src_params[i]);
+  version = learner.get_weights_version();
+} // end of copy_weights
+
+void SelfPlayArena::run_table(int table)
+{
+  // the broker works on the shared net, without it the table needs its own copy
+  PokerNet local_net(nullptr);
+  int local_version = -1;
+  if (!broker) {
+    local_net = PokerNet(net->card_embedding->options.in_features(), net->rnn->options.hidden_size());
+    local_net->eval();
+    copy_weights(local_net, local_version);
+  }
+  PokerNet& play_net = broker ? net : local_net;
+
+  auto push = [this, table, &local_version](Trajectory& trajectory) {
+    trajectory.weightsVersion = broker ? learner.get_weights_version() : local_version;
+    trajectory.table = table;
+    while (!queue.tryPush(trajectory)) {
+      if (stop.load(std::memory_order_relaxed)) return;
+      stalls++;
+      std::this_thread::yield();
+    }
+  };
+
+  std::vector<AIRL*> agents;
+  HostSelfPlay host(stop, [&]() {
+    // the E_WIN events of the deal have been sent, so the agents know their rewards now
+    for (size_t i = 0; i < agents.size(); i++) agents[i]->end_hand();
+    hands++;
+    if (!broker) copy_weights(local_net, local_version);
+  });
+
+  RandomStream seeds(settings.seed, table);
+  while (!stop.load()) {
+    Rules rules;
+    rules.buyIn = 1000;
+    rules.bigBlind = 10;
+    rules.smallBlind = 5;
+    rules.allowRebuy = true;
+    rules.fixedNumberOfDeals = settings.deals_per_game;
+
+    Game game(&host);
+    game.setRules(rules);
+    game.setShuffleMode(SHUFFLE_FAST, seeds.next());
+
+    agents.clear();
+    for (int i = 0; i < settings.players_per_table; i++) {
+      AIRL* agent = new AIRL(play_net, push, broker.get()); // deleted by the game
+      agents.push_back(agent);
+      game.addPlayer(Player(agent, "RL_" + std::to_string(table) + "_" + std::to_string(i)));
+    }
+
+    game.doGame();
+  }
+} // end of run_table
+
+void SelfPlayArena::run_learner()
+{
+  Trajectory trajectory;
+  while (!stop.load()) {
+    if (!queue.tryPop(trajectory)) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+      continue;
+    }
+    learner.add(trajectory);
+    if (learner.ready()) learner.update();
+  }
+} // end of run_learner
+
+void SelfPlayArena::run(long long num_hands)
+{
+  stop = false;
+  hands = 0;
+  start_time = std::chrono::steady_clock::now();
+  if (settings.batched_inference) {
+    broker.reset(new InferenceBroker(net, settings.inference_max_batch, std::chrono::microseconds(settings.inference_max_wait_us), &learner.get_weights_mutex()));
+  }
+
+  std::thread learner_thread(&SelfPlayArena::run_learner, this);
+  std::vector<std::thread> tables;
+  for (int t = 0; t < settings.num_tables; t++) tables.push_back(std::thread(&SelfPlayArena::run_table, this, t));
+
+  auto last_report = std::chrono::steady_clock::now();
+  while (hands.load() < num_hands) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    auto now = std::chrono::steady_clock::now();
+    if (settings.report_seconds > 0 && std::chrono::duration<double>(now - last_report).count() >= settings.report_seconds) {
+      print_stats();
+      last_report = now;
+    }
+  }
+
+  stop = true;
+  for (size_t t = 0; t < tables.size(); t++) tables[t].join();
+  learner_thread.join();
+  print_stats();
+  broker.reset();
+} // end of run
+
+SelfPlayStats SelfPlayArena::get_stats() const
+{
+  SelfPlayStats stats;
+  stats.hands = hands.load();
+  LearnerStats learner_stats = learner.get_stats();
+  stats.trajectories = learner_stats.trajectories;
+  stats.updates = learner_stats.updates;
+  stats.baseline = learner_stats.baseline;
+  stats.stalls = stalls.load();
+  stats.queue_depth = queue.getSizeApprox();
+  stats.weights_version = learner.get_weights_version();
+  stats.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start_time).count();
+  stats.hands_per_second = stats.seconds > 0 ? stats.hands / stats.seconds : 0.0;
+  stats.inference_batches = broker ? broker->get_num_batches() : 0;
+  stats.inference_batch_size = stats.inference_batches > 0 ? (double)broker->get_num_requests() / stats.inference_batches : 0.0;
+  return stats;
+} // end of get_stats
+
+void SelfPlayArena::print_stats() const
+{
+  SelfPlayStats stats = get_stats();
+  std::cout << "[self-play] " << settings.num_tables << " tables, " << stats.hands << " hands, "
+            << stats.hands_per_second << " hands/s, queue " << stats.queue_depth << "/" << queue.getCapacity()
+            << ", " << stats.updates << " updates (" << stats.trajectories << " trajectories, baseline "
+            << stats.baseline << " bb), "
+            << stats.stalls << " stalls";
+  if (stats.inference_batches > 0) std::cout << ", " << stats.inference_batch_size << " decisions per forward pass";
+  std::cout << std::endl;
+} // end of print_stats
@@ -0,0 +1,75 @@
+#pragma once
+#include <torch/torch.h>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+#include <memory>
+#include "inference.h"
+#include "learner.h"
+#include "lockfreequeue.h"
+#include "poker_net.h"
+#include "trajectory.h"
+
+struct SelfPlaySettings {
+    int num_tables;        // games running at the same time, one worker thread each. 0 means one per cpu core, minus one for the learner
+    int players_per_table; // AIRL agents per table, all playing with the latest weights
+    int deals_per_game;    // a game is restarted with fresh stacks after this many deals
+    size_t queue_capacity; // finished deals that can wait for the learner, tables pause when it's full
+    double report_seconds; // how often run() prints the stats, 0 for never
+    uint64_t seed;         // seeds the shuffles of all tables, so every table deals different cards
+    bool batched_inference;     // if true the tables share one InferenceBroker, otherwise every table runs its own copy of the net
+    int inference_max_batch;    // see InferenceBroker
+    int inference_max_wait_us;
+
+    SelfPlaySettings();
+};
+
+struct SelfPlayStats {
+    long long hands;        // deals finished by all tables together
+    long long trajectories; // trajectories given to the learner
+    long long updates;      // learner updates done
+    float baseline;         // average reward per deal according to the learner, in big blinds
+    long long stalls;       // times a table had to wait because the queue was full
+    size_t queue_depth;     // trajectories currently waiting for the learner
+    int weights_version;    // increases with every optimizer step
+    long long inference_batches; // forward passes done by the InferenceBroker, if batched_inference
+    double inference_batch_size; // average decisions per forward pass
+    double seconds;         // since run() started
+    double hands_per_second;
+};
+
+/*
+Self-play with many tables at once. Every table is an independent Game with its own worker thread,
+Host and shuffle seed, played by AIRL agents. With batched_inference the agents of all tables share one
+InferenceBroker on the shared network, otherwise every table plays with a private copy of the network
+(so playing never waits for learning). Finished deals go as Trajectory into one lock-free queue, a single
+learner thread takes them out and gives them to the Learner, and runs its updates whenever it's ready.
+After every update the tables copy the new weights at the end of their current deal.
+*/
+class SelfPlayArena {
+public:
+    SelfPlayArena(Learner& learner, const SelfPlaySettings& settings = SelfPlaySettings());
+
+    void run(long long num_hands); // blocks until the tables together played num_hands deals
+    SelfPlayStats get_stats() const;
+    void print_stats() const;
+
+private:
+    void run_table(int table);
+    void run_learner();
+    void copy_weights(PokerNet& dst, int& version); // from the shared net, if it changed since version
+
+    Learner& learner;
+    PokerNet& net; // the net of the learner
+    SelfPlaySettings settings;
+
+    LockFreeQueue<Trajectory> queue;
+    std::unique_ptr<InferenceBroker> broker; // only during run() with batched_inference
+    std::atomic<bool> stop;
+
+    std::atomic<long long> hands;
+    std::atomic<long long> stalls;
+    std::chrono::steady_clock::time_point start_time;
+};
@@ -0,0 +1,115 @@
+/*
+OOPoker
+
+Copyright (c) 2010 Lode Vandevenne
+All rights reserved.
+
+This file is part of OOPoker.
+
+OOPoker is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+OOPoker is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with OOPoker.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <vector>
+
+/*
+Bounded queue between exactly one producer thread and one consumer thread, without locks. Cheaper than
+LockFreeQueue when there is only one thread on each side: each side only writes its own position and
+keeps a cached copy of the other side's, so it only reads the other side's cache line when the cached
+value says the queue is full or empty.
+
+The elements stay in the array: tryPush assigns over an old element, and the consumer uses front() in
+place before calling pop(). So elements that hold memory, like strings, keep it between laps around
+the array. The capacity is rounded up to a power of two.
+*/
+template<typename T>
+class SPSCQueue
+{
+  public:
+    SPSCQueue(size_t capacity, const T& initial = T()) //initial: value of the unused elements, for types without default constructor
+    : mask(roundCapacity(capacity) - 1)
+    , cells(mask + 1, initial)
+    , head(0)
+    , cachedTail(0)
+    , tail(0)
+    , cachedHead(0)
+    {
+    }
+
+    //producer only: copies value into the queue, returns false if it's full
+    bool tryPush(const T& value)
+    {
+      size_t pos = tail.load(std::memory_order_relaxed);
+      if(pos - cachedHead > mask)
+      {
+        cachedHead = head.load(std::memory_order_acquire);
+        if(pos - cachedHead > mask) return false; //full
+      }
+      cells[pos & mask] = value;
+      tail.store(pos + 1, std::memory_order_release);
+      return true;
+    }
+
+    //consumer only: the oldest element, or 0 if the queue is empty. Stays valid until pop.
+    T* front()
+    {
+      size_t pos = head.load(std::memory_order_relaxed);
+      if(pos == cachedTail)
+      {
+        cachedTail = tail.load(std::memory_order_acquire);
+        if(pos == cachedTail) return 0; //empty
+      }
+      return &cells[pos & mask];
+    }
+
+    //consumer only: removes the element returned by front, which must not be 0
+    void pop()
+    {
+      head.store(head.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    }
+
+    //amount of elements, only exact when the other side isn't busy at the same time
+    size_t getSizeApprox() const
+    {
+      return tail.load(std::memory_order_relaxed) - head.load(std::memory_order_relaxed);
+    }
+
+    size_t getCapacity() const
+    {
+      return mask + 1;
+    }
+
+  private:
+    SPSCQueue(const SPSCQueue&); //not copyable
+    SPSCQueue& operator=(const SPSCQueue&);
+
+    static size_t roundCapacity(size_t capacity)
+    {
+      size_t result = 2;
+      while(result < capacity) result *= 2;
+      return result;
+    }
+
+    const size_t mask;
+    std::vector<T> cells;
+    //consumer side and producer side on separate cache lines
+    alignas(64) std::atomic<size_t> head; //next element to read
+    size_t cachedTail;
+    alignas(64) std::atomic<size_t> tail; //next element to write
+    size_t cachedHead;
+};
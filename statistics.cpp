@@ -22,6 +22,9 @@ along with OOPoker.  If not, see <http://www.gnu.org/licenses/>.
 
 #include "statistics.h"
 
+#include "nametable.h"
+
+#include <algorithm>
 #include <sstream>
 
 double PlayerStats::getVPIP () const
@@ -142,49 +145,156 @@ TableStats::TableStats()
 }
 
 
-StatKeeper::MyPlayerInfo::MyPlayerInfo(const std::string& name)
+//flags of StatKeeper::DealRecord
+enum
+{
+  DEAL_VPIP = 1, //voluntarily put money in the pot pre-flop
+  DEAL_PFR = 2, //bet or raised pre-flop
+  DEAL_FLOP = 4, //saw the flop
+  DEAL_SHOWDOWN = 8 //went to showdown
+};
+
+//the sums kept per window (StatKeeper::MyPlayerInfo::windowSums)
+enum
+{
+  WINDOW_VPIP,
+  WINDOW_PFR,
+  WINDOW_FLOPS,
+  WINDOW_SHOWDOWNS,
+  WINDOW_AGGRESSIVE,
+  WINDOW_PASSIVE,
+  NUM_WINDOW_VALUES
+};
+
+static_assert(NUM_WINDOW_VALUES == 6, "size of windowSums in statistics.h");
+
+static void getWindowValues(int values[NUM_WINDOW_VALUES], unsigned char flags, int aggressive, int passive)
+{
+  values[WINDOW_VPIP] = (flags & DEAL_VPIP) ? 1 : 0;
+  values[WINDOW_PFR] = (flags & DEAL_PFR) ? 1 : 0;
+  values[WINDOW_FLOPS] = (flags & DEAL_FLOP) ? 1 : 0;
+  values[WINDOW_SHOWDOWNS] = (flags & DEAL_SHOWDOWN) ? 1 : 0;
+  values[WINDOW_AGGRESSIVE] = aggressive;
+  values[WINDOW_PASSIVE] = passive;
+}
+
+StatKeeper::MyPlayerInfo::MyPlayerInfo(const std::string& name, int id)
 : stats(name)
+, id(id)
 , stack(0)
 , wager(0)
+, joined(false)
+, folded(false)
+, deal_stat(0)
+, deal_preflop_stat(0)
+, historyPos(0)
+, historySize(0)
 {
+  deal.flags = deal.aggressive = deal.passive = 0;
+  for(int w = 0; w < NUM_STAT_WINDOWS; w++)
+  for(int i = 0; i < NUM_WINDOW_VALUES; i++)
+  {
+    windowSums[w][i] = 0;
+  }
 }
 
 StatKeeper::StatKeeper()
 : round(R_PRE_FLOP)
+, highestBet(0)
 {
 }
 
-StatKeeper::~StatKeeper()
+void StatKeeper::getAllPlayers(std::vector<std::string>& players) const
 {
-  for(std::map<std::string, MyPlayerInfo*>::iterator it = statmap.begin(); it != statmap.end(); ++it)
+  size_t begin = players.size();
+  for(size_t i = 0; i < this->players.size(); i++)
   {
-    delete it->second;
+    players.push_back(this->players[i].stats.name);
   }
+  std::sort(players.begin() + begin, players.end()); //the players are kept in join order
 }
 
-void StatKeeper::getAllPlayers(std::vector<std::string>& players) const
+StatKeeper::MyPlayerInfo* StatKeeper::getPlayerStatsInternal(int id)
 {
-  for(std::map<std::string, MyPlayerInfo*>::const_iterator it = statmap.begin(); it != statmap.end(); ++it)
+  if(id >= (int)slots.size()) slots.resize(id + 1, -1);
+
+  if(slots[id] < 0)
   {
-    players.push_back(it->first);
+    slots[id] = (int)players.size();
+    players.push_back(MyPlayerInfo(getInternedName(id), id));
   }
+
+  return &players[slots[id]];
+}
+
+const StatKeeper::MyPlayerInfo* StatKeeper::findPlayer(int id) const
+{
+  if(id < 0 || id >= (int)slots.size() || slots[id] < 0) return 0;
+  return &players[slots[id]];
 }
 
-StatKeeper::MyPlayerInfo* StatKeeper::getPlayerStatsInternal(const std::string& player)
+void StatKeeper::endDeal()
 {
-  if(statmap.find(player) == statmap.end())
+  int numActive = 0; //players who didn't fold, if more than one the deal goes to showdown
+  for(size_t i = 0; i < dealt.size(); i++)
   {
-    statmap[player] = new MyPlayerInfo(player);
+    if(!players[dealt[i]].folded) numActive++;
   }
 
-  return statmap[player];
+  for(size_t i = 0; i < dealt.size(); i++)
+  {
+    MyPlayerInfo* p = &players[dealt[i]];
+    if(!p->joined) continue;
+
+    int d = p->deal_stat;
+    if(d == 0) p->stats.deal_first_action_folds++;
+    else if(d == 1) p->stats.deal_checks++;
+    else if(d == 2) p->stats.deal_calls++;
+    else if(d == 3) p->stats.deal_bets++;
+    else if(d == 4) p->stats.deal_raises++;
+
+    d = p->deal_preflop_stat;
+    if(d == 0) p->stats.deal_preflop_first_action_folds++;
+    else if(d == 1) p->stats.deal_preflop_checks++;
+    else if(d == 2) p->stats.deal_preflop_calls++;
+    else if(d == 3) p->stats.deal_preflop_bets++;
+    else if(d == 4) p->stats.deal_preflop_raises++;
+
+    DealRecord& deal = p->deal;
+    if(p->deal_preflop_stat >= 2) deal.flags |= DEAL_VPIP;
+    if(p->deal_preflop_stat >= 3) deal.flags |= DEAL_PFR;
+    if(!p->folded && numActive > 1) deal.flags |= DEAL_SHOWDOWN;
+
+    //add the deal to every window, and remove the deal that falls out of it
+    int values[NUM_WINDOW_VALUES];
+    getWindowValues(values, deal.flags, deal.aggressive, deal.passive);
+    for(int w = 0; w < NUM_STAT_WINDOWS; w++)
+    {
+      int* sums = p->windowSums[w];
+      for(int j = 0; j < NUM_WINDOW_VALUES; j++) sums[j] += values[j];
+      if(p->historySize >= STAT_WINDOWS[w])
+      {
+        const DealRecord& old = p->history[(p->historyPos - STAT_WINDOWS[w] + STAT_WINDOW_MAX) % STAT_WINDOW_MAX];
+        int oldValues[NUM_WINDOW_VALUES];
+        getWindowValues(oldValues, old.flags, old.aggressive, old.passive);
+        for(int j = 0; j < NUM_WINDOW_VALUES; j++) sums[j] -= oldValues[j];
+      }
+    }
+    p->history[p->historyPos] = deal;
+    p->historyPos = (p->historyPos + 1) % STAT_WINDOW_MAX;
+    if(p->historySize < STAT_WINDOW_MAX) p->historySize++;
+  }
 }
 
 void StatKeeper::onEvent(const Event& event)
 {
   MyPlayerInfo* info = 0;
-  if(!event.player.empty()) info = getPlayerStatsInternal(event.player);
-  PlayerStats* stats = &info->stats;
+  PlayerStats* stats = 0;
+  if(event.playerId >= 0)
+  {
+    info = getPlayerStatsInternal(event.playerId);
+    stats = &info->stats;
+  }
 
   int* round_folds = 0;
   int* round_checks = 0;
@@ -193,7 +303,11 @@ void StatKeeper::onEvent(const Event& event)
   int* round_raises = 0;
   int* round_allins = 0;
   int* round_actions = 0;
-  if(round == R_PRE_FLOP)
+  if(!stats)
+  {
+    //no player related to this event
+  }
+  else if(round == R_PRE_FLOP)
   {
     round_folds = &stats->preflop_folds;
     round_checks = &stats->preflop_checks;
@@ -240,18 +354,29 @@ void StatKeeper::onEvent(const Event& event)
   {
     case E_QUIT:
     {
+      if(!info) break;
       info->joined = false;
+      int index = slots[info->id];
+      for(size_t i = 0; i < seated.size(); i++)
+      {
+        if(seated[i] == index) { seated.erase(seated.begin() + i); break; }
+      }
+      tableStats.quits++;
       break;
     }
     case E_JOIN:
     {
+      if(!info) break;
+      if(!info->joined) seated.push_back(slots[info->id]);
       info->joined = true;
       stats->chips_bought += event.chips;
       info->stack += event.chips;
+      tableStats.joins++;
       break;
     }
     case E_REBUY:
     {
+      if(!info) break;
       stats->chips_bought += event.chips;
       info->stack += event.chips;
       break;
@@ -260,50 +385,31 @@ void StatKeeper::onEvent(const Event& event)
     {
       round = R_PRE_FLOP;
       highestBet = 0;
+      tableStats.deals++;
 
-      for(std::map<std::string, MyPlayerInfo*>::iterator it = statmap.begin(); it != statmap.end(); ++it)
+      dealt = seated; //a deal that never got its E_POT_DIVISION (the game stopped) isn't counted
+      for(size_t i = 0; i < dealt.size(); i++)
       {
-        MyPlayerInfo* p = it->second;
+        MyPlayerInfo* p = &players[dealt[i]];
         p->wager = 0;
         p->folded = false;
         p->deal_stat = 0;
         p->deal_preflop_stat = 0;
-        if(p->joined)
-        {
-          p->stats.deals++;
-        }
+        p->deal.flags = p->deal.aggressive = p->deal.passive = 0;
+        p->stats.deals++;
       }
 
       break;
     }
     case E_POT_DIVISION:
     {
-      for(std::map<std::string, MyPlayerInfo*>::iterator it = statmap.begin(); it != statmap.end(); ++it)
-      {
-        MyPlayerInfo* p = it->second;
-        if(p->joined)
-        {
-          int d = p->deal_stat;
-          if(d == 0) p->stats.deal_first_action_folds++;
-          else if(d == 1) p->stats.deal_checks++;
-          else if(d == 2) p->stats.deal_calls++;
-          else if(d == 3) p->stats.deal_bets++;
-          else if(d == 4) p->stats.deal_raises++;
-
-          d = p->deal_preflop_stat;
-          if(d == 0) p->stats.deal_preflop_first_action_folds++;
-          else if(d == 1) p->stats.deal_preflop_checks++;
-          else if(d == 2) p->stats.deal_preflop_calls++;
-          else if(d == 3) p->stats.deal_preflop_bets++;
-          else if(d == 4) p->stats.deal_preflop_raises++;
-        }
-      }
-
+      endDeal();
       break;
     }
-    case E_REVEAL_AI: stats->ai = event.ai; break; //this is the only event we can finally read the ai from!
+    case E_REVEAL_AI: if(stats) stats->ai = event.ai; break; //this is the only event we can finally read the ai from!
     case E_SMALL_BLIND:
     {
+      if(!info) break;
       stats->forced_bets += event.chips;
       highestBet = event.chips;
       numchips_placed = event.chips;
@@ -311,6 +417,7 @@ void StatKeeper::onEvent(const Event& event)
     }
     case E_BIG_BLIND:
     {
+      if(!info) break;
       stats->forced_bets += event.chips;
       if(event.chips > highestBet) highestBet = event.chips; //it could be that the player is all-in and has less chips
       numchips_placed = event.chips;
@@ -318,6 +425,7 @@ void StatKeeper::onEvent(const Event& event)
     }
     case E_ANTE:
     {
+      if(!info) break;
       stats->forced_bets += event.chips;
       if(event.chips > highestBet) highestBet = event.chips; //happens e.g. if ante is bigger than the stack of the small blind and the big blind when they're both all-in
       numchips_placed = event.chips;
@@ -326,19 +434,23 @@ void StatKeeper::onEvent(const Event& event)
     case E_FLOP:
     {
       round = R_FLOP;
-      for(std::map<std::string, MyPlayerInfo*>::iterator it = statmap.begin(); it != statmap.end(); ++it)
+      tableStats.flops_seen++;
+      for(size_t i = 0; i < dealt.size(); i++)
       {
-        MyPlayerInfo* p = it->second;
-        if(!p->folded) p->stats.flops_seen++;
+        MyPlayerInfo* p = &players[dealt[i]];
+        if(p->folded) continue;
+        p->stats.flops_seen++;
+        p->deal.flags |= DEAL_FLOP;
       }
       break;
     }
     case E_TURN:
     {
       round = R_TURN;
-      for(std::map<std::string, MyPlayerInfo*>::iterator it = statmap.begin(); it != statmap.end(); ++it)
+      tableStats.turns_seen++;
+      for(size_t i = 0; i < dealt.size(); i++)
       {
-        MyPlayerInfo* p = it->second;
+        MyPlayerInfo* p = &players[dealt[i]];
         if(!p->folded) p->stats.turns_seen++;
       }
       break;
@@ -346,9 +458,10 @@ void StatKeeper::onEvent(const Event& event)
     case E_RIVER:
     {
       round = R_RIVER;
-      for(std::map<std::string, MyPlayerInfo*>::iterator it = statmap.begin(); it != statmap.end(); ++it)
+      tableStats.rivers_seen++;
+      for(size_t i = 0; i < dealt.size(); i++)
       {
-        MyPlayerInfo* p = it->second;
+        MyPlayerInfo* p = &players[dealt[i]];
         if(!p->folded) p->stats.rivers_seen++;
       }
       break;
@@ -356,15 +469,16 @@ void StatKeeper::onEvent(const Event& event)
     case E_SHOWDOWN:
     {
       round = R_SHOWDOWN;
-      for(std::map<std::string, MyPlayerInfo*>::iterator it = statmap.begin(); it != statmap.end(); ++it)
+      for(size_t i = 0; i < dealt.size(); i++)
       {
-        MyPlayerInfo* p = it->second;
+        MyPlayerInfo* p = &players[dealt[i]];
         if(!p->folded) p->stats.showdowns_seen++;
       }
       break;
     }
     case E_FOLD:
     {
+      if(!info) break;
       info->folded = true;
       stats->folds++;
       (*round_folds)++;
@@ -374,6 +488,7 @@ void StatKeeper::onEvent(const Event& event)
     };
     case E_CHECK:
     {
+      if(!info) break;
       stats->checks++;
       (*round_checks)++;
       stats->actions++;
@@ -384,12 +499,14 @@ void StatKeeper::onEvent(const Event& event)
     };
     case E_CALL:
     {
+      if(!info) break;
       stats->calls++;
       (*round_calls)++;
       stats->actions++;
       (*round_actions)++;
       if(info->deal_stat < 2) info->deal_stat = 2;
       if(round == R_PRE_FLOP && info->deal_preflop_stat < 2) info->deal_preflop_stat = 2;
+      if(round != R_PRE_FLOP && info->deal.passive < 255) info->deal.passive++;
 
       numchips_placed = highestBet - info->wager;
 
@@ -397,6 +514,7 @@ void StatKeeper::onEvent(const Event& event)
     }
     case E_RAISE:
     {
+      if(!info) break;
       int callAmount = highestBet - info->wager;
 
       if(callAmount == 0) //bet
@@ -413,6 +531,7 @@ void StatKeeper::onEvent(const Event& event)
         if(info->deal_stat < 4) info->deal_stat = 4;
       if(round == R_PRE_FLOP && info->deal_preflop_stat < 4) info->deal_preflop_stat = 4;
       }
+      if(round != R_PRE_FLOP && info->deal.aggressive < 255) info->deal.aggressive++;
 
       stats->actions++;
       (*round_actions)++;
@@ -425,11 +544,13 @@ void StatKeeper::onEvent(const Event& event)
     }
     case E_WIN:
     {
+      if(!info) break;
       stats->chips_won += event.chips;
       info->stack += event.chips;
       stats->wins_total++;
       if(round == R_SHOWDOWN) stats->wins_showdown++;
       else stats->wins_bluff++;
+      break;
     }
     default: break;
   }
@@ -450,13 +571,70 @@ void StatKeeper::onEvent(const Event& event)
 
 const PlayerStats* StatKeeper::getPlayerStats(const std::string& player) const
 {
-  std::map<std::string, MyPlayerInfo*>::const_iterator it = statmap.find(player);
+  return getPlayerStats(findInternedName(player));
+}
 
-  if(it == statmap.end()) return 0;
-  else return &statmap.find(player)->second->stats;
+const PlayerStats* StatKeeper::getPlayerStats(int id) const
+{
+  const MyPlayerInfo* p = findPlayer(id);
+  return p ? &p->stats : 0;
 }
 
 const TableStats* StatKeeper::getTableStats() const
 {
   return &tableStats;
 }
+
+bool StatKeeper::getWindowStats(WindowStats& stats, int id, int window) const
+{
+  stats.deals = 0;
+  stats.vpip = stats.pfr = stats.af = stats.wsd = 0.0;
+
+  const MyPlayerInfo* p = findPlayer(id);
+  if(!p || window < 0 || window >= NUM_STAT_WINDOWS) return false;
+
+  const int* sums = p->windowSums[window];
+  stats.deals = p->historySize < STAT_WINDOWS[window] ? p->historySize : STAT_WINDOWS[window];
+  if(stats.deals > 0)
+  {
+    stats.vpip = (double)sums[WINDOW_VPIP] / (double)stats.deals;
+    stats.pfr = (double)sums[WINDOW_PFR] / (double)stats.deals;
+  }
+  if(sums[WINDOW_PASSIVE] > 0) stats.af = (double)sums[WINDOW_AGGRESSIVE] / (double)sums[WINDOW_PASSIVE];
+  else stats.af = (double)sums[WINDOW_AGGRESSIVE];
+  if(sums[WINDOW_FLOPS] > 0) stats.wsd = (double)sums[WINDOW_SHOWDOWNS] / (double)sums[WINDOW_FLOPS];
+
+  return true;
+}
+
+bool StatKeeper::getWindowStats(WindowStats& stats, const std::string& player, int window) const
+{
+  return getWindowStats(stats, findInternedName(player), window);
+}
+
+void StatKeeper::getSnapshot(float* out, int id) const
+{
+  for(int i = 0; i < STAT_SNAPSHOT_SIZE; i++) out[i] = 0.0f;
+
+  WindowStats w10, w30, w100;
+  if(!getWindowStats(w10, id, 0)) return;
+  getWindowStats(w30, id, 1);
+  getWindowStats(w100, id, 3);
+
+  out[0] = (float)w10.vpip;
+  out[1] = (float)w30.vpip;
+  out[2] = (float)w100.vpip;
+  out[3] = (float)w10.pfr;
+  out[4] = (float)w30.pfr;
+  out[5] = (float)w100.pfr;
+  out[6] = (float)(w30.af / (1.0 + w30.af));
+  out[7] = (float)(w100.af / (1.0 + w100.af));
+  out[8] = (float)w100.wsd;
+  out[9] = (float)w100.deals / (float)STAT_WINDOW_MAX;
+}
+
+void StatKeeper::getSnapshot(std::vector<float>& out, int id) const
+{
+  out.resize(STAT_SNAPSHOT_SIZE);
+  getSnapshot(&out[0], id);
+}
@@ -25,8 +25,9 @@ along with OOPoker.  If not, see <http://www.gnu.org/licenses/>.
 #include "event.h"
 #include "game.h"
 
-#include <map>
+#include <deque>
 #include <string>
+#include <vector>
 
 //WARNING: all percentages are given as values in range 0.0-1.0, NOT values in range 0-100! So 1.0 means 100%.
 
@@ -174,26 +175,80 @@ struct TableStats
   //todo: stats about the playing style at this table
 };
 
+/*
+Windowed stats: the same statistics as PlayerStats, but only over the last deals a player played, to
+follow opponents that change their style. They're kept for windows of 10, 30, 50 and 100 deals
+(STAT_WINDOWS). If the player played fewer deals than the size of a window, the window has only those.
+*/
+const int NUM_STAT_WINDOWS = 4;
+const int STAT_WINDOWS[NUM_STAT_WINDOWS] = { 10, 30, 50, 100 };
+const int STAT_WINDOW_MAX = 100; //the largest window, this many deals are remembered per player
+
+struct WindowStats
+{
+  int deals; //deals in the window
+  double vpip; //as getVPIP of PlayerStats
+  double pfr; //as getPFR of PlayerStats
+  double af; //as getAF of PlayerStats, but if there were no post-flop calls it's the amount of bets and raises instead of infinite
+  double wsd; //as getWSD of PlayerStats
+};
+
+/*
+Size and layout of getSnapshot, made for the opponent context input of the network (PokerNet):
+0-2: VP$IP over the windows of 10, 30 and 100 deals
+3-5: PFR over the windows of 10, 30 and 100 deals
+6-7: AF over the windows of 30 and 100 deals, as af / (1 + af) to keep it in range 0.0-1.0
+8: WSD over the window of 100 deals
+9: how full the window of 100 deals is (0.0-1.0), so that "unknown" differs from "never plays"
+*/
+const int STAT_SNAPSHOT_SIZE = 10;
+
+/*
+Calculates statistics of all players from the events of a game.
+
+Players are addressed by the id of their name in the name table (nametable.h), which is also the playerId
+of the events, so handling an event doesn't look up strings. Per deal only the players sitting at the
+table are visited, no matter how many players came and went before.
+*/
 class StatKeeper
 {
   protected:
 
+    struct DealRecord //what a player did in one deal, for the windowed stats
+    {
+      unsigned char flags; //combination of the DEAL_ flags in statistics.cpp
+      unsigned char aggressive; //post-flop bets and raises
+      unsigned char passive; //post-flop calls
+    };
+
     struct MyPlayerInfo
     {
-      MyPlayerInfo(const std::string& player);
+      MyPlayerInfo(const std::string& player, int id);
 
       PlayerStats stats;
+      int id; //id of the name in the name table
       int stack; //stack kept track of through events
       int wager; //wager kept track of through events (bet = how much player moved in pot during this deal)
       bool joined; //false if the player quits
       bool folded; //folded during this deal
       int deal_stat; //0: first action fold / uninited, 1: check, 2: call, 3: bet, 4: raise. Used for tracking the "deal_###" stats.
       int deal_preflop_stat; //0: first action fold / uninited, 1: check, 2: call, 3: bet, 4: raise. Used for tracking the "deal_preflop_###" stats.
+      DealRecord deal; //the current deal, goes into history when the deal is done
+
+      DealRecord history[STAT_WINDOW_MAX]; //ring buffer with the last deals
+      int historyPos; //where the next deal goes in history
+      int historySize;
+      int windowSums[NUM_STAT_WINDOWS][6]; //per window the sums of the WINDOW_ values of statistics.cpp, kept up to date per deal
     };
 
-    std::map<std::string, MyPlayerInfo*> statmap;
+    std::deque<MyPlayerInfo> players; //in order of appearance. A deque, so that the stats pointers given out stay valid.
+    std::vector<int> slots; //index in players per name id, -1 if the name didn't appear yet
+    std::vector<int> seated; //indices in players of the players who joined and didn't quit
+    std::vector<int> dealt; //indices in players of the players who were dealt in the current deal
 
-    MyPlayerInfo* getPlayerStatsInternal(const std::string& player); //this adds it to the std::map if needed
+    MyPlayerInfo* getPlayerStatsInternal(int id); //this adds the player if needed
+    const MyPlayerInfo* findPlayer(int id) const; //returns null if the player didn't appear yet
+    void endDeal(); //updates the deal stats and the windows of the dealt players
     TableStats tableStats;
 
     Round round; //round deduced from the events
@@ -203,13 +258,21 @@ class StatKeeper
   public:
 
     StatKeeper();
-    ~StatKeeper();
 
     void onEvent(const Event& event);
 
     const PlayerStats* getPlayerStats(const std::string& player) const; //returns null if no stats for that player are available
+    const PlayerStats* getPlayerStats(int id) const; //by id in the name table, e.g. the playerId of an event. Returns null if no stats for that player are available.
     const TableStats* getTableStats() const;
-    void getAllPlayers(std::vector<std::string>& players) const;
+    void getAllPlayers(std::vector<std::string>& players) const; //adds the names of all players to players, sorted by name
+
+    //window is an index in STAT_WINDOWS. Returns false, with everything 0, if no stats for that player are available.
+    bool getWindowStats(WindowStats& stats, int id, int window) const;
+    bool getWindowStats(WindowStats& stats, const std::string& player, int window) const;
+
+    //fills in STAT_SNAPSHOT_SIZE values, all 0 for unknown players. The vector version resizes the vector.
+    void getSnapshot(float* out, int id) const;
+    void getSnapshot(std::vector<float>& out, int id) const;
 };
 
 std::string statisticsToString(const PlayerStats& stats);
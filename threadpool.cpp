@@ -0,0 +1,125 @@
+/*
+OOPoker
+
+Copyright (c) 2010 Lode Vandevenne
+All rights reserved.
+
+This file is part of OOPoker.
+
+OOPoker is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+OOPoker is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with OOPoker.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include "threadpool.h"
+
+#include <algorithm>
+
+ThreadPool::ThreadPool(int numThreads)
+: quit(false)
+{
+  if(numThreads <= 0) numThreads = (int)std::thread::hardware_concurrency();
+  if(numThreads <= 0) numThreads = 1;
+
+  for(int i = 1; i < numThreads; i++) threads.push_back(std::thread(&ThreadPool::work, this));
+}
+
+ThreadPool::~ThreadPool()
+{
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    quit = true;
+  }
+  wake.notify_all();
+  for(size_t i = 0; i < threads.size(); i++) threads[i].join();
+}
+
+int ThreadPool::getNumThreads() const
+{
+  return (int)threads.size() + 1;
+}
+
+void ThreadPool::takeTask(Job* job, int& index)
+{
+  index = job->next++;
+  if(job->next == job->numTasks) jobs.erase(std::find(jobs.begin(), jobs.end(), job));
+}
+
+void ThreadPool::work()
+{
+  std::unique_lock<std::mutex> lock(mutex);
+  for(;;)
+  {
+    wake.wait(lock, [this]() { return quit || !jobs.empty(); });
+    if(quit) return;
+
+    Job* job = jobs.front();
+    int index;
+    takeTask(job, index);
+
+    lock.unlock();
+    (*job->task)(index);
+    lock.lock();
+
+    if(++job->done == job->numTasks) finished.notify_all();
+  }
+}
+
+void ThreadPool::run(int numTasks, const std::function<void(int)>& task)
+{
+  if(numTasks <= 0) return;
+
+  Job job;
+  job.task = &task;
+  job.numTasks = numTasks;
+  job.next = 0;
+  job.done = 0;
+
+  std::unique_lock<std::mutex> lock(mutex);
+  jobs.push_back(&job);
+  if(numTasks > 1) wake.notify_all();
+
+  while(job.next < job.numTasks)
+  {
+    int index;
+    takeTask(&job, index);
+
+    lock.unlock();
+    try
+    {
+      task(index);
+    }
+    catch(...)
+    {
+      //give out no more tasks of the job, and wait for the started ones before the job leaves the stack
+      lock.lock();
+      if(job.next < job.numTasks) jobs.erase(std::find(jobs.begin(), jobs.end(), &job));
+      job.numTasks = job.next;
+      job.done++;
+      finished.wait(lock, [&job]() { return job.done == job.numTasks; });
+      throw;
+    }
+    lock.lock();
+
+    job.done++;
+  }
+
+  //the job is on the stack, so wait until the workers are done with their tasks of it
+  finished.wait(lock, [&job]() { return job.done == job.numTasks; });
+}
+
+ThreadPool& getThreadPool()
+{
+  static ThreadPool pool;
+  return pool;
+}
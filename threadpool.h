@@ -0,0 +1,77 @@
+/*
+OOPoker
+
+Copyright (c) 2010 Lode Vandevenne
+All rights reserved.
+
+This file is part of OOPoker.
+
+OOPoker is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+OOPoker is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with OOPoker.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/*
+A fixed set of worker threads for running work in parallel, such as the chunks of a big Monte Carlo
+simulation. Starting threads for every simulation would cost more than many small simulations take.
+
+run blocks until all tasks are done. The thread that calls run works on the tasks too, so calling run
+from inside a task (or from several threads at once) is fine, it can't wait forever for busy workers.
+*/
+class ThreadPool
+{
+  public:
+    ThreadPool(int numThreads = 0); //numThreads includes the thread calling run. 0 means one per CPU core.
+    ~ThreadPool();
+
+    int getNumThreads() const;
+
+    /*
+    Calls task(0) to task(numTasks - 1) in parallel. If a task that runs on the calling thread throws, the
+    tasks that didn't start yet are skipped, and the exception is rethrown once the started ones are done.
+    */
+    void run(int numTasks, const std::function<void(int)>& task);
+
+  private:
+    ThreadPool(const ThreadPool&); //not copyable
+    ThreadPool& operator=(const ThreadPool&);
+
+    struct Job
+    {
+      const std::function<void(int)>* task;
+      int numTasks;
+      int next; //next task to give out
+      int done; //amount of finished tasks
+    };
+
+    void work();
+    void takeTask(Job* job, int& index); //call with the mutex locked
+
+    std::vector<std::thread> threads;
+    std::mutex mutex;
+    std::condition_variable wake; //there are new jobs, or quit
+    std::condition_variable finished; //a job is done
+    std::deque<Job*> jobs; //jobs of which not all tasks are given out yet
+    bool quit;
+};
+
+ThreadPool& getThreadPool(); //a pool with one thread per CPU core, shared by the whole program
@@ -97,7 +97,7 @@ void runConsolePotEquityCalculator()
   }
   else
   {
-    std::cout << "Pot Equity: " << getPotEquity(holeCards, boardCards, numPlayers - 1) << std::endl;
+    std::cout << "Pot Equity: " << getPotEquityParallel(holeCards, boardCards, numPlayers - 1) << std::endl;
   }
 }
 
@@ -141,7 +141,7 @@ void runConsoleShowdownCalculator()
   }
   
   std::vector<double> win, tie, lose;
-  if(!getWinChanceWithKnownHands(win, tie, lose, holeCards1, holeCards2, boardCards))
+  if(!getWinChanceWithKnownHandsParallel(win, tie, lose, holeCards1, holeCards2, boardCards))
   {
     std::cout << "invalid board cards were entered, no calculation could be done" << std::endl;
   }
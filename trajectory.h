@@ -0,0 +1,48 @@
+/*
+OOPoker
+
+Copyright (c) 2010 Lode Vandevenne
+All rights reserved.
+
+This file is part of OOPoker.
+
+OOPoker is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+OOPoker is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with OOPoker.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#pragma once
+
+#include <vector>
+
+/*
+What an RL agent saw and did during one deal, in plain floats so it can be passed between threads and
+stored without needing libtorch. The learner turns it back into tensors.
+*/
+struct TrajectoryStep
+{
+  std::vector<float> state; //the features of TensorConverter::infoToTensor at this decision
+  std::vector<float> history; //3 floats per action of the deal before this decision (see AIRL::history_to_tensor)
+  float mean[2]; //output vector of the network, before the exploration noise
+  float action[2]; //the vector that was actually played (mean + noise)
+};
+
+struct Trajectory
+{
+  std::vector<TrajectoryStep> steps;
+  float reward; //chips won minus chips put in the pot during the deal, in big blinds
+  int weightsVersion; //version of the network weights that played this deal, to know how stale it is
+  int table; //which self-play table it comes from
+
+  Trajectory() : reward(0.0f), weightsVersion(0), table(0) {}
+};
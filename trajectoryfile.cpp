@@ -0,0 +1,305 @@
+/*
+OOPoker
+
+Copyright (c) 2010 Lode Vandevenne
+All rights reserved.
+
+This file is part of OOPoker.
+
+OOPoker is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+OOPoker is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with OOPoker.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include "trajectoryfile.h"
+
+#include <cstring>
+
+static const unsigned TRAJECTORY_FILE_VERSION = 1;
+
+struct TrajectoryChunkHeader
+{
+  char magic[4]; //"OOTJ"
+  unsigned version;
+  unsigned numTrajectories;
+  unsigned numSteps;
+  unsigned numHistory;
+  unsigned stateSize;
+  unsigned checksum;
+  unsigned padding;
+};
+
+//size in bytes of a chunk without its header
+static size_t getChunkPayloadSize(size_t numTrajectories, size_t numSteps, size_t numHistory, size_t stateSize)
+{
+  return 4 * (numTrajectories * 4 + 1 + numSteps * (stateSize + 5) + 1 + numHistory);
+}
+
+TrajectoryWriter::TrajectoryWriter()
+: file(0)
+, chunkSize(1024)
+, stateSize(-1)
+{
+}
+
+TrajectoryWriter::~TrajectoryWriter()
+{
+  close();
+}
+
+bool TrajectoryWriter::open(const std::string& filename)
+{
+  close();
+  std::lock_guard<std::mutex> lock(mutex);
+  file = fopen(filename.c_str(), "ab");
+  return file != 0;
+}
+
+void TrajectoryWriter::close()
+{
+  std::lock_guard<std::mutex> lock(mutex);
+  if(!file) return;
+  flushLocked();
+  fclose(file);
+  file = 0;
+}
+
+bool TrajectoryWriter::isOpen() const
+{
+  return file != 0;
+}
+
+void TrajectoryWriter::setChunkSize(size_t trajectories)
+{
+  std::lock_guard<std::mutex> lock(mutex);
+  chunkSize = trajectories < 1 ? 1 : trajectories;
+}
+
+bool TrajectoryWriter::add(const Trajectory& trajectory)
+{
+  std::lock_guard<std::mutex> lock(mutex);
+  if(!file) return false;
+
+  if(!trajectory.steps.empty())
+  {
+    int size = (int)trajectory.steps[0].state.size();
+    //all states of a chunk have the same size, start a new chunk if it changes (a different network input)
+    if(stateSize >= 0 && size != stateSize && !flushLocked()) return false;
+    stateSize = size;
+  }
+
+  if(stepOffsets.empty()) stepOffsets.push_back(0);
+  if(historyOffsets.empty()) historyOffsets.push_back(0);
+
+  rewards.push_back(trajectory.reward);
+  versions.push_back(trajectory.weightsVersion);
+  tables.push_back(trajectory.table);
+  for(size_t i = 0; i < trajectory.steps.size(); i++)
+  {
+    const TrajectoryStep& step = trajectory.steps[i];
+    states.insert(states.end(), step.state.begin(), step.state.end());
+    states.resize(historyOffsets.size() * (size_t)stateSize, 0.0f); //in case a state has the wrong size
+    means.insert(means.end(), step.mean, step.mean + 2);
+    actions.insert(actions.end(), step.action, step.action + 2);
+    histories.insert(histories.end(), step.history.begin(), step.history.end());
+    historyOffsets.push_back((unsigned)histories.size());
+  }
+  stepOffsets.push_back((unsigned)(historyOffsets.size() - 1));
+
+  if(rewards.size() >= chunkSize) return flushLocked();
+  return true;
+}
+
+bool TrajectoryWriter::flush()
+{
+  std::lock_guard<std::mutex> lock(mutex);
+  return flushLocked();
+}
+
+template<typename T>
+static void appendColumn(std::vector<unsigned char>& data, const std::vector<T>& column)
+{
+  if(column.empty()) return;
+  const unsigned char* bytes = (const unsigned char*)&column[0];
+  data.insert(data.end(), bytes, bytes + column.size() * sizeof(T));
+}
+
+bool TrajectoryWriter::flushLocked()
+{
+  if(!file) return false;
+  if(rewards.empty()) return true;
+
+  TrajectoryChunkHeader header;
+  std::memcpy(header.magic, "OOTJ", 4);
+  header.version = TRAJECTORY_FILE_VERSION;
+  header.numTrajectories = (unsigned)rewards.size();
+  header.numSteps = (unsigned)(historyOffsets.size() - 1);
+  header.numHistory = (unsigned)histories.size();
+  header.stateSize = stateSize < 0 ? 0 : (unsigned)stateSize;
+  header.padding = 0;
+
+  std::vector<unsigned char> data;
+  data.reserve(getChunkPayloadSize(header.numTrajectories, header.numSteps, header.numHistory, header.stateSize));
+  appendColumn(data, rewards);
+  appendColumn(data, versions);
+  appendColumn(data, tables);
+  appendColumn(data, stepOffsets);
+  appendColumn(data, states);
+  appendColumn(data, means);
+  appendColumn(data, actions);
+  appendColumn(data, historyOffsets);
+  appendColumn(data, histories);
+  header.checksum = getDataChecksum(data.empty() ? 0 : &data[0], data.size());
+
+  bool success = fwrite(&header, sizeof(header), 1, file) == 1;
+  success = success && (data.empty() || fwrite(&data[0], 1, data.size(), file) == data.size());
+  success = success && fflush(file) == 0;
+
+  stateSize = -1;
+  rewards.clear();
+  versions.clear();
+  tables.clear();
+  stepOffsets.clear();
+  states.clear();
+  means.clear();
+  actions.clear();
+  historyOffsets.clear();
+  histories.clear();
+
+  return success;
+}
+
+TrajectoryFile::TrajectoryFile()
+: numTrajectories(0)
+, numSteps(0)
+, stateSize(-1)
+{
+}
+
+bool TrajectoryFile::open(const std::string& filename, int onlyStateSize)
+{
+  close();
+  if(!file.open(filename)) return false;
+
+  const unsigned char* data = file.getData();
+  size_t size = file.getSize();
+  size_t pos = 0;
+  while(pos + sizeof(TrajectoryChunkHeader) <= size)
+  {
+    TrajectoryChunkHeader header;
+    std::memcpy(&header, data + pos, sizeof(header));
+    if(std::memcmp(header.magic, "OOTJ", 4) != 0 || header.version != TRAJECTORY_FILE_VERSION) break;
+    if(header.stateSize > 65536) break; //damaged, and would overflow the size computation
+
+    size_t payloadSize = getChunkPayloadSize(header.numTrajectories, header.numSteps, header.numHistory, header.stateSize);
+    const unsigned char* payload = data + pos + sizeof(header);
+    if(pos + sizeof(header) + payloadSize > size) break; //incomplete
+    if(getDataChecksum(payload, payloadSize) != header.checksum) break;
+
+    const unsigned* p = (const unsigned*)payload;
+    size_t nt = header.numTrajectories, ns = header.numSteps;
+    Chunk chunk;
+    chunk.firstTrajectory = numTrajectories;
+    chunk.numTrajectories = header.numTrajectories;
+    chunk.stateSize = header.stateSize;
+    chunk.rewards = (const float*)p; p += nt;
+    chunk.versions = (const int*)p; p += nt;
+    chunk.tables = (const int*)p; p += nt;
+    chunk.stepOffsets = p; p += nt + 1;
+    chunk.states = (const float*)p; p += ns * header.stateSize;
+    chunk.means = (const float*)p; p += ns * 2;
+    chunk.actions = (const float*)p; p += ns * 2;
+    chunk.historyOffsets = p; p += ns + 1;
+    chunk.histories = (const float*)p;
+
+    //the offsets must stay inside the chunk
+    if(chunk.stepOffsets[nt] != ns || chunk.historyOffsets[ns] != header.numHistory) break;
+
+    pos += sizeof(header) + payloadSize;
+    if(ns > 0 && onlyStateSize >= 0 && (int)header.stateSize != onlyStateSize) continue; //another network input
+
+    chunks.push_back(chunk);
+    numTrajectories += nt;
+    numSteps += ns;
+    if(ns > 0) stateSize = (stateSize < 0 || stateSize == (int)header.stateSize) ? (int)header.stateSize : 0;
+  }
+
+  if(chunks.empty())
+  {
+    close();
+    return false;
+  }
+  return true;
+}
+
+void TrajectoryFile::close()
+{
+  file.close();
+  chunks.clear();
+  numTrajectories = 0;
+  numSteps = 0;
+  stateSize = -1;
+}
+
+size_t TrajectoryFile::getNumTrajectories() const
+{
+  return numTrajectories;
+}
+
+size_t TrajectoryFile::getNumSteps() const
+{
+  return numSteps;
+}
+
+int TrajectoryFile::getStateSize() const
+{
+  return stateSize;
+}
+
+void TrajectoryFile::getTrajectory(size_t index, Trajectory& result) const
+{
+  //binary search for the last chunk that starts at or before index
+  size_t lo = 0, hi = chunks.size();
+  while(hi - lo > 1)
+  {
+    size_t mid = (lo + hi) / 2;
+    if(chunks[mid].firstTrajectory <= index) lo = mid;
+    else hi = mid;
+  }
+  const Chunk& chunk = chunks[lo];
+  size_t t = index - chunk.firstTrajectory;
+
+  result.reward = chunk.rewards[t];
+  result.weightsVersion = chunk.versions[t];
+  result.table = chunk.tables[t];
+  unsigned begin = chunk.stepOffsets[t], end = chunk.stepOffsets[t + 1];
+  result.steps.resize(end - begin);
+  for(unsigned s = begin; s < end; s++)
+  {
+    TrajectoryStep& step = result.steps[s - begin];
+    step.state.assign(chunk.states + (size_t)s * chunk.stateSize, chunk.states + (size_t)(s + 1) * chunk.stateSize);
+    step.history.assign(chunk.histories + chunk.historyOffsets[s], chunk.histories + chunk.historyOffsets[s + 1]);
+    step.mean[0] = chunk.means[s * 2 + 0];
+    step.mean[1] = chunk.means[s * 2 + 1];
+    step.action[0] = chunk.actions[s * 2 + 0];
+    step.action[1] = chunk.actions[s * 2 + 1];
+  }
+}
+
+void TrajectoryFile::sample(std::vector<Trajectory>& result, size_t amount, RandomStream& random) const
+{
+  result.clear();
+  if(numTrajectories == 0) return;
+  result.resize(amount);
+  for(size_t i = 0; i < amount; i++) getTrajectory((size_t)(random.next() % numTrajectories), result[i]);
+}
@@ -0,0 +1,143 @@
+/*
+OOPoker
+
+Copyright (c) 2010 Lode Vandevenne
+All rights reserved.
+
+This file is part of OOPoker.
+
+OOPoker is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+OOPoker is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with OOPoker.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#pragma once
+
+#include <cstdio>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "mappedfile.h"
+#include "random.h"
+#include "trajectory.h"
+
+/*
+On-disk store of RL trajectories, so that self-play data can outlive the program: to train offline, to
+replay old data, or to resume training without playing all the hands again.
+
+The file is a sequence of chunks. Writers only ever append complete chunks, readers memory-map the file
+and use the columns in place, so even a file much bigger than RAM can be sampled from.
+
+Chunk format (little endian, all values 4 bytes):
+-header: "OOTJ", version, amount of trajectories T, amount of steps S, amount of history floats H,
+ state size F (floats per step state), checksum of the rest of the chunk, padding
+-T floats reward, T ints weightsVersion, T ints table, T + 1 step offsets (steps of trajectory t are
+ step stepOffset[t] to stepOffset[t + 1] - 1 of this chunk)
+-S * F floats state, S * 2 floats mean, S * 2 floats action, S + 1 history offsets (the history floats of
+ step s are historyOffset[s] to historyOffset[s + 1] - 1 of this chunk)
+-H floats history
+*/
+
+//Appends trajectories to a file. Buffers them in memory and writes them as one chunk per chunkSize trajectories.
+class TrajectoryWriter
+{
+  public:
+    TrajectoryWriter();
+    ~TrajectoryWriter(); //flushes and closes
+
+    bool open(const std::string& filename); //appends to the file if it already exists. Returns false on error.
+    void close(); //flushes and closes
+    bool isOpen() const;
+
+    bool add(const Trajectory& trajectory); //thread safe. Returns false on write error.
+    bool flush(); //writes the buffered trajectories now, as one chunk
+
+    void setChunkSize(size_t trajectories);
+
+  private:
+    TrajectoryWriter(const TrajectoryWriter&); //not copyable
+    TrajectoryWriter& operator=(const TrajectoryWriter&);
+
+    bool flushLocked(); //call with the mutex locked
+
+    std::mutex mutex;
+    FILE* file;
+    size_t chunkSize;
+
+    //the columns of the chunk that's being built
+    int stateSize; //-1 when no trajectory is buffered
+    std::vector<float> rewards;
+    std::vector<int> versions;
+    std::vector<int> tables;
+    std::vector<unsigned> stepOffsets;
+    std::vector<float> states;
+    std::vector<float> means;
+    std::vector<float> actions;
+    std::vector<unsigned> historyOffsets;
+    std::vector<float> histories;
+};
+
+/*
+Read access to a trajectory file, memory-mapped. Reading stops at the first chunk that's incomplete or
+damaged (e.g. if the program that wrote it was killed while writing), the chunks before it can still be
+used. The functions that get trajectories can be used from multiple threads at once.
+
+Runs with a different network input append chunks with another state size to the same file. Every chunk
+keeps its own state size, and open can be given the one state size to use, the chunks with another one
+are then skipped (the ones after them are still read).
+*/
+class TrajectoryFile
+{
+  public:
+    TrajectoryFile();
+
+    //onlyStateSize -1 reads all chunks, otherwise only those with that state size (and those without steps).
+    //Returns false if the file can't be opened or has no valid chunks.
+    bool open(const std::string& filename, int onlyStateSize = -1);
+    void close();
+
+    size_t getNumTrajectories() const;
+    size_t getNumSteps() const;
+    int getStateSize() const; //-1 if there are no steps, 0 if the chunks have different state sizes
+
+    void getTrajectory(size_t index, Trajectory& result) const;
+    //replaces result with amount trajectories chosen uniformly at random (with replacement). Empty if the file is.
+    void sample(std::vector<Trajectory>& result, size_t amount, RandomStream& random) const;
+
+  private:
+    TrajectoryFile(const TrajectoryFile&); //not copyable
+    TrajectoryFile& operator=(const TrajectoryFile&);
+
+    struct Chunk
+    {
+      size_t firstTrajectory; //index in the whole file of the first trajectory of this chunk
+      unsigned numTrajectories;
+      unsigned stateSize; //floats per step state
+      const float* rewards;
+      const int* versions;
+      const int* tables;
+      const unsigned* stepOffsets;
+      const float* states;
+      const float* means;
+      const float* actions;
+      const unsigned* historyOffsets;
+      const float* histories;
+    };
+
+    MappedFile file;
+    std::vector<Chunk> chunks;
+    size_t numTrajectories;
+    size_t numSteps;
+    int stateSize;
+};
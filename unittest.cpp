@@ -26,6 +26,13 @@ along with OOPoker.  If not, see <http://www.gnu.org/licenses/>.
 #include <string>
 #include <algorithm>
 #include <iostream>
+#include <fstream>
+#include <iterator>
+#include <cmath>
+#include <cstdio>
+#include <atomic>
+#include <thread>
+#include <chrono>
 
 #include "ai.h"
 #include "ai_blindlimp.h"
@@ -34,15 +41,34 @@ along with OOPoker.  If not, see <http://www.gnu.org/licenses/>.
 #include "ai_raise.h"
 #include "ai_random.h"
 #include "ai_smart.h"
+#include "buckets.h"
 #include "card.h"
 #include "combination.h"
+#include "deck.h"
+#include "equity.h"
+#include "eventring.h"
 #include "game.h"
+#include "handhistory.h"
+#include "handrange.h"
+#include "host.h"
+#include "isomorphism.h"
+#include "lockfreequeue.h"
+#include "nametable.h"
+#include "observer_async.h"
+#include "observer_handhistory.h"
 #include "io_terminal.h"
 #include "player.h"
 #include "pokereval.h"
 #include "pokermath.h"
 #include "random.h"
+#include "replaybuffer.h"
+#include "riverranker.h"
+#include "spscqueue.h"
+#include "statistics.h"
 #include "table.h"
+#include "threadpool.h"
+#include "trajectoryfile.h"
+#include "util.h"
 #include "info.h"
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -497,6 +523,77 @@ void testRandom()
   std::cout << std::endl;
 }
 
+void testDeckShuffle()
+{
+  std::cout << "Testing deck shuffle" << std::endl;
+
+  //the secure bounded random is uniform too
+  int count[7] = { 0 };
+  for(int i = 0; i < 70000; i++) count[getRandom(0, 6)]++;
+  for(int i = 0; i < 7; i++) ASSERT_TRUE(count[i] > 9500 && count[i] < 10500);
+
+  //every shuffle is a permutation, and the fast shuffle with the same seed gives the same deals
+  Deck secure, fast1, fast2;
+  RandomStream r1(77), r2(77);
+  for(int i = 0; i < 100; i++)
+  {
+    secure.shuffle();
+    fast1.shuffle(r1);
+    fast2.shuffle(r2);
+    bool seen[52] = { false };
+    for(int j = 0; j < 52; j++)
+    {
+      Card a = fast1.next();
+      ASSERT_EQUALS(a.getIndex(), fast2.next().getIndex());
+      seen[secure.next().getIndex()] = true;
+    }
+    for(int j = 0; j < 52; j++) ASSERT_TRUE(seen[j]);
+  }
+
+  std::cout << std::endl;
+}
+
+void testRandomStream()
+{
+  std::cout << "Testing random stream" << std::endl;
+
+  //same seed gives the same sequence, the jumped streams differ from each other
+  RandomStream a(1234), b(1234), c(1234, 1), d(1234);
+  d.jump();
+  for(int i = 0; i < 100; i++)
+  {
+    uint64_t va = a.next();
+    uint64_t vc = c.next();
+    ASSERT_EQUALS(va, b.next());
+    ASSERT_EQUALS(vc, d.next());
+    ASSERT_TRUE(va != vc);
+  }
+
+  //nextInt stays in range and hits every value about equally often
+  int count[7] = { 0 };
+  for(int i = 0; i < 70000; i++)
+  {
+    int v = a.nextInt(3, 9);
+    ASSERT_TRUE(v >= 3 && v <= 9);
+    count[v - 3]++;
+  }
+  for(int i = 0; i < 7; i++) ASSERT_TRUE(count[i] > 9500 && count[i] < 10500);
+
+  //a simulation given a seeded stream can be replayed exactly
+  double win1, tie1, lose1, win2, tie2, lose2;
+  RandomStream r1(5), r2(5);
+  getWinChanceAgainstNAtFlop(win1, tie1, lose1, Card("Ah"), Card("Kh"), Card("2h"), Card("7c"), Card("9d"), 3, 10000, &r1);
+  getWinChanceAgainstNAtFlop(win2, tie2, lose2, Card("Ah"), Card("Kh"), Card("2h"), Card("7c"), Card("9d"), 3, 10000, &r2);
+  ASSERT_EQUALS(win1, win2);
+  ASSERT_EQUALS(tie1, tie2);
+
+  //pre-flop simulation against the known exact value of AA heads-up (85.2%)
+  getWinChanceAgainstNAtPreFlop(win1, tie1, lose1, Card("Ac"), Card("Ad"), 1, 200000, &r1);
+  ASSERT_TRUE(std::abs(win1 + tie1 / 2 - 0.852) < 0.005);
+
+  std::cout << std::endl;
+}
+
 static void shuffleN(int* values, int size, int amount)
 {
   for(int i = 0; i < amount; i++)
@@ -543,6 +640,1276 @@ void benchmarkEval7()
   //std::cout << "end time: " << getDateString() << std::endl;
 }
 
+void testEval7Batch()
+{
+  std::cout << "Testing eval7_batch (" << eval7_batch_kernel() << ")" << std::endl;
+
+  //random hands, plus some of the rarest combinations, in an amount that isn't a multiple of the SIMD width
+  std::vector<uint64_t> masks;
+  const char* special[] = { "AhKhQhJhTh2c3d", "5s4s3s2sAs9h9d", "Ac2d3h4s5c9d9h", "9c9d9h9sKcKdKh", "2c2d2h3c3d3h4s", "AcAdKhKs7c7d2h" };
+  for(size_t i = 0; i < sizeof(special) / sizeof(*special); i++)
+  {
+    std::string s = special[i];
+    uint64_t mask = 0;
+    for(size_t j = 0; j < 7; j++) mask |= eval7_mask(Card(s.substr(j * 2, 2)));
+    masks.push_back(mask);
+  }
+
+  int cards[52];
+  for(int i = 0; i < 52; i++) cards[i] = i;
+  for(int i = 0; i < 200003; i++)
+  {
+    shuffleN(cards, 52, 7);
+    uint64_t mask = 0;
+    for(int j = 0; j < 7; j++) mask |= eval7_mask(Card(cards[j]));
+    masks.push_back(mask);
+  }
+
+  std::vector<uint32_t> values(masks.size());
+  eval7_batch(&masks[0], &values[0], masks.size());
+
+  int combos[10] = { 0 }; //the PokerEval2 values have the category (1-9) in bits 20 and up
+  for(size_t i = 0; i < masks.size(); i++)
+  {
+    int c[7];
+    int n = 0;
+    for(int j = 0; j < 52; j++) if(masks[i] & eval7_mask(Card(j))) c[n++] = eval7_index(Card(j));
+    ASSERT_EQUALS(eval7(c), (int)values[i]);
+    combos[values[i] >> 20]++;
+  }
+  for(int i = 1; i < 10; i++) ASSERT_TRUE(combos[i] > 0); //every category was tested
+
+  std::cout << std::endl;
+}
+
+void benchmarkEval7Batch()
+{
+  static const int numSamples = 10000000;
+  static const int batchSize = 1024;
+
+  int cards[52];
+  for(int i = 0; i < 52; i++) cards[i] = i;
+  std::vector<uint64_t> masks(batchSize);
+  for(int i = 0; i < batchSize; i++)
+  {
+    shuffleN(cards, 52, 7);
+    masks[i] = 0;
+    for(int j = 0; j < 7; j++) masks[i] |= eval7_mask(Card(cards[j]));
+  }
+  std::vector<uint32_t> values(batchSize);
+
+  std::cout << "Starting batch benchmark (" << eval7_batch_kernel() << ") with " << numSamples << " evaluations" << std::endl;
+  std::cout << "Start time: " << getDateString() << std::endl;
+
+  unsigned test = 0;
+  for(int i = 0; i < numSamples / batchSize; i++)
+  {
+    eval7_batch(&masks[0], &values[0], batchSize);
+    test += values[i % batchSize]; //make sure nothing is optimized away
+  }
+
+  std::cout << "End time: " << getDateString() << std::endl;
+  std::cout << "Test value: " << test << std::endl;
+
+  std::cout << std::endl;
+}
+
+void testParallelEquity()
+{
+  std::cout << "Testing parallel equity" << std::endl;
+
+  //every task runs exactly once, also with nested runs
+  ThreadPool pool(3);
+  std::vector<int> ran(100, 0);
+  pool.run(10, [&](int i)
+  {
+    pool.run(10, [&](int j) { ran[i * 10 + j]++; });
+  });
+  for(size_t i = 0; i < ran.size(); i++) ASSERT_EQUALS(1, ran[i]);
+
+  //a task that throws on the calling thread: the rest is skipped, the exception reaches the caller
+  ThreadPool single(1);
+  int count = 0;
+  bool caught = false;
+  try { single.run(10, [&](int i) { if(i == 5) throw 5; count++; }); }
+  catch(int) { caught = true; }
+  ASSERT_TRUE(caught);
+  ASSERT_EQUALS(5, count);
+
+  //with workers, run only rethrows after the tasks they started are done, and the pool still works
+  std::thread::id caller = std::this_thread::get_id();
+  std::atomic<int> started(0), done(0);
+  try
+  {
+    pool.run(1000, [&](int)
+    {
+      started++;
+      if(std::this_thread::get_id() == caller) throw 1;
+      std::this_thread::sleep_for(std::chrono::microseconds(10));
+      done++;
+    });
+  }
+  catch(int) { done++; }
+  ASSERT_EQUALS(started.load(), done.load());
+  std::fill(ran.begin(), ran.end(), 0);
+  pool.run(100, [&](int i) { ran[i]++; });
+  for(size_t i = 0; i < ran.size(); i++) ASSERT_EQUALS(1, ran[i]);
+
+  std::vector<Card> hole, board;
+  hole.push_back(Card("Ac")); hole.push_back(Card("Ad"));
+
+  //same seed gives the same result, and it matches the exact value of AA heads-up (85.2%)
+  double e1 = getPotEquityParallel(hole, board, 1, 100000, 3);
+  double e2 = getPotEquityParallel(hole, board, 1, 100000, 3);
+  ASSERT_EQUALS(e1, e2);
+  ASSERT_TRUE(std::abs(e1 - 0.852) < 0.01);
+
+  //a chunk count that isn't a whole number, against the single threaded version
+  board.push_back(Card("2h")); board.push_back(Card("7c")); board.push_back(Card("9d"));
+  double win, tie, lose, win2, tie2, lose2;
+  getWinChanceAgainstNParallel(win, tie, lose, hole, board, 4, 3 * PARALLEL_CHUNK_SAMPLES + 100);
+  getWinChanceAgainstNAtFlop(win2, tie2, lose2, hole[0], hole[1], board[0], board[1], board[2], 4, 100000);
+  ASSERT_TRUE(std::abs(win + tie + lose - 1.0) < 1e-9);
+  ASSERT_TRUE(std::abs(win - win2) < 0.02);
+
+  std::vector<Card> holeCards1, holeCards2;
+  holeCards1.push_back(Card("Ac")); holeCards2.push_back(Card("Ad"));
+  holeCards1.push_back(Card("Kh")); holeCards2.push_back(Card("Qh"));
+  std::vector<double> wins, ties, losses;
+  ASSERT_TRUE(getWinChanceWithKnownHandsParallel(wins, ties, losses, holeCards1, holeCards2, std::vector<Card>(), 50000));
+  ASSERT_EQUALS(2, wins.size());
+  ASSERT_TRUE(wins[0] > 0.75 && wins[0] < 0.85);
+
+  std::cout << std::endl;
+}
+
+void testWinChanceKernel()
+{
+  std::cout << "Testing win chance kernel" << std::endl;
+
+  //heads-up simulations against the exhaustive functions
+  RandomStream random(11);
+  double win, tie, lose, win2, tie2, lose2;
+  getWinChanceAgainstNAtTurn(win, tie, lose, Card("Ah"), Card("Kh"), Card("2h"), Card("7c"), Card("9d"), Card("Qh"), 1, 100000, &random);
+  getWinChanceAgainst1AtTurn(win2, tie2, lose2, Card("Ah"), Card("Kh"), Card("2h"), Card("7c"), Card("9d"), Card("Qh"));
+  ASSERT_TRUE(std::abs(win - win2) < 0.01);
+  ASSERT_TRUE(std::abs(tie - tie2) < 0.01);
+  getWinChanceAgainstNAtRiver(win, tie, lose, Card("Ad"), Card("As"), Card("Ah"), Card("Ac"), Card("Qc"), Card("Jc"), Card("Tc"), 1, 100000, &random);
+  getWinChanceAgainst1AtRiver(win2, tie2, lose2, Card("Ad"), Card("As"), Card("Ah"), Card("Ac"), Card("Qc"), Card("Jc"), Card("Tc"));
+  ASSERT_TRUE(std::abs(lose - lose2) < 0.005);
+
+  //royal flush on the table: everyone ties, with any amount of opponents
+  for(int n = 1; n <= 12; n++)
+  {
+    getWinChanceAgainstNAtRiver(win, tie, lose, Card("2d"), Card("7d"), Card("Ad"), Card("Kd"), Card("Qd"), Card("Jd"), Card("Td"), n, 1000, &random);
+    ASSERT_EQUALS(1.0, tie);
+  }
+
+  //more opponents than the specialized kernels, uses the generic one
+  getWinChanceAgainstNAtPreFlop(win, tie, lose, Card("Ac"), Card("Ad"), 12, 20000, &random);
+  getWinChanceAgainstNAtPreFlop(win2, tie2, lose2, Card("Ac"), Card("Ad"), 9, 20000, &random);
+  ASSERT_TRUE(std::abs(win + tie + lose - 1.0) < 1e-9);
+  ASSERT_TRUE(win < win2 && win > 0.1);
+
+  std::cout << std::endl;
+}
+
+void testHandRange()
+{
+  std::cout << "Testing hand range" << std::endl;
+
+  //combo numbering
+  std::vector<int> seen(NUM_COMBOS, 0);
+  for(int a = 0; a < 52; a++)
+  for(int b = 0; b < 52; b++)
+  {
+    if(a == b) continue;
+    int combo = getComboIndex(a, b);
+    ASSERT_EQUALS(combo, getComboIndex(b, a));
+    int c1, c2;
+    getComboCards(c1, c2, combo);
+    ASSERT_EQUALS(std::min(a, b), c1);
+    ASSERT_EQUALS(std::max(a, b), c2);
+    if(a < b) seen[combo]++;
+  }
+  for(int i = 0; i < NUM_COMBOS; i++) ASSERT_EQUALS(1, seen[i]);
+
+  //13x13 grid
+  float grid[169], grid2[169];
+  for(int i = 0; i < 169; i++) grid[i] = (i % 7) / 6.0f;
+  HandRange range;
+  range.setGrid(grid);
+  range.getGrid(grid2);
+  for(int i = 0; i < 169; i++) ASSERT_TRUE(std::abs(grid[i] - grid2[i]) < 1e-6);
+  ASSERT_EQUALS(grid[getStartingHandIndex(Card("Ah"), Card("Kh"))], range.getWeight(Card("Ks"), Card("As")));
+
+  //against any two cards it's the same as the exhaustive functions
+  HandRange any(1.0f);
+  std::vector<Card> board;
+  board.push_back(Card("2h")); board.push_back(Card("7c")); board.push_back(Card("9d"));
+  double win, tie, lose;
+  getWinChanceAgainst1AtFlop(win, tie, lose, Card("Ah"), Card("Kh"), board[0], board[1], board[2]);
+  ASSERT_TRUE(std::abs(win + tie / 2 - getHandVsRangeEquity(Card("Ah"), Card("Kh"), board, any)) < 1e-9);
+  board.push_back(Card("Qh")); board.push_back(Card("Th"));
+  getWinChanceAgainst1AtRiver(win, tie, lose, Card("Ah"), Card("Kc"), board[0], board[1], board[2], board[3], board[4]);
+  ASSERT_TRUE(std::abs(win + tie / 2 - getHandVsRangeEquity(Card("Ah"), Card("Kc"), board, any)) < 1e-9);
+
+  //a range with a single combo is the same as that hand, exact on the turn
+  board.pop_back();
+  HandRange single;
+  single.setWeight(Card("Ah"), Card("Kh"), 1.0f);
+  getWinChanceAgainst1AtTurn(win, tie, lose, Card("Ah"), Card("Kh"), board[0], board[1], board[2], board[3]);
+  ASSERT_TRUE(std::abs(win + tie / 2 - getRangeVsRangeEquity(single, any, board)) < 1e-9);
+  ASSERT_TRUE(std::abs(1.0 - (win + tie / 2) - getRangeVsRangeEquity(any, single, board)) < 1e-9);
+
+  //card removal: the only combo of the range is on the board
+  HandRange blocked;
+  blocked.setWeight(Card("Qh"), Card("Qs"), 1.0f);
+  ASSERT_EQUALS(0.0, blocked.getTotalWeight(eval7_mask(Card("Qh"))));
+  ASSERT_EQUALS(0.0, getRangeVsRangeEquity(blocked, any, board));
+
+  //pre-flop simulation, AA against KK is about 82%
+  HandRange aces, kings;
+  for(int i = 0; i < NUM_COMBOS; i++)
+  {
+    int c1, c2;
+    getComboCards(c1, c2, i);
+    if(c1 % 13 == 12 && c2 % 13 == 12) aces.setWeight(i, 1.0f);
+    if(c1 % 13 == 11 && c2 % 13 == 11) kings.setWeight(i, 1.0f);
+  }
+  RandomStream random(17);
+  ASSERT_TRUE(std::abs(0.82 - getRangeVsRangeEquity(aces, kings, std::vector<Card>(), 50000, &random)) < 0.01);
+
+  std::cout << std::endl;
+}
+
+void testRiverRanker()
+{
+  std::cout << "Testing river ranker" << std::endl;
+
+  RandomStream random(18);
+  std::vector<float> weights(NUM_COMBOS);
+  std::vector<double> equity(NUM_COMBOS), total(NUM_COMBOS);
+  //the last board has a straight on it, so that there are big groups of equal values
+  const char* boards[] = { "2h7c9dQhTh", "AsKsQsJsTs", "3c4d5h6s7c" };
+  for(size_t b = 0; b < sizeof(boards) / sizeof(*boards); b++)
+  {
+    std::vector<Card> board;
+    for(int i = 0; i < 5; i++) board.push_back(Card(std::string(boards[b]).substr(i * 2, 2)));
+    RiverRanker ranker;
+    ranker.setBoard(board);
+    ASSERT_EQUALS(1081, ranker.getSize());
+
+    //sorted, and the same values as eval7
+    for(int i = 0; i < ranker.getSize(); i++)
+    {
+      if(i > 0) ASSERT_TRUE(ranker.getValue(i - 1) <= ranker.getValue(i));
+      int c1, c2;
+      getComboCards(c1, c2, ranker.getCombo(i));
+      int c[7] = { c1, c2, eval7_index(board[0]), eval7_index(board[1]), eval7_index(board[2]), eval7_index(board[3]), eval7_index(board[4]) };
+      ASSERT_EQUALS(eval7(c), (int)ranker.getComboValue(ranker.getCombo(i)));
+    }
+
+    //the single pass showdown against a random range is the same as comparing every pair
+    for(int i = 0; i < NUM_COMBOS; i++) weights[i] = (float)random.nextDouble();
+    ranker.getShowdown(&equity[0], &total[0], &weights[0]);
+    for(int i = 0; i < ranker.getSize(); i += 7)
+    {
+      int combo = ranker.getCombo(i);
+      double e = 0.0, t = 0.0;
+      for(int j = 0; j < ranker.getSize(); j++)
+      {
+        int other = ranker.getCombo(j);
+        if(getComboMask(combo) & getComboMask(other)) continue;
+        uint32_t v1 = ranker.getComboValue(combo), v2 = ranker.getComboValue(other);
+        t += weights[other];
+        e += weights[other] * ((v1 > v2) + 0.5 * (v1 == v2));
+      }
+      ASSERT_TRUE(std::abs(e - equity[combo]) < 1e-6);
+      ASSERT_TRUE(std::abs(t - total[combo]) < 1e-6);
+    }
+  }
+
+  std::cout << std::endl;
+}
+
+void testLockFreeQueue()
+{
+  std::cout << "Testing lock-free queue" << std::endl;
+
+  LockFreeQueue<int> queue(5);
+  ASSERT_EQUALS(8, queue.getCapacity());
+  int value = 0;
+  ASSERT_TRUE(!queue.tryPop(value));
+  for(int i = 0; i < 8; i++) ASSERT_TRUE(queue.tryPush(i));
+  value = 8;
+  ASSERT_TRUE(!queue.tryPush(value));
+  ASSERT_EQUALS(8, queue.getSizeApprox());
+  for(int i = 0; i < 8; i++)
+  {
+    ASSERT_TRUE(queue.tryPop(value));
+    ASSERT_EQUALS(i, value);
+  }
+  ASSERT_TRUE(!queue.tryPop(value));
+
+  //several producers and consumers: every element comes out exactly once, in order per producer
+  const int numProducers = 4, numConsumers = 2, perProducer = 20000;
+  LockFreeQueue<int> shared(64);
+  std::vector<std::vector<int> > received(numConsumers);
+  std::vector<std::thread> threads;
+  for(int p = 0; p < numProducers; p++)
+  {
+    threads.push_back(std::thread([&shared, p]()
+    {
+      for(int i = 0; i < perProducer; i++)
+      {
+        int v = p * perProducer + i;
+        while(!shared.tryPush(v)) std::this_thread::yield();
+      }
+    }));
+  }
+  std::atomic<int> numReceived(0);
+  for(int c = 0; c < numConsumers; c++)
+  {
+    threads.push_back(std::thread([&shared, &received, &numReceived, c]()
+    {
+      int v;
+      while(numReceived.load() < numProducers * perProducer)
+      {
+        if(shared.tryPop(v)) { received[c].push_back(v); numReceived++; }
+        else std::this_thread::yield();
+      }
+    }));
+  }
+  for(size_t i = 0; i < threads.size(); i++) threads[i].join();
+
+  std::vector<int> count(numProducers * perProducer, 0);
+  for(int c = 0; c < numConsumers; c++)
+  {
+    std::vector<int> last(numProducers, -1);
+    for(size_t i = 0; i < received[c].size(); i++)
+    {
+      int v = received[c][i];
+      count[v]++;
+      ASSERT_TRUE(v > last[v / perProducer]);
+      last[v / perProducer] = v;
+    }
+  }
+  for(size_t i = 0; i < count.size(); i++) ASSERT_EQUALS(1, count[i]);
+
+  std::cout << std::endl;
+}
+
+void testReplayBuffer()
+{
+  std::cout << "Testing replay buffer" << std::endl;
+
+  ReplayBuffer buffer(4);
+  RandomStream random(5);
+  std::vector<Trajectory> sample;
+  buffer.sample(sample, 3, random);
+  ASSERT_EQUALS(0, sample.size());
+
+  //when full, the oldest are overwritten
+  for(int i = 0; i < 6; i++)
+  {
+    Trajectory trajectory;
+    trajectory.reward = (float)i;
+    trajectory.steps.resize(i + 1);
+    buffer.add(trajectory);
+  }
+  ASSERT_EQUALS(4, buffer.getSize());
+  ASSERT_EQUALS(6, buffer.getNumAdded());
+
+  buffer.sample(sample, 1000, random);
+  ASSERT_EQUALS(1000, sample.size());
+  std::vector<int> count(6, 0);
+  for(size_t i = 0; i < sample.size(); i++)
+  {
+    int r = (int)sample[i].reward;
+    ASSERT_EQUALS(r + 1, sample[i].steps.size()); //the whole trajectory is copied
+    count[r]++;
+  }
+  ASSERT_EQUALS(0, count[0]);
+  ASSERT_EQUALS(0, count[1]);
+  for(int r = 2; r < 6; r++) ASSERT_TRUE(count[r] > 150 && count[r] < 350);
+
+  std::cout << std::endl;
+}
+
+static Trajectory makeTestTrajectory(int index, int stateSize = 23)
+{
+  Trajectory trajectory;
+  trajectory.reward = index * 0.5f;
+  trajectory.weightsVersion = index;
+  trajectory.table = index % 3;
+  trajectory.steps.resize(index % 4); //also trajectories without steps
+  for(size_t i = 0; i < trajectory.steps.size(); i++)
+  {
+    TrajectoryStep& step = trajectory.steps[i];
+    for(int j = 0; j < stateSize; j++) step.state.push_back(index + i * 0.25f + j);
+    for(size_t j = 0; j < 3 * (i + 1); j++) step.history.push_back(index - (float)j);
+    step.mean[0] = 1.0f * index; step.mean[1] = 2.0f * i;
+    step.action[0] = -1.0f * index; step.action[1] = -2.0f * i;
+  }
+  return trajectory;
+}
+
+static bool trajectoriesEqual(const Trajectory& a, const Trajectory& b)
+{
+  if(a.reward != b.reward || a.weightsVersion != b.weightsVersion || a.table != b.table) return false;
+  if(a.steps.size() != b.steps.size()) return false;
+  for(size_t i = 0; i < a.steps.size(); i++)
+  {
+    const TrajectoryStep& x = a.steps[i];
+    const TrajectoryStep& y = b.steps[i];
+    if(x.state != y.state || x.history != y.history) return false;
+    if(x.mean[0] != y.mean[0] || x.mean[1] != y.mean[1] || x.action[0] != y.action[0] || x.action[1] != y.action[1]) return false;
+  }
+  return true;
+}
+
+void testTrajectoryFile()
+{
+  std::cout << "Testing trajectory file" << std::endl;
+
+  std::string filename = "unittest_trajectories.dat";
+  std::remove(filename.c_str());
+
+  //several chunks, and appending to an existing file
+  TrajectoryWriter writer;
+  writer.setChunkSize(3);
+  ASSERT_TRUE(writer.open(filename));
+  for(int i = 0; i < 7; i++) ASSERT_TRUE(writer.add(makeTestTrajectory(i)));
+  writer.close();
+  ASSERT_TRUE(writer.open(filename));
+  for(int i = 7; i < 10; i++) ASSERT_TRUE(writer.add(makeTestTrajectory(i)));
+  writer.close();
+
+  TrajectoryFile file;
+  ASSERT_TRUE(file.open(filename));
+  ASSERT_EQUALS(10, file.getNumTrajectories());
+  ASSERT_EQUALS(23, file.getStateSize());
+  size_t steps = 0;
+  for(int i = 0; i < 10; i++)
+  {
+    Trajectory trajectory;
+    file.getTrajectory(i, trajectory);
+    ASSERT_TRUE(trajectoriesEqual(makeTestTrajectory(i), trajectory));
+    steps += trajectory.steps.size();
+  }
+  ASSERT_EQUALS(steps, file.getNumSteps());
+
+  RandomStream random(2);
+  std::vector<Trajectory> sample;
+  file.sample(sample, 50, random);
+  ASSERT_EQUALS(50, sample.size());
+  for(size_t i = 0; i < sample.size(); i++) ASSERT_TRUE(trajectoriesEqual(makeTestTrajectory(sample[i].weightsVersion), sample[i]));
+  file.close();
+
+  //a chunk that was cut off while writing is ignored, the ones before it still work
+  FILE* f = fopen(filename.c_str(), "ab");
+  fwrite("OOTJ\1\0\0\0\5\0\0\0", 1, 12, f);
+  fclose(f);
+  ASSERT_TRUE(file.open(filename));
+  ASSERT_EQUALS(10, file.getNumTrajectories());
+  file.close();
+
+  //runs with another network input in between: every chunk keeps its own state size
+  std::remove(filename.c_str());
+  ASSERT_TRUE(writer.open(filename));
+  for(int i = 0; i < 6; i++) ASSERT_TRUE(writer.add(makeTestTrajectory(i, i == 2 || i == 3 ? 24 : 23)));
+  writer.close();
+  ASSERT_TRUE(file.open(filename));
+  ASSERT_EQUALS(6, file.getNumTrajectories());
+  ASSERT_EQUALS(0, file.getStateSize());
+  for(int i = 0; i < 6; i++)
+  {
+    Trajectory trajectory;
+    file.getTrajectory(i, trajectory);
+    ASSERT_TRUE(trajectoriesEqual(makeTestTrajectory(i, i == 2 || i == 3 ? 24 : 23), trajectory));
+  }
+  ASSERT_TRUE(file.open(filename, 23)); //skips the chunk with trajectories 2 and 3, but not the one after it
+  ASSERT_EQUALS(23, file.getStateSize());
+  ASSERT_EQUALS(3, file.getNumTrajectories());
+  Trajectory last;
+  file.getTrajectory(2, last);
+  ASSERT_TRUE(trajectoriesEqual(makeTestTrajectory(5), last));
+  ASSERT_TRUE(!file.open(filename, 30));
+  file.close();
+
+  std::remove(filename.c_str());
+  ASSERT_TRUE(!file.open(filename));
+
+  std::cout << std::endl;
+}
+
+void testIsomorphism()
+{
+  std::cout << "Testing isomorphism" << std::endl;
+
+  ASSERT_EQUALS(169, getCanonicalSize(R_PRE_FLOP));
+  ASSERT_EQUALS(1286792, getCanonicalSize(R_FLOP));
+  ASSERT_EQUALS(13960050, getCanonicalSize(R_TURN));
+  ASSERT_EQUALS(123156254, getCanonicalSize(R_RIVER));
+
+  //every index must give back cards with that same index
+  for(int round = R_PRE_FLOP; round <= R_RIVER; round++)
+  {
+    CanonicalIndex size = getCanonicalSize((Round)round);
+    int numCards = round == R_PRE_FLOP ? 2 : round + 4;
+    for(CanonicalIndex i = 0; i < size; i += 1 + size / 20000)
+    {
+      int cards[7];
+      getCanonicalCards(cards, (Round)round, i);
+      ASSERT_EQUALS(i, getCanonicalIndex(cards, numCards));
+    }
+  }
+
+  //permuting suits and swapping cards within the hand or within the board must give the same index
+  for(int i = 0; i < 10000; i++)
+  {
+    int deck[52];
+    for(int j = 0; j < 52; j++) deck[j] = j;
+    for(int j = 0; j < 7; j++) std::swap(deck[j], deck[getRandomFast(j, 51)]);
+
+    int perm[4] = { 0, 1, 2, 3 };
+    for(int j = 0; j < 3; j++) std::swap(perm[j], perm[getRandomFast(j, 3)]);
+
+    int other[7];
+    for(int j = 0; j < 7; j++) other[j] = perm[deck[j] / 13] * 13 + deck[j] % 13;
+    std::swap(other[0], other[1]);
+    std::swap(other[2], other[6]);
+
+    ASSERT_EQUALS(getCanonicalIndex(deck, 7), getCanonicalIndex(other, 7));
+  }
+
+  std::cout << std::endl;
+}
+
+void testEquityCache()
+{
+  std::cout << "Testing equity cache" << std::endl;
+
+  //all 1326 starting hands map to the 169 classes, each class has 4 (suited), 6 (pair) or 12 (offsuit) hands
+  int count[169] = { 0 };
+  for(int i = 0; i < 52; i++)
+  for(int j = i + 1; j < 52; j++)
+  {
+    count[getStartingHandIndex(Card(i), Card(j))]++;
+  }
+  for(int i = 0; i < 169; i++)
+  {
+    int row = i / 13, col = i % 13;
+    ASSERT_EQUALS(row == col ? 6 : (row < col ? 4 : 12), count[i]);
+  }
+
+  clearEquityCache();
+  std::vector<Card> hole1, board1, hole2, board2;
+  hole1.push_back(Card("Ah")); hole1.push_back(Card("Kh"));
+  board1.push_back(Card("2h")); board1.push_back(Card("7c")); board1.push_back(Card("9d"));
+  hole2.push_back(Card("Ks")); hole2.push_back(Card("As")); //same state with permuted suits and card order
+  board2.push_back(Card("9c")); board2.push_back(Card("2s")); board2.push_back(Card("7d"));
+
+  double e1 = getPotEquityCached(hole1, board1, 2);
+  EquityStats before = getEquityStats();
+  double e2 = getPotEquityCached(hole2, board2, 2);
+  EquityStats after = getEquityStats();
+  ASSERT_EQUALS(e1, e2);
+  ASSERT_EQUALS(before.hits + 1, after.hits);
+  ASSERT_EQUALS(before.misses, after.misses);
+
+  double reference = getPotEquity(hole1, board1, 2, 200000);
+  ASSERT_TRUE(std::abs(e1 - reference) < 0.02);
+
+  //heads-up river is exact, so it must be the same as the pokermath.h version
+  board1.push_back(Card("Td")); board1.push_back(Card("3s"));
+  double win, tie, lose, win2, tie2, lose2;
+  getWinChanceCached(win, tie, lose, hole1, board1, 1);
+  getWinChanceAgainst1AtRiver(win2, tie2, lose2, hole1[0], hole1[1], board1[0], board1[1], board1[2], board1[3], board1[4]);
+  ASSERT_TRUE(std::abs(win - win2) < 1e-6 && std::abs(tie - tie2) < 1e-6 && std::abs(lose - lose2) < 1e-6);
+
+  std::cout << "equity: " << e1 << " reference: " << reference << std::endl;
+
+  //loading a saved cache stops at maxCacheEntries
+  std::string cacheFilename = "unittest_equity_cache.dat";
+  ASSERT_TRUE(getEquityStats().entries >= 2);
+  ASSERT_TRUE(saveEquityCache(cacheFilename));
+  EquitySettings settings = getEquitySettings();
+  EquitySettings small = settings;
+  small.maxCacheEntries = 1;
+  setEquitySettings(small);
+  ASSERT_TRUE(loadEquityCache(cacheFilename));
+  ASSERT_EQUALS(1, getEquityStats().entries);
+  setEquitySettings(settings);
+  std::remove(cacheFilename.c_str());
+
+  //pre-flop table file
+  std::vector<float> values(PREFLOP_EQUITY_HANDS * PREFLOP_EQUITY_OPPONENTS * PREFLOP_EQUITY_VALUES);
+  for(size_t i = 0; i < values.size(); i++) values[i] = (float)(i % 1000) / 1000.0f;
+  std::string filename = "unittest_preflop_equity.dat";
+  ASSERT_TRUE(writePreFlopEquityTable(filename, values, 1, 1000));
+  ASSERT_TRUE(loadPreFlopEquityTable(filename));
+  hole1[0] = Card("Ac"); hole1[1] = Card("Ad"); //starting hand index 0
+  ASSERT_EQUALS(values[2 * PREFLOP_EQUITY_VALUES + 3], (float)getPotEquityCached(hole1, std::vector<Card>(), 3));
+  values[5] = 0.5f; //a corrupted file must be refused
+  FILE* file = fopen(filename.c_str(), "r+b");
+  fseek(file, 40 + 5 * sizeof(float), SEEK_SET);
+  fwrite(&values[5], sizeof(float), 1, file);
+  fclose(file);
+  ASSERT_TRUE(!loadPreFlopEquityTable(filename));
+  unloadPreFlopEquityTable();
+  std::remove(filename.c_str());
+
+  std::cout << std::endl;
+}
+
+void testBuckets()
+{
+  std::cout << "Testing buckets" << std::endl;
+
+  //a table with only pre-flop and flop, bucket = canonical index modulo the amount of buckets
+  std::vector<unsigned char> buckets[BUCKET_ROUNDS];
+  int numBuckets[BUCKET_ROUNDS] = { 169, 50, 0, 0 };
+  for(int r = 0; r < 2; r++)
+  {
+    buckets[r].resize(getCanonicalSize((Round)r));
+    for(size_t i = 0; i < buckets[r].size(); i++) buckets[r][i] = (unsigned char)(i % numBuckets[r]);
+  }
+  std::string filename = "unittest_buckets.dat";
+  ASSERT_TRUE(writeBucketTable(filename, buckets, numBuckets));
+  ASSERT_TRUE(loadBucketTable(filename));
+  ASSERT_EQUALS(50, getNumBuckets(R_FLOP));
+  ASSERT_EQUALS(0, getNumBuckets(R_RIVER));
+
+  std::vector<Card> hole1, board1, hole2, board2;
+  hole1.push_back(Card("Ah")); hole1.push_back(Card("Kh"));
+  board1.push_back(Card("2h")); board1.push_back(Card("7c")); board1.push_back(Card("9d"));
+  hole2.push_back(Card("Ks")); hole2.push_back(Card("As")); //same state with permuted suits and card order
+  board2.push_back(Card("9c")); board2.push_back(Card("2s")); board2.push_back(Card("7d"));
+  ASSERT_EQUALS((int)(getCanonicalIndex(hole1, board1) % 50), getBucket(hole1, board1));
+  ASSERT_EQUALS(getBucket(hole1, board1), getBucket(hole2, board2));
+  ASSERT_EQUALS((int)getCanonicalIndex(hole1, std::vector<Card>()), getBucket(hole1, std::vector<Card>()));
+  board1.push_back(Card("Td"));
+  ASSERT_EQUALS(-1, getBucket(hole1, board1)); //turn isn't in the table
+
+  //the first lookups load the table, also if they come from several threads at once
+  setBucketFilePath(filename);
+  int expected = (int)(getCanonicalIndex(hole2, board2) % 50);
+  std::atomic<int> wrong(0);
+  std::vector<std::thread> threads;
+  for(int t = 0; t < 4; t++)
+  {
+    threads.push_back(std::thread([&]()
+    {
+      for(int i = 0; i < 1000; i++) if(getBucket(hole2, board2) != expected) wrong++;
+    }));
+  }
+  for(size_t t = 0; t < threads.size(); t++) threads[t].join();
+  ASSERT_EQUALS(0, wrong.load());
+
+  //a corrupted file must be refused
+  FILE* file = fopen(filename.c_str(), "r+b");
+  fseek(file, -1, SEEK_END);
+  fputc(255, file);
+  fclose(file);
+  ASSERT_TRUE(!loadBucketTable(filename));
+  ASSERT_EQUALS(-1, getBucket(hole2, board2));
+  setBucketFilePath("buckets.dat");
+  unloadBucketTable();
+  std::remove(filename.c_str());
+
+  std::cout << std::endl;
+}
+
+//observer for testing ObserverAsync: remembers the chips of the events, and can be made to wait
+class TestCountingObserver : public Observer
+{
+  public:
+    std::vector<int> chips;
+    std::atomic<bool> hold;
+
+    TestCountingObserver() : hold(false) {}
+
+    virtual void onEvent(const Event& event)
+    {
+      while(hold.load()) std::this_thread::yield();
+      chips.push_back(event.chips);
+    }
+};
+
+//host that lets a game run to the end without any interaction
+class TestQuietHost : public Host
+{
+  public:
+    virtual void onFrame() {}
+    virtual void onGameBegin(const Info&) {}
+    virtual void onDealDone(const Info&) {}
+    virtual void onGameDone(const Info&) {}
+    virtual bool wantToQuit() const { return false; }
+    virtual void resetWantToQuit() {}
+};
+
+//AI that plays like another AI, and checks at every decision that its InfoKeeper has the same Info as the Game gives
+class TestInfoKeeperAI : public AI
+{
+  public:
+    AI* ai;
+    InfoKeeper keeper;
+    int decisions;
+    int mismatches;
+
+    TestInfoKeeperAI(AI* ai, const std::string& name) : ai(ai), keeper(name), decisions(0), mismatches(0) {}
+    virtual ~TestInfoKeeperAI() { delete ai; }
+
+    virtual void onEvent(const Event& event) { keeper.onEvent(event); }
+    virtual std::string getAIName() { return ai->getAIName(); }
+
+    virtual Action doTurn(const Info& info)
+    {
+      const Info& kept = keeper.getInfo();
+      bool same = kept.yourIndex == info.yourIndex && kept.dealer == info.dealer && kept.current == info.current
+               && kept.round == info.round && kept.turn == info.turn && kept.minRaiseAmount == info.minRaiseAmount
+               && kept.boardCards.size() == info.boardCards.size() && kept.players.size() == info.players.size()
+               && kept.rules.smallBlind == info.rules.smallBlind && kept.rules.bigBlind == info.rules.bigBlind && kept.rules.ante == info.rules.ante;
+      for(size_t i = 0; same && i < info.boardCards.size(); i++) same = kept.boardCards[i].getIndex() == info.boardCards[i].getIndex();
+      for(size_t i = 0; same && i < info.players.size(); i++)
+      {
+        const PlayerInfo& a = kept.players[i];
+        const PlayerInfo& b = info.players[i];
+        same = a.folded == b.folded && a.nameId == b.nameId && a.stack == b.stack && a.wager == b.wager && a.showdown == b.showdown
+            && a.lastAction.command == b.lastAction.command && a.holeCards.size() == b.holeCards.size()
+            && (a.lastAction.command != A_RAISE || a.lastAction.amount == b.lastAction.amount);
+        for(size_t j = 0; same && j < b.holeCards.size(); j++) same = a.holeCards[j].getIndex() == b.holeCards[j].getIndex();
+      }
+      decisions++;
+      if(!same) mismatches++;
+      return ai->doTurn(info);
+    }
+};
+
+void testInfoKeeper()
+{
+  std::cout << "Testing info keeper" << std::endl;
+
+  std::string filename = "unittest_infokeeper.hh";
+  std::remove(filename.c_str());
+
+  //a game with antes, rebuys and all-ins, where each player checks its own InfoKeeper at every decision
+  std::vector<TestInfoKeeperAI*> ais;
+  {
+    TestQuietHost host;
+    Game game(&host);
+    Rules rules;
+    rules.buyIn = 200;
+    rules.smallBlind = 5;
+    rules.bigBlind = 10;
+    rules.ante = 1;
+    rules.allowRebuy = true;
+    rules.fixedNumberOfDeals = 300;
+    game.setRules(rules);
+    game.setShuffleMode(SHUFFLE_FAST, 5);
+    for(int i = 0; i < 5; i++)
+    {
+      std::string name = "keeper" + valtostr(i);
+      AI* ai = i % 3 == 0 ? (AI*)new AIRandom() : i % 3 == 1 ? (AI*)new AICall() : (AI*)new AIRaise();
+      ais.push_back(new TestInfoKeeperAI(ai, name));
+      game.addPlayer(Player(ais.back(), name));
+    }
+    game.addObserver(new ObserverHandHistory(filename));
+
+    std::streambuf* coutBuffer = std::cout.rdbuf(0); //the game prints the winner
+    game.doGame();
+    std::cout.rdbuf(coutBuffer);
+
+    for(size_t i = 0; i < ais.size(); i++)
+    {
+      ASSERT_TRUE(ais[i]->decisions > 100);
+      ASSERT_EQUALS(0, ais[i]->mismatches);
+    }
+
+    //replaying the hand history gives the same stacks as the players saw at the end
+    HandHistoryFile history;
+    ASSERT_TRUE(history.open(filename));
+    std::vector<Event> events;
+    ASSERT_TRUE(history.getDeals(0, history.getNumDeals(), events));
+    InfoKeeper global;
+    for(int pass = 0; pass < 2; pass++) //the second time reusing the keeper
+    {
+      global.reset();
+      for(size_t i = 0; i < events.size(); i++) global.onEvent(events[i]);
+      const Info& info = global.getInfo();
+      ASSERT_EQUALS(-1, info.yourIndex);
+      ASSERT_EQUALS(ais.size(), info.players.size());
+      for(size_t i = 0; i < info.players.size(); i++) ASSERT_EQUALS(ais[0]->keeper.getInfo().players[i].stack, info.players[i].stack);
+    }
+
+    //replay speed
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    size_t replayed = 0;
+    double seconds = 0;
+    while(seconds < 0.2)
+    {
+      global.reset();
+      for(size_t i = 0; i < events.size(); i++) global.onEvent(events[i]);
+      replayed += events.size();
+      seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    }
+    std::cout << "replayed " << (int)(replayed / seconds) << " events per second" << std::endl;
+  }
+  std::remove(filename.c_str());
+
+  std::cout << std::endl;
+}
+
+void testStatKeeper()
+{
+  std::cout << "Testing stat keeper" << std::endl;
+
+  //scripted deals with a pattern of 3 for alice: raise and bet the flop / call and check down to showdown / fold
+  {
+    StatKeeper keeper;
+    std::string alice = "statalice", bob = "statbob";
+    keeper.onEvent(Event(E_JOIN, alice, 1000000));
+    keeper.onEvent(Event(E_JOIN, bob, 1000000));
+    int numDeals = 130;
+    for(int deal = 0; deal < numDeals; deal++)
+    {
+      keeper.onEvent(Event(E_NEW_DEAL, 5, 10, 0));
+      keeper.onEvent(Event(E_SMALL_BLIND, alice, 5));
+      keeper.onEvent(Event(E_BIG_BLIND, bob, 10));
+      if(deal % 3 == 0)
+      {
+        keeper.onEvent(Event(E_RAISE, alice, 20));
+        keeper.onEvent(Event(E_CALL, bob));
+        keeper.onEvent(Event(E_FLOP));
+        keeper.onEvent(Event(E_CHECK, bob));
+        keeper.onEvent(Event(E_RAISE, alice, 30));
+        keeper.onEvent(Event(E_FOLD, bob));
+        keeper.onEvent(Event(E_POT_DIVISION));
+        keeper.onEvent(Event(E_WIN, alice, 60));
+      }
+      else if(deal % 3 == 1)
+      {
+        keeper.onEvent(Event(E_CALL, alice));
+        keeper.onEvent(Event(E_CHECK, bob));
+        keeper.onEvent(Event(E_FLOP));
+        keeper.onEvent(Event(E_CHECK, bob));
+        keeper.onEvent(Event(E_CHECK, alice));
+        keeper.onEvent(Event(E_TURN));
+        keeper.onEvent(Event(E_RIVER));
+        keeper.onEvent(Event(E_POT_DIVISION));
+        keeper.onEvent(Event(E_SHOWDOWN));
+        keeper.onEvent(Event(E_WIN, bob, 20));
+      }
+      else
+      {
+        keeper.onEvent(Event(E_FOLD, alice));
+        keeper.onEvent(Event(E_POT_DIVISION));
+        keeper.onEvent(Event(E_WIN, bob, 15));
+      }
+
+      //every window must be the same as counting the last deals of the pattern
+      for(int w = 0; w < NUM_STAT_WINDOWS; w++)
+      {
+        int size = std::min(deal + 1, STAT_WINDOWS[w]);
+        int raised = 0, called = 0;
+        for(int d = deal + 1 - size; d <= deal; d++)
+        {
+          if(d % 3 == 0) raised++;
+          if(d % 3 == 1) called++;
+        }
+        WindowStats stats;
+        ASSERT_TRUE(keeper.getWindowStats(stats, alice, w));
+        ASSERT_EQUALS(size, stats.deals);
+        ASSERT_EQUALS((double)(raised + called) / (double)size, stats.vpip);
+        ASSERT_EQUALS((double)raised / (double)size, stats.pfr);
+        ASSERT_EQUALS((double)raised, stats.af); //post-flop bets without any post-flop call
+        ASSERT_EQUALS(raised + called > 0 ? (double)called / (double)(raised + called) : 0.0, stats.wsd);
+      }
+    }
+
+    const PlayerStats* stats = keeper.getPlayerStats(alice);
+    ASSERT_TRUE(stats != 0);
+    ASSERT_TRUE(stats == keeper.getPlayerStats(internName(alice)));
+    ASSERT_EQUALS(numDeals, stats->deals);
+    ASSERT_EQUALS(44, stats->deal_preflop_raises);
+    ASSERT_EQUALS(43, stats->showdowns_seen);
+    ASSERT_EQUALS(numDeals, keeper.getTableStats()->deals);
+    ASSERT_EQUALS(87, keeper.getTableStats()->flops_seen);
+
+    std::vector<float> snapshot;
+    keeper.getSnapshot(snapshot, internName(alice));
+    ASSERT_EQUALS(STAT_SNAPSHOT_SIZE, (int)snapshot.size());
+    WindowStats w10, w100;
+    keeper.getWindowStats(w10, alice, 0);
+    keeper.getWindowStats(w100, alice, 3);
+    ASSERT_EQUALS((float)w10.vpip, snapshot[0]);
+    ASSERT_EQUALS((float)w100.pfr, snapshot[5]);
+    ASSERT_EQUALS((float)(w100.af / (1.0 + w100.af)), snapshot[7]);
+    ASSERT_EQUALS(1.0f, snapshot[9]);
+
+    //the players come sorted by name, not in join order
+    keeper.onEvent(Event(E_JOIN, std::string("stataaron"), 1000));
+    std::vector<std::string> all;
+    keeper.getAllPlayers(all);
+    ASSERT_EQUALS(3, all.size());
+    ASSERT_EQUALS(std::string("stataaron"), all[0]);
+    ASSERT_EQUALS(alice, all[1]);
+
+    //asking by name doesn't add the name to the name table
+    WindowStats unknown;
+    ASSERT_TRUE(keeper.getPlayerStats(std::string("statnever")) == 0);
+    ASSERT_TRUE(!keeper.getWindowStats(unknown, std::string("statnever"), 0));
+    ASSERT_EQUALS(-1, findInternedName("statnever"));
+    ASSERT_TRUE(!keeper.getWindowStats(unknown, internName("statnobody"), 0));
+    ASSERT_EQUALS(0, unknown.deals);
+    keeper.getSnapshot(snapshot, internName("statnobody"));
+    for(int i = 0; i < STAT_SNAPSHOT_SIZE; i++) ASSERT_EQUALS(0.0f, snapshot[i]);
+  }
+
+  //in a real game, as long as the window isn't full it must give the same as the stats of all deals
+  {
+    std::string filename = "unittest_statkeeper.hh";
+    std::remove(filename.c_str());
+    std::vector<std::string> names;
+    {
+      TestQuietHost host;
+      Game game(&host);
+      Rules rules;
+      rules.buyIn = 1000;
+      rules.smallBlind = 5;
+      rules.bigBlind = 10;
+      rules.allowRebuy = true;
+      rules.fixedNumberOfDeals = 90;
+      game.setRules(rules);
+      game.setShuffleMode(SHUFFLE_FAST, 7);
+      for(int i = 0; i < 4; i++)
+      {
+        names.push_back("stat" + valtostr(i));
+        AI* ai = i == 0 ? (AI*)new AIRandom() : i == 1 ? (AI*)new AICall() : i == 2 ? (AI*)new AISmart() : (AI*)new AIRaise();
+        game.addPlayer(Player(ai, names.back()));
+      }
+      game.addObserver(new ObserverHandHistory(filename));
+
+      std::streambuf* coutBuffer = std::cout.rdbuf(0); //the game prints the winner
+      game.doGame();
+      std::cout.rdbuf(coutBuffer);
+    }
+
+    HandHistoryFile history;
+    ASSERT_TRUE(history.open(filename));
+    std::vector<Event> events;
+    ASSERT_TRUE(history.getDeals(0, history.getNumDeals(), events));
+    StatKeeper keeper;
+    for(size_t i = 0; i < events.size(); i++) keeper.onEvent(events[i]);
+
+    for(size_t i = 0; i < names.size(); i++)
+    {
+      const PlayerStats* stats = keeper.getPlayerStats(names[i]);
+      WindowStats window;
+      ASSERT_TRUE(stats != 0);
+      ASSERT_TRUE(keeper.getWindowStats(window, names[i], NUM_STAT_WINDOWS - 1));
+      ASSERT_EQUALS(90, stats->deals);
+      ASSERT_EQUALS(stats->deals, window.deals);
+      ASSERT_EQUALS(stats->getVPIP(), window.vpip);
+      ASSERT_EQUALS(stats->getPFR(), window.pfr);
+      if(stats->flops_seen > 0) ASSERT_EQUALS(stats->getWSD(), window.wsd);
+      if(stats->calls > stats->preflop_calls) ASSERT_EQUALS(stats->getAF(), window.af);
+    }
+    std::remove(filename.c_str());
+  }
+
+  std::cout << std::endl;
+}
+
+void testHandHistory()
+{
+  std::cout << "Testing hand history" << std::endl;
+
+  //a few deals with every kind of event that a log has
+  std::vector<Event> events;
+  events.push_back(Event(E_JOIN, std::string("alice"), 1000));
+  events.push_back(Event(E_JOIN, std::string("bob, jr"), 1000)); //separator in the name
+  events.push_back(Event("The game begins.\nalice: AISmart\n\nbob, jr: AICall", E_LOG_MESSAGE));
+  for(int deal = 0; deal < 5; deal++)
+  {
+    events.push_back(Event(E_NEW_DEAL, 5, 10, deal));
+    events.push_back(Event(E_DEALER, std::string("alice")));
+    events.push_back(Event(E_SMALL_BLIND, std::string("alice"), 5));
+    events.push_back(Event(E_BIG_BLIND, std::string("bob, jr"), 10));
+    events.push_back(Event(E_RAISE, std::string("alice"), 20 + deal * 1000));
+    events.push_back(Event(E_CALL, std::string("bob, jr")));
+    events.push_back(Event(E_FLOP, Card("Ah"), Card("Kd"), Card("2c")));
+    events.push_back(Event(E_CHECK, std::string("bob, jr")));
+    events.push_back(Event(E_TURN, Card("Ah"), Card("Kd"), Card("2c"), Card("7s")));
+    events.push_back(Event(E_RIVER, Card("Ah"), Card("Kd"), Card("2c"), Card("7s"), Card("Th")));
+    Event pot(E_POT_DIVISION); pot.chips = 60;
+    events.push_back(pot);
+    events.push_back(Event(E_SHOWDOWN));
+    events.push_back(Event(E_PLAYER_SHOWDOWN, std::string("alice"), Card("As"), Card("Ac")));
+    events.push_back(Event(E_COMBINATION, std::string("alice"), Card("Ah"), Card("As"), Card("Ac"), Card("Kd"), Card("Th")));
+    events.push_back(Event(E_BOAST, std::string("bob, jr"), Card("3h"), Card("4h")));
+    events.push_back(Event(E_WIN, std::string("alice"), 60));
+  }
+  events.push_back(Event(E_REBUY, std::string("bob, jr"), 1000));
+  events.push_back(Event(E_TOURNAMENT_RANK, 2, -1000, std::string("bob, jr")));
+  events.push_back(Event(E_REVEAL_AI, std::string("bob, jr"), std::string("AICall")));
+  events.push_back(Event("damage", E_DEBUG_MESSAGE));
+
+  std::string text;
+  for(size_t i = 0; i < events.size(); i++) text += eventToString(events[i]) + "\n";
+
+  //every line that eventToString makes is parsed back to the same line, except the log message
+  for(size_t i = 0; i < events.size(); i++)
+  {
+    Event parsed(E_NUM_EVENTS);
+    bool isEvent = stringToEvent(parsed, eventToString(events[i]));
+    ASSERT_EQUALS(events[i].type != E_LOG_MESSAGE, isEvent);
+    if(isEvent) ASSERT_EQUALS(eventToString(events[i]), eventToString(parsed));
+  }
+
+  //blocks of 2 deals: the pre-game events and 5 deals give 3 blocks
+  std::string filename = "unittest_handhistory.hh";
+  std::remove(filename.c_str());
+  {
+    HandHistoryWriter writer;
+    ASSERT_TRUE(writer.open(filename));
+    writer.setBlockSize(2);
+    for(size_t i = 0; i < events.size(); i++) writer.add(events[i]);
+    ASSERT_TRUE(writer.flush());
+  }
+
+  HandHistoryFile history;
+  ASSERT_TRUE(history.open(filename));
+  ASSERT_EQUALS(6, history.getNumDeals());
+  ASSERT_EQUALS(events.size(), history.getNumEvents());
+  std::vector<Event> read;
+  ASSERT_TRUE(history.getDeals(0, 6, read));
+  ASSERT_EQUALS(events.size(), read.size());
+  for(size_t i = 0; i < events.size(); i++)
+  {
+    ASSERT_EQUALS(eventToString(events[i]), eventToString(read[i]));
+    ASSERT_EQUALS(events[i].playerId, read[i].playerId);
+  }
+  ASSERT_EQUALS(-1000, read[read.size() - 3].chips);
+  ASSERT_EQUALS(7, read[3 + 16 * 2 + 8].card4.getValue()); //turn of deal 3 keeps all board cards
+
+  //seeking straight to a deal
+  ASSERT_TRUE(history.getDeal(4, read));
+  ASSERT_EQUALS(16, read.size());
+  ASSERT_EQUALS(E_NEW_DEAL, read[0].type);
+  ASSERT_EQUALS(3, read[0].ante);
+  ASSERT_EQUALS(3020, read[4].chips);
+  ASSERT_TRUE(!history.getDeal(6, read));
+  history.close();
+
+  //a damaged block ends the file, the blocks before it can still be read
+  FILE* file = fopen(filename.c_str(), "r+b");
+  fseek(file, -3, SEEK_END);
+  fputc('X', file);
+  fclose(file);
+  ASSERT_TRUE(history.open(filename));
+  ASSERT_EQUALS(4, history.getNumDeals());
+  history.close();
+
+  //text to binary and back gives the same text
+  std::string textname = "unittest_handhistory.txt", textname2 = "unittest_handhistory2.txt";
+  file = fopen(textname.c_str(), "wb");
+  fwrite(text.c_str(), 1, text.size(), file);
+  fclose(file);
+  ASSERT_TRUE(convertTextToHandHistory(textname, filename));
+  ASSERT_TRUE(convertHandHistoryToText(filename, textname2));
+  std::ifstream in(textname2.c_str(), std::ios::binary);
+  std::string text2((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+  in.close();
+  ASSERT_EQUALS(text, text2);
+
+  std::remove(filename.c_str());
+  std::remove(textname.c_str());
+  std::remove(textname2.c_str());
+
+  std::cout << std::endl;
+}
+
+void testSPSCQueue()
+{
+  std::cout << "Testing SPSC queue" << std::endl;
+
+  SPSCQueue<int> queue(5);
+  ASSERT_EQUALS(8, queue.getCapacity());
+  ASSERT_TRUE(queue.front() == 0);
+  for(int i = 0; i < 8; i++) ASSERT_TRUE(queue.tryPush(i));
+  ASSERT_TRUE(!queue.tryPush(8));
+  ASSERT_EQUALS(8, queue.getSizeApprox());
+  for(int i = 0; i < 8; i++)
+  {
+    ASSERT_TRUE(queue.front() != 0);
+    ASSERT_EQUALS(i, *queue.front());
+    queue.pop();
+  }
+  ASSERT_TRUE(queue.front() == 0);
+
+  //one producer and one consumer thread: everything comes out once and in order
+  const int amount = 100000;
+  SPSCQueue<int> shared(64);
+  std::vector<int> received;
+  std::thread consumer([&shared, &received]()
+  {
+    while((int)received.size() < amount)
+    {
+      int* v = shared.front();
+      if(v) { received.push_back(*v); shared.pop(); }
+      else std::this_thread::yield();
+    }
+  });
+  for(int i = 0; i < amount; i++)
+  {
+    while(!shared.tryPush(i)) std::this_thread::yield();
+  }
+  consumer.join();
+  for(int i = 0; i < amount; i++) ASSERT_EQUALS(i, received[i]);
+
+  std::cout << std::endl;
+}
+
+void testObserverAsync()
+{
+  std::cout << "Testing async observer" << std::endl;
+
+  AsyncBackpressure modes[3] = { ASYNC_BLOCK, ASYNC_DROP, ASYNC_BUFFER };
+  for(int m = 0; m < 3; m++)
+  {
+    TestCountingObserver* counting = new TestCountingObserver();
+    ObserverAsync async(counting, modes[m], 4);
+    ASSERT_TRUE(async.getObserver() == counting);
+
+    //the wrapped observer is stuck, so the queue fills up
+    counting->hold = true;
+    std::thread release;
+    if(modes[m] == ASYNC_BLOCK)
+    {
+      release = std::thread([counting]()
+      {
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        counting->hold = false;
+      });
+    }
+    for(int i = 0; i < 100; i++)
+    {
+      Event event(E_WIN, std::string("alice"), i);
+      async.onEvent(event);
+    }
+    if(release.joinable()) release.join();
+    counting->hold = false;
+    async.flush();
+
+    if(modes[m] == ASYNC_DROP)
+    {
+      ASSERT_TRUE(async.getNumDropped() > 0);
+      ASSERT_EQUALS(100, counting->chips.size() + async.getNumDropped());
+    }
+    else
+    {
+      ASSERT_EQUALS(0, async.getNumDropped());
+      ASSERT_EQUALS(100, counting->chips.size());
+    }
+    for(size_t i = 1; i < counting->chips.size(); i++) ASSERT_TRUE(counting->chips[i - 1] < counting->chips[i]);
+  }
+
+  std::cout << std::endl;
+}
+
+void testEventRing()
+{
+  std::cout << "Testing event ring" << std::endl;
+
+  ASSERT_EQUALS(std::string("alice"), Event(E_FOLD, std::string("alice")).getPlayer());
+  ASSERT_EQUALS(std::string(""), Event(E_SHOWDOWN).getPlayer());
+  ASSERT_EQUALS(Event(E_CALL, std::string("bob")).playerId, Event(E_WIN, std::string("bob"), 10).playerId);
+
+  EventRing ring(3);
+  ASSERT_EQUALS((size_t)4, ring.getCapacity());
+
+  //pushing and sending many deals worth of events never needs more room
+  std::vector<Player> players;
+  std::vector<Observer*> observers;
+  size_t counter = 0;
+  for(int i = 0; i < 1000; i++)
+  {
+    ring.push(Event(E_WIN, std::string("alice"), i));
+    ring.push(Event(E_POT_DIVISION));
+    ASSERT_EQUALS(i, ring.get(ring.getBegin()).chips);
+    sendEventsToPlayers(counter, players, observers, ring);
+    ASSERT_EQUALS((size_t)0, ring.getSize());
+  }
+  ASSERT_EQUALS((size_t)2000, counter);
+  ASSERT_EQUALS((size_t)4, ring.getCapacity());
+
+  //more waiting events than the capacity grows the ring and keeps them all in order
+  for(int i = 0; i < 10; i++) ring.push(Event(E_RAISE, std::string("bob"), i));
+  ASSERT_EQUALS((size_t)16, ring.getCapacity());
+  for(size_t i = 0; i < 10; i++) ASSERT_EQUALS((int)i, ring.get(ring.getBegin() + i).chips);
+  ring.release(ring.getBegin() + 4);
+  ASSERT_EQUALS((size_t)6, ring.getSize());
+  ASSERT_EQUALS(std::string("bob"), ring.get(ring.getBegin()).getPlayer());
+  ring.clear();
+  ASSERT_EQUALS((size_t)0, ring.getEnd());
+
+  std::cout << std::endl;
+}
+
+void testInfoReuse()
+{
+  std::cout << "Testing info reuse" << std::endl;
+
+  ASSERT_EQUALS(internName("alice"), internName("alice"));
+  ASSERT_TRUE(internName("alice") != internName("bob"));
+  ASSERT_EQUALS(std::string("bob"), getInternedName(internName("bob")));
+
+  //names can be read while another thread adds more, also when that needs new chunks of the table
+  int first = internName("interned0");
+  std::thread adder([]() { for(int i = 1; i < 3000; i++) internName("interned" + valtostr(i)); });
+  for(int i = 0; i < 3000; i++) ASSERT_EQUALS(std::string("interned0"), getInternedName(first));
+  adder.join();
+  ASSERT_EQUALS(std::string("interned2999"), getInternedName(internName("interned2999")));
+
+  Table table;
+  table.players.push_back(Player(0, "alice"));
+  table.players.push_back(Player(0, "bob"));
+  table.players.push_back(Player(0, "carol"));
+  table.players[0].holeCard1 = Card("Ah"); table.players[0].holeCard2 = Card("Kh");
+  table.players[1].holeCard1 = Card("2c"); table.players[1].holeCard2 = Card("7d");
+  table.boardCard1 = Card("Qh"); table.boardCard2 = Card("Jh"); table.boardCard3 = Card("3s");
+  table.boardCard4 = Card("4s"); table.boardCard5 = Card("5s");
+  Rules rules;
+
+  //fill in the same Info for every round and viewpoint, the vectors must never be reallocated
+  Info info;
+  table.round = R_PRE_FLOP;
+  makeInfo(info, table, rules, 0);
+  const Card* boardData = info.boardCards.data();
+  const PlayerInfo* playersData = info.players.data();
+  const Card* holeData = info.players[1].holeCards.data();
+  for(int r = R_PRE_FLOP; r <= R_RIVER; r++)
+  for(int viewPoint = 0; viewPoint < 3; viewPoint++)
+  {
+    table.round = (Round)r;
+    makeInfo(info, table, rules, viewPoint);
+    ASSERT_EQUALS((size_t)(r == R_PRE_FLOP ? 0 : r + 2), info.boardCards.size());
+    ASSERT_TRUE(info.boardCards.data() == boardData);
+    ASSERT_TRUE(info.players.data() == playersData);
+    ASSERT_TRUE(info.players[1].holeCards.data() == holeData);
+    ASSERT_EQUALS(viewPoint == 1 ? (size_t)2 : (size_t)0, info.players[1].holeCards.size());
+    ASSERT_EQUALS(std::string("carol"), info.players[2].getName());
+  }
+  ASSERT_EQUALS(table.boardCard5.getIndex(), info.boardCards[4].getIndex());
+  ASSERT_EQUALS(table.players[2].holeCard1.getIndex(), info.getHoleCards()[0].getIndex());
+  ASSERT_EQUALS(std::string(""), PlayerInfo().getName());
+
+  std::cout << std::endl;
+}
+
 void testCardPrint() {
   std::cout << "Testing card print" << std::endl;
   std::cout << Card(2, S_CLUBS).getShortNamePrintable() << std::endl;
@@ -557,6 +1924,8 @@ void doUnitTest()
   std::cout << "Performing Unit Test" << std::endl << std::endl;
 
   testRandom();
+  testRandomStream();
+  testDeckShuffle();
 
   int dummy[7] = {1,1,1,1,1,1,1};
   eval7(dummy); //show its initialization messages before the unit test starts...
@@ -575,7 +1944,27 @@ void doUnitTest()
   testCombos();
   testCombosCompare();
 
+  testEval7Batch();
+  testParallelEquity();
+  testWinChanceKernel();
+  testHandRange();
+  testRiverRanker();
+  testLockFreeQueue();
+  testReplayBuffer();
+  testTrajectoryFile();
+  testIsomorphism();
+  testEquityCache();
+  testBuckets();
+  testInfoReuse();
+  testEventRing();
+  testSPSCQueue();
+  testObserverAsync();
+  testHandHistory();
+  testInfoKeeper();
+  testStatKeeper();
+
   benchmarkEval7();
+  benchmarkEval7Batch();
 
   testCardPrint();
 